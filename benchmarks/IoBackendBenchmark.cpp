@@ -0,0 +1,220 @@
+#include "core/GameServer.h"
+#include "utils/Logger.h"
+#include <poll.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Echo benchmark comparing the select() and io_uring event loops over loopback.
+// Every connection keeps one message in flight and measures its round trip.
+//
+// Usage: IoBackendBenchmark [--backend=select|io_uring|both] [--connections=N]
+//                           [--seconds=S] [--size=BYTES] [--threads=T]
+
+struct BenchConfig {
+    std::string backend = "both";
+    int connections = 64;
+    int seconds = 3;
+    int size = 64;
+    int threads = 2;
+};
+
+struct BenchResult {
+    uint64_t messages = 0;
+    std::vector<uint32_t> latenciesUs;
+};
+
+static int connectLoopback(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One loopback client with its message in flight
+struct ClientConnection {
+    int fd;
+    std::chrono::steady_clock::time_point sentAt;
+    int received;
+};
+
+// Blocking sockets, so a short write only happens when the connection failed
+static bool sendPayload(ClientConnection& conn, const std::string& payload) {
+    conn.sentAt = std::chrono::steady_clock::now();
+    conn.received = 0;
+    return write(conn.fd, payload.data(), payload.size()) == (ssize_t)payload.size();
+}
+
+static void clientThread(int port, int connections, int size, std::atomic<bool>& stop, BenchResult& result) {
+    using Clock = std::chrono::steady_clock;
+
+    std::string payload(size, 'x');
+    std::vector<ClientConnection> conns;
+    std::vector<struct pollfd> pfds;
+    for (int i = 0; i < connections; ++i) {
+        ClientConnection conn = {connectLoopback(port), Clock::time_point(), 0};
+        if (conn.fd < 0) {
+            continue;
+        }
+        struct pollfd pfd;
+        pfd.fd = conn.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (!sendPayload(conn, payload)) {
+            pfd.fd = -1;
+        }
+        conns.push_back(conn);
+        pfds.push_back(pfd);
+    }
+    std::string buffer(size, '\0');
+
+    while (!stop) {
+        int ready = poll(pfds.data(), pfds.size(), 100);
+        if (ready <= 0) {
+            continue;
+        }
+        for (size_t i = 0; i < pfds.size(); ++i) {
+            if (!(pfds[i].revents & POLLIN)) {
+                continue;
+            }
+            ClientConnection& conn = conns[i];
+            ssize_t n = read(conn.fd, &buffer[0], size - conn.received);
+            if (n <= 0) {
+                pfds[i].fd = -1;
+                continue;
+            }
+            conn.received += (int)n;
+            if (conn.received < size) {
+                continue;
+            }
+
+            auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - conn.sentAt).count();
+            result.latenciesUs.push_back((uint32_t)rtt);
+            result.messages++;
+
+            if (!sendPayload(conn, payload)) {
+                pfds[i].fd = -1;
+            }
+        }
+    }
+
+    for (const auto& conn : conns) {
+        close(conn.fd);
+    }
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(p * (sorted.size() - 1));
+    return sorted[index];
+}
+
+static bool runBenchmark(IoBackend backend, int port, const BenchConfig& config) {
+    std::unique_ptr<GameServer> server(new GameServer());
+    server->setIoBackend(backend);
+    if (!server->initialize(port)) {
+        std::cerr << "Failed to start server on port " << port << std::endl;
+        return false;
+    }
+    if (server->getIoBackend() != backend) {
+        std::cerr << GameServer::ioBackendToString(backend) << " backend unavailable, skipping" << std::endl;
+        return false;
+    }
+    std::thread serverThread([&server]() { server->run(); });
+
+    std::atomic<bool> stop(false);
+    std::vector<BenchResult> results(config.threads);
+    std::vector<std::thread> clients;
+    int perThread = std::max(1, config.connections / config.threads);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < config.threads; ++t) {
+        clients.emplace_back(clientThread, port, perThread, config.size,
+                             std::ref(stop), std::ref(results[t]));
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(config.seconds));
+    stop = true;
+    for (auto& client : clients) {
+        client.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    server->requestShutdown();
+    serverThread.join();
+
+    uint64_t messages = 0;
+    std::vector<uint32_t> latencies;
+    for (auto& result : results) {
+        messages += result.messages;
+        latencies.insert(latencies.end(), result.latenciesUs.begin(), result.latenciesUs.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%-10s %8d conns %12.0f msg/s   p50 %6u us   p99 %6u us   p999 %6u us\n",
+           GameServer::ioBackendToString(backend).c_str(),
+           perThread * config.threads,
+           messages / elapsed,
+           percentile(latencies, 0.50),
+           percentile(latencies, 0.99),
+           percentile(latencies, 0.999));
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.rfind("--backend=", 0) == 0) {
+            config.backend = value();
+        } else if (arg.rfind("--connections=", 0) == 0) {
+            config.connections = std::stoi(value());
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            config.seconds = std::stoi(value());
+        } else if (arg.rfind("--size=", 0) == 0) {
+            config.size = std::stoi(value());
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            config.threads = std::max(1, std::stoi(value()));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Per-message logging would dominate the measurement
+    Logger::getInstance().setLogLevel(Logger::Level::WARN);
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    printf("Echo benchmark: %d bytes per message, %d s per backend\n", config.size, config.seconds);
+
+    int port = 19500;
+    if (config.backend == "select" || config.backend == "both") {
+        runBenchmark(IoBackend::Select, port++, config);
+    }
+    if (config.backend == "io_uring" || config.backend == "both") {
+        runBenchmark(IoBackend::IoUring, port++, config);
+    }
+    return 0;
+}
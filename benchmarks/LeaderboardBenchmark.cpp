@@ -0,0 +1,109 @@
+#include "game/Leaderboard.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Leaderboard throughput on a board with millions of players, plus the cost
+// of the alternative: sorting every player again after each match.
+//
+// Usage: LeaderboardBenchmark [--players=N] [--operations=N]
+
+struct BenchConfig {
+    int players = 1000000;
+    int operations = 2000000;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const char* name, int operations, double seconds) {
+    printf("%-22s %12.0f ops/s   %8.3f us/op\n", name, operations / seconds, seconds * 1e6 / operations);
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.rfind("--players=", 0) == 0) {
+            config.players = std::max(1, std::stoi(value()));
+        } else if (arg.rfind("--operations=", 0) == 0) {
+            config.operations = std::max(1, std::stoi(value()));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    printf("Leaderboard benchmark: %d players, %d operations per test\n", config.players, config.operations);
+
+    std::mt19937 rng(42);
+    Leaderboard board;
+    auto start = Clock::now();
+    for (int id = 1; id <= config.players; ++id) {
+        board.setScore(id, (int64_t)(rng() % 5000));
+    }
+    report("insert", config.players, secondsSince(start));
+
+    std::vector<int> ids(config.operations);
+    for (auto& id : ids) {
+        id = (int)(rng() % config.players) + 1;
+    }
+
+    start = Clock::now();
+    for (int id : ids) {
+        board.addScore(id, (int64_t)(id % 7) - 2);
+    }
+    double updateSeconds = secondsSince(start);
+    report("update (addScore)", config.operations, updateSeconds);
+
+    start = Clock::now();
+    size_t checksum = 0;
+    for (int id : ids) {
+        checksum += board.getRank(id);
+    }
+    report("rank of player", config.operations, secondsSince(start));
+
+    int queries = std::max(1, config.operations / 10);
+    start = Clock::now();
+    for (int i = 0; i < queries; ++i) {
+        checksum += board.getTop(100).size();
+    }
+    report("top 100", queries, secondsSince(start));
+
+    start = Clock::now();
+    for (int i = 0; i < queries; ++i) {
+        checksum += board.getRange((size_t)(ids[i] % config.players) + 1, 20).size();
+    }
+    report("range of 20", queries, secondsSince(start));
+
+    start = Clock::now();
+    std::string snapshot = board.serialize();
+    double serializeSeconds = secondsSince(start);
+    printf("%-22s %12.1f ms        %8.1f MB\n", "snapshot", serializeSeconds * 1e3, snapshot.size() / 1e6);
+
+    // Baseline: re-rank everyone with a full sort, as done after every match
+    std::vector<std::pair<int64_t, int>> all;
+    all.reserve(config.players);
+    for (const auto& entry : board.getRange(1, config.players)) {
+        all.emplace_back(entry.score, entry.playerId);
+    }
+    std::shuffle(all.begin(), all.end(), rng);
+    start = Clock::now();
+    std::sort(all.begin(), all.end(), [](const std::pair<int64_t, int>& a, const std::pair<int64_t, int>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    double sortSeconds = secondsSince(start);
+    printf("%-22s %12.1f ms per re-rank (%.0fx one incremental update)\n", "full sort baseline",
+           sortSeconds * 1e3, sortSeconds / (updateSeconds / config.operations));
+
+    printf("checksum %zu\n", checksum);
+    return 0;
+}
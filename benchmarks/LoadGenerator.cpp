@@ -0,0 +1,448 @@
+#include "core/GameServer.h"
+#include "utils/Logger.h"
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load generator for GameServer over loopback.
+//
+// By default a GameServer is forked into a child process with --rooms rooms,
+// so its CPU use can be measured separately from the clients. Every simulated
+// client connects, sends "JOIN <room>", then sends fixed-size messages at
+// --rate per second. The server echoes them back and the client computes the
+// round trip from the timestamp carried in the payload, after a text prefix
+// byte so a payload never reads as anything but a text message.
+//
+// Usage: LoadGenerator [--connections=N] [--threads=T] [--rooms=R] [--rate=MSG_PER_SEC]
+//                      [--seconds=S] [--warmup=S] [--size=BYTES] [--port=P]
+//                      [--backend=select|io_uring] [--external [--server-pid=PID]]
+
+using Clock = std::chrono::steady_clock;
+
+// First byte of every payload; the timestamp follows it
+static const char PAYLOAD_PREFIX = 'T';
+static const size_t STAMP_OFFSET = 1;
+
+struct LoadConfig {
+    int connections = 1000;
+    int threads = 4;
+    int rooms = 50;
+    double rate = 10.0;
+    int seconds = 10;
+    int warmup = 2;
+    int size = 64;
+    int port = 19600;
+    std::string backend;
+    bool external = false;
+    int serverPid = 0;
+};
+
+struct ThreadStats {
+    int connected = 0;
+    int joined = 0;
+    int joinFailed = 0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    std::vector<uint32_t> latenciesUs;
+};
+
+enum class ClientState {
+    Joining,
+    Running,
+    Closed
+};
+
+struct Client {
+    int fd;
+    int roomId;
+    ClientState state;
+    std::string line;
+    std::vector<char> message;
+    int received;
+};
+
+static std::atomic<bool> g_stop(false);
+static std::atomic<bool> g_measuring(false);
+
+static int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+static int connectLoopback(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void onReadable(Client& client, const LoadConfig& config, ThreadStats& stats) {
+    char buffer[4096];
+    ssize_t n = read(client.fd, buffer, sizeof(buffer));
+    if (n <= 0) {
+        client.state = ClientState::Closed;
+        return;
+    }
+
+    size_t pos = 0;
+    if (client.state == ClientState::Joining) {
+        // Reply is a single "JOINED <id>\n" or "JOIN_FAILED <id>\n" line
+        while (pos < (size_t)n && client.state == ClientState::Joining) {
+            char c = buffer[pos++];
+            if (c != '\n') {
+                client.line.push_back(c);
+                continue;
+            }
+            if (client.line.rfind("JOINED", 0) == 0) {
+                stats.joined++;
+            } else {
+                stats.joinFailed++;
+            }
+            client.state = ClientState::Running;
+        }
+    }
+
+    // Everything after the join reply is echoed messages of config.size bytes
+    while (pos < (size_t)n) {
+        size_t take = std::min((size_t)(config.size - client.received), (size_t)n - pos);
+        memcpy(client.message.data() + client.received, buffer + pos, take);
+        client.received += (int)take;
+        pos += take;
+        if (client.received < config.size) {
+            break;
+        }
+        client.received = 0;
+
+        int64_t sentAt;
+        memcpy(&sentAt, client.message.data() + STAMP_OFFSET, sizeof(sentAt));
+        if (g_measuring) {
+            stats.received++;
+            stats.latenciesUs.push_back((uint32_t)((nowNanos() - sentAt) / 1000));
+        }
+    }
+}
+
+static void clientThread(const LoadConfig& config, int firstClient, int count, ThreadStats& stats) {
+    int epfd = epoll_create1(0);
+    std::vector<Client> clients;
+    clients.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        int fd = connectLoopback(config.port);
+        if (fd < 0) {
+            continue;
+        }
+        Client client;
+        client.fd = fd;
+        client.roomId = 1 + (firstClient + i) % std::max(1, config.rooms);
+        client.state = ClientState::Joining;
+        client.message.resize(config.size);
+        client.received = 0;
+        clients.push_back(std::move(client));
+        stats.connected++;
+    }
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, clients[i].fd, &ev);
+
+        std::string join = "JOIN " + std::to_string(clients[i].roomId) + "\n";
+        if (!writeAll(clients[i].fd, join.data(), join.size())) {
+            clients[i].state = ClientState::Closed;
+        }
+    }
+
+    // Open-loop schedule: messages go out at a fixed rate whether or not
+    // earlier ones have come back, so server stalls show up as latency.
+    std::vector<char> payload(config.size, 'x');
+    payload[0] = PAYLOAD_PREFIX;
+    double threadRate = config.rate * (double)std::max<size_t>(1, clients.size());
+    auto interval = std::chrono::nanoseconds((int64_t)(1e9 / threadRate));
+    auto nextSend = Clock::now();
+    size_t nextClient = 0;
+
+    std::vector<struct epoll_event> events(256);
+    while (!g_stop) {
+        auto now = Clock::now();
+        while (nextSend <= now && !clients.empty()) {
+            Client& client = clients[nextClient];
+            nextClient = (nextClient + 1) % clients.size();
+            nextSend += interval;
+            if (client.state != ClientState::Running) {
+                continue;
+            }
+            int64_t stamp = nowNanos();
+            memcpy(payload.data() + STAMP_OFFSET, &stamp, sizeof(stamp));
+            if (writeAll(client.fd, payload.data(), payload.size())) {
+                if (g_measuring) {
+                    stats.sent++;
+                }
+            } else {
+                client.state = ClientState::Closed;
+            }
+        }
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextSend - Clock::now()).count();
+        int timeout = (int)std::max<int64_t>(0, std::min<int64_t>(wait, 100));
+        int ready = epoll_wait(epfd, events.data(), (int)events.size(), timeout);
+        for (int i = 0; i < ready; ++i) {
+            Client& client = clients[events[i].data.u64];
+            if (client.state == ClientState::Closed) {
+                continue;
+            }
+            onReadable(client, config, stats);
+            if (client.state == ClientState::Closed) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, client.fd, nullptr);
+            }
+        }
+    }
+
+    for (auto& client : clients) {
+        close(client.fd);
+    }
+    close(epfd);
+}
+
+// utime + stime of a process in clock ticks, or -1 when unavailable
+static long readProcessCpuTicks(int pid) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string content;
+    if (!std::getline(stat, content)) {
+        return -1;
+    }
+    // Fields after the parenthesised command name start at field 3 (state)
+    size_t pos = content.rfind(')');
+    if (pos == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(content.substr(pos + 2));
+    std::string field;
+    long utime = 0;
+    long stime = 0;
+    for (int index = 3; fields >> field; ++index) {
+        if (index == 14) {
+            utime = std::stol(field);
+        } else if (index == 15) {
+            stime = std::stol(field);
+            return utime + stime;
+        }
+    }
+    return -1;
+}
+
+static int startServer(const LoadConfig& config) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return (int)pid;
+    }
+
+    // Child: run a GameServer with enough room capacity for every client
+    Logger::getInstance().setLogLevel(Logger::Level::WARN);
+    Logger::getInstance().setFileOutput(false);
+
+    GameServer server;
+    IoBackend backend = IoBackend::Select;
+    if (!config.backend.empty()) {
+        GameServer::parseIoBackend(config.backend, backend);
+    } else if (GameServer::isIoBackendAvailable(IoBackend::IoUring)) {
+        backend = IoBackend::IoUring;
+    }
+    server.setIoBackend(backend);
+
+    int perRoom = config.connections / std::max(1, config.rooms) + 1;
+    for (int i = 0; i < config.rooms; ++i) {
+        server.createRoom("load-" + std::to_string(i + 1), perRoom);
+    }
+    if (!server.initialize(config.port)) {
+        _exit(1);
+    }
+    server.run();
+    _exit(0);
+}
+
+static bool waitForServer(int port) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd = connectLoopback(port);
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[(size_t)(p * (sorted.size() - 1))];
+}
+
+static bool parseArgs(int argc, char* argv[], LoadConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = arg.find('=') != std::string::npos ? arg.substr(arg.find('=') + 1) : "";
+        if (arg.rfind("--connections=", 0) == 0) {
+            config.connections = std::stoi(value);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            config.threads = std::max(1, std::stoi(value));
+        } else if (arg.rfind("--rooms=", 0) == 0) {
+            config.rooms = std::max(1, std::stoi(value));
+        } else if (arg.rfind("--rate=", 0) == 0) {
+            config.rate = std::stod(value);
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            config.seconds = std::stoi(value);
+        } else if (arg.rfind("--warmup=", 0) == 0) {
+            config.warmup = std::stoi(value);
+        } else if (arg.rfind("--size=", 0) == 0) {
+            config.size = std::max((int)(STAMP_OFFSET + sizeof(int64_t)), std::stoi(value));
+        } else if (arg.rfind("--port=", 0) == 0) {
+            config.port = std::stoi(value);
+        } else if (arg.rfind("--backend=", 0) == 0) {
+            config.backend = value;
+        } else if (arg == "--external") {
+            config.external = true;
+        } else if (arg.rfind("--server-pid=", 0) == 0) {
+            config.serverPid = std::stoi(value);
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        return 1;
+    }
+    if (config.rate <= 0) {
+        std::cerr << "--rate must be positive" << std::endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    int serverPid = config.serverPid;
+    if (!config.external) {
+        serverPid = startServer(config);
+        if (serverPid < 0) {
+            std::cerr << "fork failed" << std::endl;
+            return 1;
+        }
+    }
+    if (!waitForServer(config.port)) {
+        std::cerr << "Server did not come up on port " << config.port << std::endl;
+        if (!config.external) {
+            kill(serverPid, SIGKILL);
+            waitpid(serverPid, nullptr, 0);
+        }
+        return 1;
+    }
+
+    printf("Load: %d connections, %d threads, %d rooms, %.1f msg/s per connection, %d byte messages\n",
+           config.connections, config.threads, config.rooms, config.rate, config.size);
+
+    std::vector<ThreadStats> stats(config.threads);
+    std::vector<std::thread> threads;
+    int perThread = config.connections / config.threads;
+    int remainder = config.connections % config.threads;
+    int first = 0;
+    for (int t = 0; t < config.threads; ++t) {
+        int count = perThread + (t < remainder ? 1 : 0);
+        threads.emplace_back(clientThread, std::cref(config), first, count, std::ref(stats[t]));
+        first += count;
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(config.warmup));
+
+    long cpuStart = serverPid > 0 ? readProcessCpuTicks(serverPid) : -1;
+    auto start = Clock::now();
+    g_measuring = true;
+    std::this_thread::sleep_for(std::chrono::seconds(config.seconds));
+    g_measuring = false;
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    long cpuEnd = serverPid > 0 ? readProcessCpuTicks(serverPid) : -1;
+
+    // Stop the server first so client disconnects are not logged as errors
+    if (!config.external) {
+        kill(serverPid, SIGKILL);
+        waitpid(serverPid, nullptr, 0);
+    }
+    g_stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ThreadStats total;
+    for (auto& s : stats) {
+        total.connected += s.connected;
+        total.joined += s.joined;
+        total.joinFailed += s.joinFailed;
+        total.sent += s.sent;
+        total.received += s.received;
+        total.latenciesUs.insert(total.latenciesUs.end(), s.latenciesUs.begin(), s.latenciesUs.end());
+    }
+    std::sort(total.latenciesUs.begin(), total.latenciesUs.end());
+
+    printf("Connections:  %d established, %d joined, %d join failures\n",
+           total.connected, total.joined, total.joinFailed);
+    printf("Throughput:   %.0f msg/s sent, %.0f msg/s received, %.2f MB/s echoed\n",
+           total.sent / elapsed, total.received / elapsed,
+           total.received * (double)config.size / elapsed / (1024.0 * 1024.0));
+    printf("RTT (us):     p50 %u   p99 %u   p999 %u   max %u\n",
+           percentile(total.latenciesUs, 0.50),
+           percentile(total.latenciesUs, 0.99),
+           percentile(total.latenciesUs, 0.999),
+           total.latenciesUs.empty() ? 0 : total.latenciesUs.back());
+    if (cpuStart >= 0 && cpuEnd >= 0) {
+        double cpuSeconds = (double)(cpuEnd - cpuStart) / (double)sysconf(_SC_CLK_TCK);
+        printf("Server CPU:   %.1f%% of one core\n", 100.0 * cpuSeconds / elapsed);
+    } else {
+        printf("Server CPU:   n/a (pass --server-pid for an external server)\n");
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+#include "protocol/GameProtocol.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Generated binary codecs against a JSON encoding of the same messages:
+// size on the wire and encode/decode throughput. The JSON side is a
+// hand-written, schema-aware codec on a reused buffer, i.e. about as fast as
+// JSON gets without a code generator of its own.
+//
+// Usage: ProtocolBenchmark [--iterations=N] [--entities=N]
+
+struct BenchConfig {
+    int iterations = 1000000;
+    int entities = 32;
+};
+
+using Clock = std::chrono::steady_clock;
+using namespace protocol;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const char* name, int operations, size_t bytes, double seconds) {
+    printf("%-30s %12.0f msg/s %10.1f MB/s   %8.1f ns/msg\n", name, operations / seconds,
+           (double)bytes * operations / seconds / 1e6, seconds * 1e9 / operations);
+}
+
+// --- JSON baseline ---
+
+static void appendInt(std::string& out, int64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+static void appendField(std::string& out, const char* key, int64_t value, bool first = false) {
+    out += first ? "{\"" : ",\"";
+    out += key;
+    out += "\":";
+    appendInt(out, value);
+}
+
+static void appendBool(std::string& out, const char* key, bool value) {
+    out += ",\"";
+    out += key;
+    out += value ? "\":true" : "\":false";
+}
+
+static void appendVec2(std::string& out, const char* key, const Vec2& value) {
+    out += ",\"";
+    out += key;
+    out += "\":{\"x\":";
+    appendInt(out, value.x);
+    out += ",\"y\":";
+    appendInt(out, value.y);
+    out += "}";
+}
+
+static void encodeJson(const PlayerInput& m, std::string& out) {
+    out.clear();
+    appendField(out, "tick", m.tick, true);
+    appendBool(out, "moveUp", m.moveUp);
+    appendBool(out, "moveDown", m.moveDown);
+    appendBool(out, "moveLeft", m.moveLeft);
+    appendBool(out, "moveRight", m.moveRight);
+    appendBool(out, "fire", m.fire);
+    appendBool(out, "jump", m.jump);
+    appendField(out, "aim", (int64_t)m.aim);
+    appendField(out, "weapon", (int64_t)m.weapon);
+    out += "}";
+}
+
+static void encodeJson(const Snapshot& m, std::string& out) {
+    out.clear();
+    appendField(out, "tick", m.tick, true);
+    appendField(out, "lastInputTick", m.lastInputTick);
+    out += ",\"entities\":[";
+    for (size_t i = 0; i < m.entities.size(); ++i) {
+        const EntityState& entity = m.entities[i];
+        if (i) {
+            out += ",";
+        }
+        appendField(out, "entityId", entity.entityId, true);
+        appendVec2(out, "position", entity.position);
+        appendVec2(out, "velocity", entity.velocity);
+        appendField(out, "health", (int64_t)entity.health);
+        appendField(out, "animation", (int64_t)entity.animation);
+        appendBool(out, "alive", entity.alive);
+        out += "}";
+    }
+    out += "]}";
+}
+
+class JsonCursor {
+public:
+    JsonCursor(const char* data, size_t len) : pos(data), limit(data + len) {}
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos == limit || *pos != c) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+    bool key(const char*& start, size_t& len) {
+        if (!consume('"')) {
+            return false;
+        }
+        start = pos;
+        const char* quote = (const char*)memchr(pos, '"', (size_t)(limit - pos));
+        if (!quote) {
+            return false;
+        }
+        len = (size_t)(quote - start);
+        pos = quote + 1;
+        return consume(':');
+    }
+    template <typename T>
+    bool number(T& value) {
+        skipSpace();
+        int64_t parsed;
+        auto result = std::from_chars(pos, limit, parsed);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        pos = result.ptr;
+        value = (T)parsed;
+        return true;
+    }
+    bool boolean(bool& value) {
+        skipSpace();
+        if (limit - pos >= 4 && memcmp(pos, "true", 4) == 0) {
+            value = true;
+            pos += 4;
+            return true;
+        }
+        if (limit - pos >= 5 && memcmp(pos, "false", 5) == 0) {
+            value = false;
+            pos += 5;
+            return true;
+        }
+        return false;
+    }
+
+    // Calls onField(key, len) for every member; onField parses the value
+    template <typename F>
+    bool object(F&& onField) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            const char* name;
+            size_t len;
+            if (!key(name, len) || !onField(name, len)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+private:
+    void skipSpace() {
+        while (pos != limit && (*pos == ' ' || *pos == '\n' || *pos == '\t' || *pos == '\r')) {
+            ++pos;
+        }
+    }
+
+    const char* pos;
+    const char* limit;
+};
+
+static bool is(const char* name, size_t len, const char* expected) {
+    return strlen(expected) == len && memcmp(name, expected, len) == 0;
+}
+
+static bool decodeJson(JsonCursor& json, Vec2& m) {
+    return json.object([&](const char* name, size_t len) {
+        if (is(name, len, "x")) {
+            return json.number(m.x);
+        }
+        if (is(name, len, "y")) {
+            return json.number(m.y);
+        }
+        return false;
+    });
+}
+
+static bool decodeJson(const std::string& text, PlayerInput& m) {
+    JsonCursor json(text.data(), text.size());
+    return json.object([&](const char* name, size_t len) {
+        if (is(name, len, "tick")) return json.number(m.tick);
+        if (is(name, len, "moveUp")) return json.boolean(m.moveUp);
+        if (is(name, len, "moveDown")) return json.boolean(m.moveDown);
+        if (is(name, len, "moveLeft")) return json.boolean(m.moveLeft);
+        if (is(name, len, "moveRight")) return json.boolean(m.moveRight);
+        if (is(name, len, "fire")) return json.boolean(m.fire);
+        if (is(name, len, "jump")) return json.boolean(m.jump);
+        if (is(name, len, "aim")) return json.number(m.aim);
+        if (is(name, len, "weapon")) return json.number(m.weapon);
+        return false;
+    });
+}
+
+static bool decodeJson(const std::string& text, Snapshot& m) {
+    JsonCursor json(text.data(), text.size());
+    return json.object([&](const char* name, size_t len) {
+        if (is(name, len, "tick")) return json.number(m.tick);
+        if (is(name, len, "lastInputTick")) return json.number(m.lastInputTick);
+        if (!is(name, len, "entities") || !json.consume('[')) {
+            return false;
+        }
+        m.entities.clear();
+        if (json.consume(']')) {
+            return true;
+        }
+        do {
+            EntityState entity;
+            bool parsed = json.object([&](const char* field, size_t fieldLen) {
+                if (is(field, fieldLen, "entityId")) return json.number(entity.entityId);
+                if (is(field, fieldLen, "position")) return decodeJson(json, entity.position);
+                if (is(field, fieldLen, "velocity")) return decodeJson(json, entity.velocity);
+                if (is(field, fieldLen, "health")) return json.number(entity.health);
+                if (is(field, fieldLen, "animation")) return json.number(entity.animation);
+                if (is(field, fieldLen, "alive")) return json.boolean(entity.alive);
+                return false;
+            });
+            if (!parsed || !m.entities.push_back(entity)) {
+                return false;
+            }
+        } while (json.consume(','));
+        return json.consume(']');
+    });
+}
+
+// --- Benchmark ---
+
+template <typename Message>
+static bool bench(const char* name, const Message& message, int iterations) {
+    uint8_t frame[Message::MAX_FRAME_SIZE];
+    std::string json;
+    Message decoded;
+    uint64_t checksum = 0;
+
+    size_t binarySize = encodeMessage(message, frame, sizeof(frame));
+    encodeJson(message, json);
+    if (!binarySize || !decodeMessage(frame, binarySize, decoded) || !decodeJson(json, decoded)) {
+        std::cerr << name << ": round trip failed" << std::endl;
+        return false;
+    }
+    printf("\n%s: binary %zu bytes, JSON %zu bytes (%.1fx smaller)\n", name, binarySize, json.size(),
+           (double)json.size() / binarySize);
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += encodeMessage(message, frame, sizeof(frame));
+    }
+    double binaryEncode = secondsSince(start);
+    report("  binary encode", iterations, binarySize, binaryEncode);
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += decodeMessage(frame, binarySize, decoded);
+    }
+    double binaryDecode = secondsSince(start);
+    report("  binary decode", iterations, binarySize, binaryDecode);
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        encodeJson(message, json);
+        checksum += json.size();
+    }
+    double jsonEncode = secondsSince(start);
+    report("  JSON encode", iterations, json.size(), jsonEncode);
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += decodeJson(json, decoded);
+    }
+    double jsonDecode = secondsSince(start);
+    report("  JSON decode", iterations, json.size(), jsonDecode);
+
+    printf("  speedup: encode %.1fx, decode %.1fx (checksum %llu)\n", jsonEncode / binaryEncode,
+           jsonDecode / binaryDecode, (unsigned long long)checksum);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.rfind("--iterations=", 0) == 0) {
+            config.iterations = std::max(1, std::stoi(value()));
+        } else if (arg.rfind("--entities=", 0) == 0) {
+            config.entities = std::min((int)Snapshot().entities.capacity(), std::max(0, std::stoi(value())));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    printf("Protocol benchmark: %d iterations, %d entities per snapshot\n", config.iterations, config.entities);
+
+    PlayerInput input;
+    input.tick = 48213;
+    input.moveUp = true;
+    input.fire = true;
+    input.aim = 700;
+    input.weapon = 3;
+    if (!bench("PlayerInput", input, config.iterations)) {
+        return 1;
+    }
+
+    Snapshot snapshot;
+    snapshot.tick = 48220;
+    snapshot.lastInputTick = 48213;
+    for (int i = 0; i < config.entities; ++i) {
+        EntityState entity;
+        entity.entityId = 1000 + i;
+        entity.position.x = i * 731 - 12000;
+        entity.position.y = 8000 - i * 517;
+        entity.velocity.x = (i % 5) * 40 - 80;
+        entity.velocity.y = (i % 3) * 25;
+        entity.health = 100 - i;
+        entity.animation = i % 8;
+        entity.alive = i % 7 != 0;
+        snapshot.entities.push_back(entity);
+    }
+    // Snapshots are larger, so fewer of them keep the run time similar
+    return bench("Snapshot", snapshot, std::max(1, config.iterations / config.entities)) ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include "core/GameServer.h"
+#include "core/TlsContext.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include <openssl/ssl.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// TLS cost over loopback against the select() backend:
+//   - full and resumed (session ticket) handshakes per second
+//   - echo throughput with and without TLS
+//
+// Usage: TlsBenchmark [--handshakes=N] [--megabytes=N] [--size=BYTES] [--ktls=on|off]
+
+struct BenchConfig {
+    int handshakes = 2000;
+    int megabytes = 256;
+    // One message in flight, like a client waiting for its reply. Kept below
+    // the server's 1 KB read size so every message comes back in one piece.
+    int size = 1000;
+    bool kernelOffload = true;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static int connectLoopback(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Connects and handshakes; with a session the client offers its ticket
+static SSL* connectTls(SSL_CTX* ctx, int port, SSL_SESSION* session) {
+    int fd = connectLoopback(port);
+    if (fd < 0) {
+        return nullptr;
+    }
+    SSL* ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    if (session) {
+        SSL_set_session(ssl, session);
+    }
+    if (SSL_connect(ssl) != 1) {
+        SSL_free(ssl);
+        close(fd);
+        return nullptr;
+    }
+    return ssl;
+}
+
+static void closeTls(SSL* ssl) {
+    int fd = SSL_get_fd(ssl);
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(fd);
+}
+
+// One echo round trip, which also makes the client process the session ticket
+static bool pingTls(SSL* ssl) {
+    char buffer[16];
+    return SSL_write(ssl, "ping", 4) == 4 && SSL_read(ssl, buffer, sizeof(buffer)) > 0;
+}
+
+static bool benchHandshakes(SSL_CTX* ctx, int port, int count, bool resume) {
+    SSL_SESSION* session = nullptr;
+    if (resume) {
+        SSL* first = connectTls(ctx, port, nullptr);
+        if (!first || !pingTls(first)) {
+            std::cerr << "Cannot get a session ticket" << std::endl;
+            return false;
+        }
+        session = SSL_get1_session(first);
+        closeTls(first);
+    }
+
+    int resumed = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        SSL* ssl = connectTls(ctx, port, session);
+        if (!ssl) {
+            std::cerr << "Handshake failed" << std::endl;
+            SSL_SESSION_free(session);
+            return false;
+        }
+        resumed += SSL_session_reused(ssl);
+        closeTls(ssl);
+    }
+    double elapsed = secondsSince(start);
+    SSL_SESSION_free(session);
+
+    printf("%-24s %10.0f handshakes/s %8.1f us each   (%d of %d resumed)\n",
+           resume ? "resumed handshake" : "full handshake", count / elapsed, elapsed * 1e6 / count, resumed,
+           count);
+    return true;
+}
+
+// Writes a message, reads the echo back, until total bytes went both ways.
+// send/recv are the plaintext or the TLS calls.
+template <typename Send, typename Recv>
+static double echoThroughput(size_t total, size_t size, Send sendBytes, Recv recvBytes) {
+    std::string out(size, 'x');
+    std::string in(size, '\0');
+    size_t done = 0;
+    auto start = Clock::now();
+    while (done < total) {
+        size_t sent = 0;
+        while (sent < size) {
+            long n = sendBytes(out.data() + sent, size - sent);
+            if (n <= 0) {
+                return 0;
+            }
+            sent += (size_t)n;
+        }
+        size_t received = 0;
+        while (received < size) {
+            long n = recvBytes(&in[0], size - received);
+            if (n <= 0) {
+                return 0;
+            }
+            received += (size_t)n;
+        }
+        done += size;
+    }
+    return (double)done / secondsSince(start) / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.rfind("--handshakes=", 0) == 0) {
+            config.handshakes = std::max(1, std::stoi(value()));
+        } else if (arg.rfind("--megabytes=", 0) == 0) {
+            config.megabytes = std::max(1, std::stoi(value()));
+        } else if (arg.rfind("--size=", 0) == 0) {
+            config.size = std::max(1, std::stoi(value()));
+        } else if (arg.rfind("--ktls=", 0) == 0) {
+            config.kernelOffload = value() != "off";
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Per-connection logging would dominate the measurement
+    Logger::getInstance().setLogLevel(Logger::Level::WARN);
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    const int plainPort = 19640;
+    const int tlsPort = 19641;
+    TlsConfig tlsConfig;
+    tlsConfig.kernelOffload = config.kernelOffload;
+    GameServer plainServer;
+    GameServer tlsServer;
+    if (!tlsServer.enableTls(tlsConfig) || !plainServer.initialize(plainPort) || !tlsServer.initialize(tlsPort)) {
+        std::cerr << "Cannot start the servers" << std::endl;
+        return 1;
+    }
+    std::thread plainThread([&plainServer]() { plainServer.run(); });
+    std::thread tlsThread([&tlsServer]() { tlsServer.run(); });
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    if (!config.kernelOffload) {
+        SSL_CTX_clear_options(ctx, SSL_OP_ENABLE_KTLS);
+    } else {
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+
+    printf("TLS benchmark: %d handshakes, %d MB echoed in %d byte messages, kTLS %s\n\n", config.handshakes,
+           config.megabytes, config.size, config.kernelOffload ? "requested" : "off");
+
+    bool ok = benchHandshakes(ctx, tlsPort, config.handshakes, false) &&
+              benchHandshakes(ctx, tlsPort, config.handshakes, true);
+
+    size_t total = (size_t)config.megabytes * 1024 * 1024;
+    size_t size = (size_t)config.size;
+    int plain = connectLoopback(plainPort);
+    double plainRate = plain < 0 ? 0 : echoThroughput(total, size,
+        [plain](const char* data, size_t len) { return (long)send(plain, data, len, MSG_NOSIGNAL); },
+        [plain](char* data, size_t len) { return (long)recv(plain, data, len, 0); });
+    if (plain >= 0) {
+        close(plain);
+    }
+
+    SSL* ssl = connectTls(ctx, tlsPort, nullptr);
+    bool clientKtls = ssl && BIO_get_ktls_send(SSL_get_wbio(ssl));
+    double tlsRate = !ssl ? 0 : echoThroughput(total, size,
+        [ssl](const char* data, size_t len) { return (long)SSL_write(ssl, data, (int)len); },
+        [ssl](char* data, size_t len) { return (long)SSL_read(ssl, data, (int)len); });
+    if (ssl) {
+        printf("cipher %s, %s\n", SSL_get_cipher(ssl), SSL_get_version(ssl));
+        closeTls(ssl);
+    }
+    ok = ok && plainRate > 0 && tlsRate > 0;
+
+    uint64_t serverKtls = MetricsRegistry::getInstance().counter("gameserver_tls_ktls_total").value();
+    printf("%-24s %10.1f MB/s\n", "plaintext echo", plainRate);
+    printf("%-24s %10.1f MB/s   (%.0f%% of plaintext)\n", "TLS echo", tlsRate,
+           plainRate > 0 ? tlsRate * 100 / plainRate : 0.0);
+    printf("kernel TLS send: server %llu connections, client %s\n", (unsigned long long)serverKtls,
+           clientKtls ? "yes" : "no");
+
+    SSL_CTX_free(ctx);
+    plainServer.requestShutdown();
+    tlsServer.requestShutdown();
+    plainThread.join();
+    tlsThread.join();
+    return ok ? 0 : 1;
+}
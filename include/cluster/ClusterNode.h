@@ -0,0 +1,36 @@
+#ifndef CLUSTERNODE_H
+#define CLUSTERNODE_H
+
+#include "cluster/ControlChannel.h"
+#include <string>
+
+class GameServer;
+
+// Node side of a cluster: answers the router's control requests for one
+// GameServer.
+//
+//   PING                 -> "pong"
+//   ROOMS                -> room ids, one per line
+//   EXPORT <roomId>      -> a copy of the room as state records
+//   IMPORT + records     -> number of rooms added
+//   DROP <roomId>        -> "dropped"; the room is removed
+class ClusterNode {
+public:
+    explicit ClusterNode(GameServer& server);
+    ~ClusterNode();
+
+    bool start(int controlPort);
+    void stop();
+    int getControlPort() const { return control.getPort(); }
+
+private:
+    ClusterNode(const ClusterNode&) = delete;
+    ClusterNode& operator=(const ClusterNode&) = delete;
+
+    bool handle(const std::string& command, const std::string& payload, std::string& response);
+
+    GameServer& server;
+    ControlServer control;
+};
+
+#endif // CLUSTERNODE_H
@@ -0,0 +1,122 @@
+#ifndef CLUSTERROUTER_H
+#define CLUSTERROUTER_H
+
+#include "cluster/ControlChannel.h"
+#include "cluster/HashRing.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Gateway in front of a cluster of GameServer nodes.
+//
+// Clients connect to the router and speak the normal game protocol. Each
+// client session is forwarded to one node: the owner of its room on the hash
+// ring once it sends "JOIN <roomId>" or "SPECTATE <roomId>", a fixed lobby
+// node before that.
+//
+// When a node is added or removed, every room whose owner changed is moved:
+// EXPORT a copy from the old node, IMPORT it into the new one, then DROP it
+// on the old node. A room is never only in flight; if a step fails it stays
+// where it was. Sessions in a moved room are reconnected to the new owner
+// and rejoined with a JOIN or SPECTATE whose reply the router swallows, so a
+// player only sees its player id change and a spectator its stream restart
+// at a keyframe. A session that switched to binary frames is switched again
+// on the new node, and frames only ever go out whole in either direction, so
+// none is split across two nodes. Nodes must be reachable before they are removed, and must
+// run on the router's host: control channels only listen on 127.0.0.1.
+//
+// Operator commands on the control port (see ControlChannel.h):
+//   NODES, ROOMS, ADD_NODE <name@host:gamePort:controlPort>,
+//   REMOVE_NODE <name>, CREATE_ROOM <maxPlayers> <name>, REBALANCE
+class ClusterRouter {
+public:
+    ClusterRouter();
+    ~ClusterRouter();
+
+    // Port 0 picks a free port; controlPort -1 disables the control channel
+    bool start(int clientPort, int controlPort);
+    void stop();
+    int getClientPort() const { return clientPort; }
+    int getControlPort() const { return control.getPort(); }
+
+    // Usable before start() to seed the ring. Once running, these run on the
+    // router thread and return after rooms and sessions have moved.
+    bool addNode(const ClusterNodeInfo& node, std::string& error);
+    bool removeNode(const std::string& name, std::string& error);
+    // Allocates a cluster-wide room id and creates the room on its owner; 0 on failure
+    int createRoom(const std::string& name, int maxPlayers);
+    // Moves every room that is not on its owner
+    bool rebalance();
+
+    std::vector<ClusterNodeInfo> getNodes();
+    // "<roomId> <node>" per line
+    std::string describeRooms();
+    size_t getSessionCount() const { return sessionCount; }
+
+private:
+    ClusterRouter(const ClusterRouter&) = delete;
+    ClusterRouter& operator=(const ClusterRouter&) = delete;
+
+    struct Session {
+        int clientFd;
+        int upstreamFd;             // -1 until the first message
+        std::string node;
+        int roomId;                 // 0 in the lobby
+        bool spectating;            // watching roomId rather than seated in it
+        bool binary;                // sent BINARY: its input is frames, not commands
+        std::string toClient;
+        std::string toUpstream;
+        std::string partialFrame;   // spectators and binary: start of a frame from the node
+        std::string partialInput;   // binary: client frames not yet forwarded
+        bool swallowReply;          // drop the reply to a JOIN or SPECTATE sent on the client's behalf
+        std::string replyLine;
+    };
+
+    void run();
+    void runOnLoop(const std::function<void()>& task);
+    void runQueuedTasks();
+    bool handleControl(const std::string& command, const std::string& payload, std::string& response);
+
+    void acceptClients();
+    void onClientReadable(Session& session);
+    void onUpstreamReadable(Session& session);
+    bool flushSession(Session& session);
+    // Moves whole frames from partialInput to toUpstream
+    void forwardFrames(Session& session);
+    bool attach(Session& session, const ClusterNodeInfo& node);
+    void closeSession(int clientFd);
+
+    const ClusterNodeInfo* nodeForRoom(int roomId);
+    ControlClient& controlFor(const ClusterNodeInfo& node);
+    bool rebalanceFrom(const std::vector<ClusterNodeInfo>& sources);
+    bool migrateRoom(int roomId, const ClusterNodeInfo& from, const ClusterNodeInfo& to);
+    void rehomeSessions();
+
+    // Router thread state, also touched before start() and after stop()
+    HashRing ring;
+    std::map<int, std::string> roomNodes;       // where each known room lives
+    int maxRoomId;
+    std::map<int, Session> sessions;            // by client fd
+    std::map<std::string, std::unique_ptr<ControlClient>> controls;
+
+    int listenFd;
+    int clientPort;
+    int wakeReadFd;
+    int wakeWriteFd;
+    std::atomic<size_t> sessionCount;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    std::mutex tasksMutex;
+    std::deque<std::function<void()>> tasks;
+
+    ControlServer control;
+};
+
+#endif // CLUSTERROUTER_H
@@ -0,0 +1,71 @@
+#ifndef CONTROLCHANNEL_H
+#define CONTROLCHANNEL_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Request/response channel between the cluster router and its nodes, and
+// between an operator and the router. TCP on 127.0.0.1, no authentication.
+//
+//   request:   <command line>\n<payload length>\n<payload>
+//   response:  OK|ERR\n<payload length>\n<payload>
+//
+// so `printf 'ROOMS\n0\n' | nc 127.0.0.1 <port>` works by hand.
+
+// Runs the handler for each request on its own thread, one request at a time
+class ControlServer {
+public:
+    // Return false to answer ERR with response as the message
+    using Handler = std::function<bool(const std::string& command, const std::string& payload,
+                                       std::string& response)>;
+    ControlServer();
+    ~ControlServer();
+
+    // Port 0 picks a free port, see getPort()
+    bool start(int port, Handler handler);
+    void stop();
+
+    int getPort() const { return boundPort; }
+    bool isRunning() const { return running; }
+
+private:
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    void serve();
+    bool handleRequest(int connection);
+
+    Handler onRequest;
+    int listenFd;
+    int boundPort;
+    std::vector<int> connections;
+    std::atomic<bool> running;
+    std::thread worker;
+};
+
+// Blocking client; reconnects on the next request after an I/O error
+class ControlClient {
+public:
+    ControlClient();
+    ~ControlClient();
+
+    void setAddress(const std::string& host, int port);
+    // True for OK. On ERR or an I/O error response holds the reason.
+    bool request(const std::string& command, const std::string& payload, std::string& response);
+    void close();
+
+private:
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    bool connect();
+
+    std::string host;
+    int port;
+    int fd;
+};
+
+#endif // CONTROLCHANNEL_H
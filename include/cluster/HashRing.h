@@ -0,0 +1,52 @@
+#ifndef HASHRING_H
+#define HASHRING_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// One GameServer process in a cluster
+struct ClusterNodeInfo {
+    std::string name;
+    std::string host;
+    int gamePort;       // where the router forwards client sessions
+    int controlPort;    // ClusterNode control channel
+
+    ClusterNodeInfo() : gamePort(0), controlPort(0) {}
+};
+
+// "<name>@<host>:<gamePort>:<controlPort>", e.g. "a@127.0.0.1:8001:9201"
+bool parseClusterNode(const std::string& spec, ClusterNodeInfo& node);
+std::string formatClusterNode(const ClusterNodeInfo& node);
+
+// Consistent hashing of rooms onto nodes. Each node owns many points on a
+// 64-bit ring and a room belongs to the first point at or after its hash,
+// so adding or removing a node only moves the rooms next to its points,
+// about 1/N of them. Not thread-safe.
+class HashRing {
+public:
+    explicit HashRing(int virtualNodes = 128);
+
+    bool addNode(const ClusterNodeInfo& node);
+    bool removeNode(const std::string& name);
+
+    // nullptr while the ring is empty
+    const ClusterNodeInfo* ownerOfRoom(int roomId) const;
+    const ClusterNodeInfo* ownerOfKey(const std::string& key) const;
+    const ClusterNodeInfo* findNode(const std::string& name) const;
+
+    std::vector<ClusterNodeInfo> getNodes() const;
+    size_t size() const { return nodes.size(); }
+
+    static uint64_t hash(const std::string& key);
+
+private:
+    const ClusterNodeInfo* ownerOfHash(uint64_t point) const;
+
+    int virtualNodes;
+    std::map<uint64_t, std::string> ring;
+    std::map<std::string, ClusterNodeInfo> nodes;
+};
+
+#endif // HASHRING_H
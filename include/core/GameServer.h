@@ -2,9 +2,13 @@
 #define GAMESERVER_H
 
 #include "game/Room.h"
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <vector>
 #include <string>
 #ifdef _WIN32
@@ -28,11 +32,40 @@
     const int SOCKET_ERROR = -1;
 #endif
 
+// Event loop implementation used by GameServer::run
+enum class IoBackend {
+    Select,
+    IoUring
+};
+
+class IoUringBackend;
+class HandoffListener;
+class WriteBehindStore;
+class LeaderboardService;
+class RateLimiter;
+struct RateLimitConfig;
+class TlsContext;
+class TlsConnection;
+struct TlsConfig;
+
+// Per-connection state, keyed by client socket. A spectator has playerId 0
+// and the room it watches in roomId.
+struct ClientSession {
+    int playerId;
+    int roomId;
+};
+
 class GameServer {
 private:
     std::map<int, std::shared_ptr<Room>> rooms;
     std::mutex roomsMutex;
     int nextRoomId;
+
+    std::map<int, ClientSession> sessions;
+    std::mutex sessionsMutex;
+    int nextPlayerId;
+    // Ids below this are reserved in the persistence store, see allocate_player_id()
+    int reservedPlayerIds;
     
     #ifdef _WIN32
         SOCKET server_socket;
@@ -43,8 +76,139 @@ private:
     #endif
     int max_fd;
     fd_set read_fds;
+    fd_set write_fds;
+
+    // select() path: bytes the kernel has not accepted yet, per client socket.
+    // clientsMutex guards this and changes to client_sockets.
+    std::map<int, std::string> outbound;
+    std::mutex clientsMutex;
+    // Clients switched to binary frames, each with the start of a frame that
+    // has not fully arrived. Network thread only, see handle_input().
+    std::map<int, std::string> inbound;
+    // Reads refused by the rate limiter, per client socket. The socket is
+    // not read until retry_throttled() gets them admitted. Network thread only.
+    std::map<int, std::string> throttled;
+
+    // Shutdown and drain state, see requestShutdown()
+    std::atomic<bool> shutdownRequested;
+    std::atomic<bool> forceShutdown;
+    bool draining;
+    std::chrono::milliseconds drainTimeout;
+    std::chrono::steady_clock::time_point drainDeadline;
+    std::string stateFile;
+    int wake_read_fd;
+    int wake_write_fd;
+
+    // Hot restart state, see HotRestart.h. handoffChannel is set by the
+    // listener thread; the network thread quiesces and then hands off.
+    std::unique_ptr<HandoffListener> handoffListener;
+    std::atomic<int> handoffChannel;
+    bool handingOff;
+    std::chrono::steady_clock::time_point handoffDeadline;
+    std::atomic<bool> handedOff;
+    // Channel of a completed handoff, kept open until the old process has
+    // released its store
+    int releaseChannel;
+
+    IoBackend ioBackend;
+    std::unique_ptr<IoUringBackend> uring;
+
+    // Match results and player totals, written behind the game loop; not owned
+    WriteBehindStore* persistence;
+    // Wins per mode and season; not owned
+    LeaderboardService* leaderboards;
+    std::string season;
+    // Accept and read flood protection, off unless setRateLimits() is called
+    std::unique_ptr<RateLimiter> limiter;
+    // Encrypted transport on the select() path, off unless enableTls() is
+    // called. Sessions are keyed by client socket and guarded by clientsMutex.
+    std::unique_ptr<TlsContext> tls;
+    std::map<int, std::unique_ptr<TlsConnection>> tlsConnections;
+    // Spectator streams, see SpectatorStream. Only SendUpdatesToClients()
+    // touches the tick counter and the players each room's spectators saw
+    // last, which delta frames are computed against.
+    std::chrono::milliseconds spectatorDelay;
+    uint32_t spectatorTick;
+    std::map<int, std::set<int>> spectatorViews;
+
+    void run_select();
+    void run_io_uring();
+    void on_uring_wakeup();
+
+    bool start_backend();
+    bool create_wakeup_fd();
+    void wake_loop();
+    void consume_wakeup();
+    void begin_drain();
+    bool drain_complete();
+    void finish_drain();
+    bool has_pending_output();
+
+    void begin_handoff();
+    bool handoff_ready();
+    bool complete_handoff();
+    std::string serialize_snapshot(std::vector<int>& fds);
+    bool restore_snapshot(const std::string& snapshot, const std::vector<int>& fds);
+
+    // select() path input: false when the connection has to be closed
+    bool read_plain(int client);
+    bool read_tls(int client);
+    // Both paths: rate limits, then handle_input() and the reply
+    bool dispatch_read(int client, const char* data, size_t len);
+    void process_input(int client, const char* data, size_t len);
+    // Hands held reads on once their buckets have refilled, closes
+    // connections that stayed over the limit
+    void retry_throttled();
+    void schedule_throttle_retry();
+
+    // select() path output and teardown
+    void send_to_client(int client, const char* data, size_t len);
+    // Needs clientsMutex. Bytes written, or -1 when the connection failed;
+    // 0 with wouldBlock set when the socket or handshake is not ready
+    long write_client(int client, const char* data, size_t len, bool& wouldBlock);
+    void flush_outbound();
+    void close_client(int client);
+
+    // LogServerStats state: rates are computed between two summaries
+    std::chrono::steady_clock::duration statsInterval;
+    std::chrono::steady_clock::time_point lastStatsTime;
+    uint64_t lastMessages;
+    uint64_t lastBytesReceived;
+    uint64_t lastBytesSent;
+
+    // Shared by both I/O backends; fills reply with the bytes to send back.
+    // handle_input() takes one read. Until the client sends BINARY (see
+    // protocol::BINARY_COMMAND) the whole read is one text command for
+    // handle_message(); after it, frames are cut from the bytes buffered for
+    // the client and each goes to binary_reply().
+    void handle_input(int client, const char* data, size_t len, std::string& reply);
+    void handle_message(int client, const char* data, size_t len, std::string& reply);
+    void handle_disconnect(int client);
+    bool join_room(int client, int roomId);
+    bool spectate_room(int client, int roomId);
+    // Spectator sockets with more unsent output than a few frames
+    std::set<int> backlogged_spectators();
+    void send_shared(const std::vector<int>& clients, const std::shared_ptr<const std::string>& frame);
+    // Player ids held by connected sessions
+    std::set<int> session_players();
+    // Next session player id; needs sessionsMutex
+    int allocate_player_id();
+    // Room state records, see saveRoomState(); read_room_records needs roomsMutex
+    static void write_room_records(std::ostream& out, const Room& room, const std::set<int>& skipPlayers);
+    size_t read_room_records(std::istream& in, const std::string& source, bool replaceExisting);
+    void leaderboard_reply(int client, const char* data, size_t len, std::string& reply);
+    // Frames of the generated binary protocol, see schema/GameProtocol.schema
+    void binary_reply(const uint8_t* data, size_t len, std::string& reply);
 public:
-    GameServer() : nextRoomId(1) , server_socket(INVALID_SOCKET){}
+    GameServer();
+    ~GameServer();
+
+    // Must be called before initialize(); falls back to Select when unavailable
+    void setIoBackend(IoBackend backend) { ioBackend = backend; }
+    IoBackend getIoBackend() const { return ioBackend; }
+    static bool isIoBackendAvailable(IoBackend backend);
+    static bool parseIoBackend(const std::string& name, IoBackend& backend);
+    static std::string ioBackendToString(IoBackend backend);
     
     std::shared_ptr<Room> createRoom(const std::string& roomName, int maxPlayers = 4);
     bool deleteRoom(int roomId);
@@ -52,20 +216,90 @@ public:
     std::vector<std::shared_ptr<Room>> getAllRooms();
     void listRooms();
 
+    // Also continues the player id sequence stored there, so ids are not
+    // handed out twice across restarts on the same store
+    void setPersistence(WriteBehindStore* store);
+    void setLeaderboards(LeaderboardService* service, const std::string& currentSeason) {
+        leaderboards = service;
+        season = currentSeason;
+    }
+    // Must be called before initialize() or takeOver()
+    void setRateLimits(const RateLimitConfig& config);
+    // Must be called before initialize() or takeOver(). TLS connections are
+    // served by the select() backend and are not carried over a hot restart;
+    // those clients reconnect. Also ignores SIGPIPE, OpenSSL writes with write().
+    bool enableTls(const TlsConfig& config);
+    bool isTlsEnabled() const { return tls != nullptr; }
+    // How far spectators are held behind the players; applies to rooms as
+    // their spectators join. Capped at 20 s so the delayed frames still fit
+    // in a stream's ring.
+    void setSpectatorDelay(std::chrono::milliseconds delay);
+    // Ends the game in a room: resets it and records the result, the
+    // players' totals and the winner on the mode's leaderboard for the
+    // current season. winnerId 0 means nobody won. HandleGameLogic() calls
+    // it for games that are down to one player.
+    //
+    // Totals and board entries are keyed by player id. A client gets its id
+    // when it first joins and keeps it for the connection, including across
+    // hot restarts; ids are never reused on the same store, but there are no
+    // accounts, so a client that reconnects starts over under a new id.
+    bool finishGame(int roomId, int winnerId, const std::string& mode = "standard");
+
+    // Port 0 picks a free port, getPort() tells which
     bool initialize(int port);
+    int getPort() const;
     void run();
+
+    // Async-signal-safe. Wakes the network thread and puts it in drain mode:
+    // stop accepting, stop reading, flush queued output, save room state and
+    // close every client, then run() returns. A second call cuts the flush
+    // short; the drain timeout bounds it either way.
+    void requestShutdown();
+    bool isShuttingDown() const { return shutdownRequested; }
+    void setDrainTimeout(std::chrono::milliseconds timeout) { drainTimeout = timeout; }
+    // Room state is written here at the end of a drain, without the players
+    // of connected clients; empty (the default) disables it
+    void setStateFile(const std::string& filename) { stateFile = filename; }
+
+    bool saveRoomState(const std::string& filename);
+    bool loadRoomState(const std::string& filename);
+
+    // Cluster room migration, see ClusterNode. exportRoom() returns a copy of
+    // the room as room state records, without the players connected here;
+    // the room is only removed by a later deleteRoom(). importRooms() adds
+    // rooms from such records and skips ids that already exist, returning
+    // how many it added.
+    std::vector<int> getRoomIds();
+    bool exportRoom(int roomId, std::string& data);
+    size_t importRooms(const std::string& data);
+
+    // Hot restart: accept takeover requests from a new process on this path
+    bool enableHandoff(const std::string& path);
+    // Used instead of initialize(): adopts the listening socket, clients and
+    // rooms of the server running at path
+    bool takeOver(const std::string& path);
+    // True once run() has returned because a new process took over
+    bool hasHandedOff() const { return handedOff; }
+    // Old process: tells the new one that the store and ports are free.
+    // Exiting or destroying the server does the same.
+    void releaseHandoff();
+    // New process: waits for the old one to release, false on timeout
+    bool waitForHandoffRelease();
+
     void handle_new_connection();
     void handle_client_data();
     void broadcast_message(const std::string& message);
 
     void CleanUpRooms();
+    // Appends one frame per watched room to its spectator stream and sends
+    // every spectator what it can read
     void SendUpdatesToClients();
     void HandleGameLogic();
     void LogServerStats();
 
-    #ifdef _WIN32
-        ~GameServer();
-    #endif
+    // Summary period for LogServerStats; the values themselves live in MetricsRegistry
+    void setStatsInterval(std::chrono::seconds interval) { statsInterval = interval; }
+    void recordTick(std::chrono::microseconds duration);
 };
 
 #endif
\ No newline at end of file
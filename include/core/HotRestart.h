@@ -0,0 +1,91 @@
+#ifndef HOTRESTART_H
+#define HOTRESTART_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Zero-downtime restart. The running server listens on a Unix domain socket;
+// a new process started with --takeover connects to it and receives
+//
+//   1. a header and a binary snapshot of rooms and sessions (GameServer)
+//   2. the listening socket and every client socket, via SCM_RIGHTS
+//
+// and acknowledges once it is serving. The old process then exits without
+// shutting any socket down, so clients never notice the switch; closing the
+// channel on its way out tells the new process the store is free.
+
+// Varint / length-prefixed encoding used for the snapshot
+class SnapshotWriter {
+public:
+    void putVarint(uint64_t value);
+    void putString(const std::string& value);
+
+    const std::string& data() const { return buffer; }
+
+private:
+    std::string buffer;
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& data) : data(data), offset(0) {}
+
+    // Return false once the input is exhausted or malformed
+    bool getVarint(uint64_t& value);
+    bool getString(std::string& value);
+    bool atEnd() const { return offset == data.size(); }
+
+private:
+    const std::string& data;
+    size_t offset;
+};
+
+// Accepts takeover requests on a Unix socket path from its own thread.
+// The handler owns the connected channel fd.
+class HandoffListener {
+public:
+    using Handler = std::function<void(int channel)>;
+    HandoffListener();
+    ~HandoffListener();
+
+    bool start(const std::string& path, Handler handler);
+    void stop();
+    bool isRunning() const { return running; }
+
+private:
+    HandoffListener(const HandoffListener&) = delete;
+    HandoffListener& operator=(const HandoffListener&) = delete;
+
+    void serve();
+
+    std::string socketPath;
+    unsigned long socketInode;   // only unlink the path if it is still ours
+    int listenFd;
+    std::atomic<bool> running;
+    std::thread worker;
+    Handler onRequest;
+};
+
+// New process side: connect to a running server's handoff socket
+int connectHandoff(const std::string& path);
+
+// Old process side. Returns true once the receiver has acknowledged, after
+// which the caller must not touch the sockets again.
+bool sendHandoff(int channel, const std::string& snapshot, const std::vector<int>& fds);
+
+// New process side. The receiver owns fds on success and must call
+// acknowledgeHandoff() once it is ready to serve them.
+bool receiveHandoff(int channel, std::string& snapshot, std::vector<int>& fds);
+bool acknowledgeHandoff(int channel);
+
+// After the acknowledgement the old process keeps the channel open until it
+// has released its store and ports, then closes it (or exits). The new side
+// blocks until then; false if that takes longer than the channel timeout.
+bool waitForRelease(int channel);
+
+#endif // HOTRESTART_H
@@ -0,0 +1,207 @@
+#ifndef IOURINGBACKEND_H
+#define IOURINGBACKEND_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <deque>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+// Linux io_uring event loop used by GameServer when IoBackend::IoUring is selected.
+// Talks to the kernel through raw syscalls so no liburing dependency is needed.
+//
+// - one multishot accept on the listening socket
+// - one multishot recv per client, reading into a registered buffer ring
+// - sends are queued per connection and submitted in one batch per loop iteration
+class IoUringBackend {
+public:
+    // Returning false closes the new connection before it is served
+    using AcceptHandler = std::function<bool(int fd)>;
+    using DataHandler = std::function<void(int fd, const char* data, size_t len)>;
+    using CloseHandler = std::function<void(int fd, int error)>;
+    using EventHandler = std::function<void()>;
+
+    IoUringBackend();
+    ~IoUringBackend();
+
+    // Returns false when the kernel does not support the features we need,
+    // in which case the caller should fall back to select().
+    bool initialize(int listen_fd, unsigned entries = 4096);
+
+    void setAcceptHandler(AcceptHandler handler) { onAccept = std::move(handler); }
+    void setDataHandler(DataHandler handler) { onData = std::move(handler); }
+    void setCloseHandler(CloseHandler handler) { onClose = std::move(handler); }
+
+    // Reads an eventfd whenever it is signalled and calls handler on the loop
+    // thread. Lets a signal handler wake the loop with a plain write().
+    void setWakeHandler(int eventFd, EventHandler handler);
+    // Calls handler on the loop thread every interval until cleared with an
+    // empty handler. Must be called from the loop thread or before run().
+    void setTimerHandler(std::chrono::milliseconds interval, EventHandler handler);
+
+    // Event loop; returns after stop() is called from any thread.
+    void run();
+    void stop();
+
+    // Safe to call from any thread. Data is copied.
+    void send(int fd, const char* data, size_t len);
+    // Queues the same buffer on every connection without copying it.
+    void broadcast(const std::shared_ptr<const std::string>& message);
+    // Same for the given connections only
+    void multicast(const std::vector<int>& fds, const std::shared_ptr<const std::string>& message);
+
+    size_t getConnectionCount();
+    size_t getPendingSendCount();
+    // Bytes queued on one connection and not yet accepted by the kernel
+    size_t getQueuedBytes(int fd);
+
+    // Cancels the multishot accept; existing connections are unaffected
+    void stopAccepting();
+    // Shuts every connection down, each one reports through the close handler
+    void closeAllConnections();
+    // Same for one connection
+    void disconnect(int fd) { closeConnection(fd, 0); }
+    // Flow control for one connection: cancels its recv and leaves new data
+    // in the socket until resumeReading(). Data already received is still
+    // delivered.
+    void pauseReading(int fd);
+    void resumeReading(int fd);
+
+    // Hot restart: pause() stops accepting and cancels every recv while
+    // leaving the sockets open. Data already received is still delivered;
+    // once getArmedRecvCount() reaches zero the kernel holds the rest.
+    // pauseSends() does the same for sends: queued output stays queued and
+    // can be read back with getUnsent() once getSendsInFlight() is zero.
+    // resume() restarts both, except reads paused with pauseReading().
+    void pause();
+    void pauseSends();
+    void resume();
+    size_t getArmedRecvCount();
+    size_t getSendsInFlight();
+    std::vector<int> getConnectionFds();
+    // Bytes queued on a connection and not yet accepted by the kernel
+    std::string getUnsent(int fd);
+    // Starts serving a socket accepted elsewhere (e.g. by a previous process)
+    void adoptConnection(int fd);
+
+private:
+    enum OpType : uint8_t {
+        OP_ACCEPT = 1,
+        OP_RECV = 2,
+        OP_SEND = 3,
+        OP_WAKE = 4,
+        OP_EVENTFD = 5,
+        OP_TIMER = 6,
+        OP_CANCEL = 7
+    };
+
+    struct PendingSend {
+        std::shared_ptr<const std::string> data;
+        size_t offset;
+    };
+
+    struct Connection {
+        uint32_t generation;
+        std::deque<PendingSend> sendQueue;
+        bool sending;
+        bool recvArmed;
+        bool readPaused;
+        bool closing;
+    };
+
+    static uint64_t encodeUserData(OpType type, int fd, uint32_t generation);
+
+    io_uring_sqe* getSqe();
+    void submitPending(unsigned waitFor);
+
+    void armAccept();
+    void armWakeRead();
+    void armTimer();
+    void armRecv(int fd, Connection& conn);
+    void queueSend(int fd, const std::shared_ptr<const std::string>& data);
+    void startSend(int fd, Connection& conn);
+    void retryStalledSends();
+    void recycleBuffer(uint16_t bid);
+
+    void registerConnection(int fd);
+    void handleCompletion(const io_uring_cqe& cqe);
+    void handleAccept(int res, uint32_t flags);
+    void handleRecv(int fd, uint32_t generation, int res, uint32_t flags);
+    void handleSend(int fd, uint32_t generation, int res);
+    void closeConnection(int fd, int error);
+
+    bool inLoopThread() const { return std::this_thread::get_id() == loopThread; }
+
+    int ringFd;
+    int listenFd;
+
+    // Submission queue (mapped from the kernel)
+    void* sqRingPtr;
+    size_t sqRingSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned sqEntries;
+    unsigned sqLocalTail;
+
+    // Completion queue (mapped from the kernel)
+    void* cqRingPtr;
+    size_t cqRingSize;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    io_uring_cqe* cqes;
+
+    // Provided buffer ring for multishot recv
+    io_uring_buf_ring* bufRing;
+    size_t bufRingSize;
+    char* bufPool;
+    unsigned bufCount;
+    unsigned bufSize;
+    uint16_t bufTail;
+
+    // Guards the SQ ring and the connection table
+    std::mutex sqMutex;
+    std::unordered_map<int, Connection> connections;
+    // Connections whose next send found the SQ full
+    std::vector<int> stalledSends;
+    uint32_t nextGeneration;
+
+    std::atomic<bool> running;
+    std::thread::id loopThread;
+    bool acceptStopped;
+    bool readingPaused;
+    bool sendingPaused;
+
+    int wakeFd;
+    uint64_t wakeValue;
+    EventHandler onWake;
+
+    int64_t timerIntervalNanos;
+    struct {
+        int64_t tv_sec;
+        long long tv_nsec;
+    } timerSpec;            // layout of __kernel_timespec
+    bool timerArmed;
+    EventHandler onTimer;
+
+    AcceptHandler onAccept;
+    DataHandler onData;
+    CloseHandler onClose;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Token bucket: up to burst at once, refilled at perSecond. perSecond 0
+// turns the limit off. Bursts are capped at MAX_BURST.
+struct RateLimit {
+    uint32_t perSecond;
+    uint32_t burst;
+};
+
+struct RateLimitConfig {
+    RateLimit acceptsPerIp = {10, 40};
+    RateLimit messagesPerIp = {2000, 4000};
+    RateLimit bytesPerIp = {1024 * 1024, 2 * 1024 * 1024};
+    RateLimit messagesPerConnection = {200, 400};
+    RateLimit bytesPerConnection = {256 * 1024, 512 * 1024};
+    uint32_t maxConnectionsPerIp = 64;
+    // Refused reads in a row, retries of a held read included, before the
+    // connection is closed
+    uint32_t maxStrikes = 64;
+    // Table sizes, rounded up to a power of two; 64 bytes per slot
+    size_t addressSlots = 65536;
+    size_t connectionSlots = 65536;
+    // 127.0.0.0/8 is exempt unless set, so a local router or load generator
+    // is not mistaken for a flood
+    bool limitLoopback = false;
+};
+
+// Flood protection for the accept and read paths, checked before any parsing.
+//
+// Buckets live in two fixed-size open-addressing tables allocated up front,
+// one keyed by IPv4 address and one by socket, so an attack cannot make the
+// limiter allocate. Each bucket is one 64-bit word (tokens and last refill
+// time) updated with compare-and-swap. An address slot is only reused once it
+// has no connections and its buckets would have refilled completely. Addresses
+// or sockets that find no slot are admitted without that level of limits and
+// counted in gameserver_ratelimit_untracked_total.
+//
+// Lock-free but approximate under contention: two threads claiming the same
+// new address at once may briefly track it twice.
+class RateLimiter {
+public:
+    enum class Verdict { Allow, Throttle, Disconnect };
+
+    static const uint32_t MAX_BURST = 4000000;
+
+    explicit RateLimiter(const RateLimitConfig& config = RateLimitConfig());
+
+    // Accept path, ipv4 in host byte order. false: close the socket right away
+    bool admitConnection(int fd, uint32_t ipv4, uint32_t nowMs = clockMs());
+    // Registers a connection without checking limits (hot restart handoff)
+    void trackConnection(int fd, uint32_t ipv4, uint32_t nowMs = clockMs());
+    // Read path: charges one message of this many bytes to the connection and
+    // its address. Throttle refuses it for now: the caller holds the read, stops
+    // reading the socket and asks again later. Disconnect after maxStrikes
+    // refusals in a row.
+    Verdict admitRead(int fd, size_t bytes, uint32_t nowMs = clockMs());
+    void connectionClosed(int fd);
+
+    size_t getTrackedAddresses() const { return trackedAddresses; }
+    size_t getTrackedConnections() const { return trackedConnections; }
+    const RateLimitConfig& getConfig() const { return config; }
+
+    // Milliseconds on a steady clock; wraps after 49 days, which buckets tolerate
+    static uint32_t clockMs();
+
+private:
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> key;          // address + 1 or fd + 1, 0 when free
+        std::atomic<uint32_t> lastSeenMs;
+        std::atomic<uint32_t> connections;  // address slots: open connections
+        std::atomic<uint32_t> strikes;      // connection slots: refusals in a row
+        std::atomic<uint32_t> parent;       // connection slots: address slot + 1, 0 if none
+        std::atomic<uint64_t> accepts;
+        std::atomic<uint64_t> messages;
+        std::atomic<uint64_t> bytes;
+    };
+
+    static void clearSlot(Slot& slot);
+    static bool take(std::atomic<uint64_t>& bucket, const RateLimit& limit, uint32_t nowMs, uint64_t cost);
+    static void fill(std::atomic<uint64_t>& bucket, const RateLimit& limit, uint32_t nowMs);
+    static uint64_t hash(uint64_t key);
+
+    bool isExempt(uint32_t ipv4) const;
+    // Index of the address slot, or -1 when the probe window is full of live addresses
+    long findAddress(uint32_t ipv4, uint32_t nowMs);
+    Slot* findConnection(int fd);
+    void registerConnection(int fd, long address, uint32_t nowMs);
+
+    RateLimitConfig config;
+    // Idle time after which every bucket of an address is full again
+    uint32_t evictAfterMs;
+
+    std::unique_ptr<Slot[]> addresses;
+    size_t addressMask;
+    std::unique_ptr<Slot[]> connections;
+    size_t connectionMask;
+
+    std::atomic<size_t> trackedAddresses;
+    std::atomic<size_t> trackedConnections;
+};
+
+#endif // RATELIMITER_H
@@ -0,0 +1,100 @@
+#ifndef TLSCONTEXT_H
+#define TLSCONTEXT_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+struct ssl_st;
+struct ssl_ctx_st;
+
+struct TlsConfig {
+    // PEM files; both empty means an ephemeral self-signed certificate,
+    // which clients can only accept without verification
+    std::string certFile;
+    std::string keyFile;
+    // Hand record encryption to the kernel (kTLS) where OpenSSL and the
+    // kernel support it; falls back to OpenSSL silently otherwise
+    bool kernelOffload = true;
+    // How long a session ticket stays valid for resumption
+    std::chrono::seconds ticketLifetime = std::chrono::hours(2);
+};
+
+class TlsConnection;
+
+// Server side TLS (1.2 and 1.3) on top of OpenSSL.
+//
+// Resumption uses stateless session tickets: the session is encrypted into
+// the ticket with a key only this process knows, so the server keeps no
+// per-session cache and a reconnect skips the certificate exchange and the
+// signature. Ticket keys are per process; after a restart clients fall back
+// to a full handshake once.
+class TlsContext {
+public:
+    TlsContext();
+    ~TlsContext();
+
+    // false when the certificate or key cannot be loaded, or when the server
+    // was built without TLS support
+    bool initialize(const TlsConfig& config);
+    // Takes over a connected, non-blocking socket. The socket stays owned by
+    // the caller; nullptr on failure.
+    std::unique_ptr<TlsConnection> accept(int fd);
+
+    static bool isAvailable();
+
+private:
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    ssl_ctx_st* ctx;
+};
+
+// One TLS session on a non-blocking socket. Not thread-safe: reads and writes
+// on the same connection have to be serialized by the caller.
+class TlsConnection {
+public:
+    enum class Result {
+        Done,       // handshake finished, or data transferred
+        WantRead,   // retry once the socket is readable
+        WantWrite,  // retry once the socket is writable
+        Closed,     // peer sent close_notify or the socket was closed
+        Failed
+    };
+
+    ~TlsConnection();
+
+    // Advances the handshake as far as the socket allows
+    Result handshake();
+    bool isEstablished() const { return established; }
+    bool wasResumed() const;
+    // Records are encrypted by the kernel on the send side
+    bool isKernelOffloaded() const;
+    // Set by handshake() when it last stopped on WantWrite
+    bool handshakeWantsWrite() const { return wantsWrite; }
+
+    // Plaintext in and out. Return the byte count when result is Done, 0
+    // otherwise. A write that stopped on WantWrite has to be retried with the
+    // same bytes at the front of the buffer.
+    size_t read(char* buffer, size_t len, Result& result);
+    size_t write(const char* data, size_t len, Result& result);
+    // Sends close_notify, best effort; the socket is not closed
+    void shutdown();
+
+    std::chrono::steady_clock::time_point getStartTime() const { return startTime; }
+
+private:
+    friend class TlsContext;
+    explicit TlsConnection(ssl_st* ssl);
+    TlsConnection(const TlsConnection&) = delete;
+    TlsConnection& operator=(const TlsConnection&) = delete;
+
+    Result translate(int ret);
+
+    ssl_st* ssl;
+    bool established;
+    bool wantsWrite;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+#endif // TLSCONTEXT_H
@@ -0,0 +1,94 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct LeaderboardEntry {
+    int playerId;
+    int64_t score;
+    size_t rank;            // 1-based
+};
+
+// Ranked scores for one board, kept incrementally instead of re-sorting.
+//
+// Entries live in a skip list ordered by score (highest first, ties by lower
+// player id). Every forward link also stores how many entries it skips, so a
+// rank is the sum of spans along the search path: updates, rank lookups and
+// the first entry of a range are all O(log n).
+//
+// All methods are thread-safe.
+class Leaderboard {
+public:
+    Leaderboard();
+    ~Leaderboard();
+
+    // Sets the score, inserting the player if needed; returns the new rank
+    size_t setScore(int playerId, int64_t score);
+    // Adds delta to the current score (0 for a new player); returns the new score
+    int64_t addScore(int playerId, int64_t delta);
+    bool remove(int playerId);
+    void clear();
+
+    bool getScore(int playerId, int64_t& score);
+    // 0 when the player has no score on this board
+    size_t getRank(int playerId);
+    std::vector<LeaderboardEntry> getTop(size_t count);
+    // count entries starting at rank first (1-based)
+    std::vector<LeaderboardEntry> getRange(size_t first, size_t count);
+    // The player plus up to radius entries on each side
+    std::vector<LeaderboardEntry> getAround(int playerId, size_t radius);
+
+    size_t size();
+    // Bumped by every change; used to skip unchanged boards when snapshotting
+    uint64_t getVersion();
+
+    // Binary snapshot of all entries
+    std::string serialize();
+    bool load(const std::string& data);
+
+private:
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    static const int MAX_LEVEL = 32;
+
+    struct Node;
+    struct Link {
+        Node* next;
+        size_t span;        // entries between this node and next, next included
+    };
+    struct Node {
+        int64_t score;
+        int playerId;
+        int level;
+        Link links[1];      // level entries, allocated with the node
+    };
+
+    static Node* createNode(int level, int64_t score, int playerId);
+    static void destroyNode(Node* node);
+    // True when node ranks ahead of (score, playerId)
+    static bool precedes(const Node* node, int64_t score, int playerId);
+
+    int randomLevel();
+    size_t insertLocked(int64_t score, int playerId);
+    void eraseLocked(int64_t score, int playerId);
+    size_t rankLocked(int64_t score, int playerId);
+    Node* nodeAtLocked(size_t rank);
+    std::vector<LeaderboardEntry> rangeLocked(size_t first, size_t count);
+    void clearLocked();
+
+    std::mutex mutex;
+    Node* head;
+    int level;
+    size_t length;
+    uint64_t version;
+    uint64_t rng;
+    std::unordered_map<int, int64_t> scores;
+};
+
+#endif // LEADERBOARD_H
@@ -0,0 +1,71 @@
+#ifndef LEADERBOARDSERVICE_H
+#define LEADERBOARDSERVICE_H
+
+#include "game/Leaderboard.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// All leaderboards, one per game mode and season.
+//
+// Boards are snapshotted to <directory>/<mode>.<season>.lb from a background
+// thread, only when they changed since the last snapshot, and loaded back by
+// start(). stop() writes a final snapshot. Mode and season names are limited
+// to letters, digits, '-' and '_' since they become file names.
+class LeaderboardService {
+public:
+    LeaderboardService();
+    ~LeaderboardService();
+
+    // Empty directory keeps the boards in memory only
+    void setSnapshotDirectory(const std::string& directory) { snapshotDirectory = directory; }
+    void setSnapshotInterval(std::chrono::milliseconds interval) { snapshotInterval = interval; }
+
+    bool start();
+    void stop();
+
+    // Creates the board on first use; nullptr for an invalid mode or season
+    Leaderboard* getBoard(const std::string& mode, const std::string& season);
+    // nullptr when the board does not exist
+    Leaderboard* findBoard(const std::string& mode, const std::string& season);
+    // "<mode>.<season>" for every board
+    std::vector<std::string> getBoardNames();
+
+    // Writes every changed board; returns how many were written
+    size_t snapshotNow();
+
+    static bool isValidName(const std::string& name);
+
+private:
+    LeaderboardService(const LeaderboardService&) = delete;
+    LeaderboardService& operator=(const LeaderboardService&) = delete;
+
+    struct Board {
+        std::unique_ptr<Leaderboard> board;
+        uint64_t savedVersion;
+    };
+
+    bool loadSnapshots();
+    bool writeSnapshot(const std::string& name, Leaderboard& board);
+    void snapshotLoop();
+
+    std::string snapshotDirectory;
+    std::chrono::milliseconds snapshotInterval;
+
+    std::mutex mutex;
+    std::map<std::string, Board> boards;
+
+    std::mutex snapshotMutex;           // one snapshot pass at a time
+    std::mutex threadMutex;
+    std::condition_variable wake;
+    bool stopping;
+    bool running;
+    std::thread snapshotThread;
+};
+
+#endif // LEADERBOARDSERVICE_H
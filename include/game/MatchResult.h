@@ -0,0 +1,36 @@
+#ifndef MATCHRESULT_H
+#define MATCHRESULT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-player totals, persisted under "player/<id>"
+struct PlayerStats {
+    std::string name;
+    int gamesPlayed;
+    int wins;
+
+    PlayerStats() : gamesPlayed(0), wins(0) {}
+
+    static std::string key(int playerId);
+    std::string serialize() const;
+    static bool parse(const std::string& data, PlayerStats& stats);
+};
+
+// One finished game, persisted under "match/<endedAt>-<roomId>"
+struct MatchResult {
+    int roomId;
+    std::string roomName;
+    int winnerId;           // 0 when nobody won
+    int64_t endedAt;        // unix time in milliseconds
+    std::vector<int> playerIds;
+
+    MatchResult() : roomId(0), winnerId(0), endedAt(0) {}
+
+    std::string key() const;
+    std::string serialize() const;
+    static bool parse(const std::string& data, MatchResult& result);
+};
+
+#endif // MATCHRESULT_H
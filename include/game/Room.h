@@ -1,6 +1,7 @@
 #ifndef ROOM_H
 #define ROOM_H
 
+#include "game/SpectatorStream.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -23,6 +24,10 @@ private:
     std::vector<std::shared_ptr<Player>> players;
     int maxPlayers;
     bool isStarted;
+    // Who the running game started with, including players who left since
+    std::vector<std::shared_ptr<Player>> lineup;
+    // Spectators do not count against maxPlayers; they all share one stream
+    SpectatorStream spectatorStream;
     
 public:
     Room(int id, const std::string& name, int maxPlayers = 4);
@@ -32,11 +37,23 @@ public:
     int getPlayerCount() const { return players.size(); }
     int getMaxPlayers() const { return maxPlayers; }
     bool getIsStarted() const { return isStarted; }
+    // Used when restoring saved state; startGame() applies the game rules
+    void setIsStarted(bool started) { isStarted = started; }
     
     bool addPlayer(std::shared_ptr<Player> player);
     bool removePlayer(int playerId);
     std::shared_ptr<Player> getPlayer(int playerId);
     std::vector<std::shared_ptr<Player>> getPlayers() const { return players; }
+    // Empty unless startGame() started the running game; a game restored
+    // with setIsStarted() has no lineup
+    std::vector<std::shared_ptr<Player>> getLineup() const { return lineup; }
+    
+    // Spectators can join started and full rooms. Once the last one leaves
+    // the stream is cleared, so rooms nobody watches keep no frames.
+    bool addSpectator(int spectatorId);
+    bool removeSpectator(int spectatorId);
+    int getSpectatorCount() const { return (int)spectatorStream.getSpectatorCount(); }
+    SpectatorStream& getSpectatorStream() { return spectatorStream; }
     
     void startGame();
     void resetRoom();
@@ -0,0 +1,93 @@
+#ifndef SPECTATORSTREAM_H
+#define SPECTATORSTREAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One room's updates for all of its spectators.
+//
+// Each tick's update is encoded once and appended to a fixed ring of
+// refcounted buffers; a spectator is only a cursor into the ring, so the
+// cost of a frame does not grow with the audience and the same buffer is
+// queued on every socket. Frames become readable delay after they were
+// appended, which keeps spectators behind the players.
+//
+// Frames between keyframes may depend on the ones before them. A spectator
+// that joins, falls out of the ring or is told to skip() starts again at
+// the newest readable keyframe instead of being buffered for.
+//
+// Not thread-safe; the server calls it under roomsMutex.
+class SpectatorStream {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Frame = std::shared_ptr<const std::string>;
+
+    static const size_t DEFAULT_CAPACITY = 256;
+
+    explicit SpectatorStream(size_t capacity = DEFAULT_CAPACITY);
+
+    // Applies to frames that are not readable yet as well
+    void setDelay(std::chrono::milliseconds value) { delay = value; }
+    std::chrono::milliseconds getDelay() const { return delay; }
+    size_t getCapacity() const { return ring.size(); }
+
+    // Spectators are identified by the caller, e.g. by socket
+    bool addSpectator(int id);
+    bool removeSpectator(int id);
+    bool hasSpectator(int id) const { return cursors.count(id) != 0; }
+    size_t getSpectatorCount() const { return cursors.size(); }
+    std::vector<int> getSpectators() const;
+
+    // Appends one tick's update. Keyframes must not depend on earlier frames.
+    void append(Frame frame, bool keyframe, Clock::time_point now);
+    // Appends the frames readable by spectator id at now, oldest first, to
+    // frames and moves its cursor past them. Returns how many were added.
+    size_t read(int id, Clock::time_point now, std::vector<Frame>& frames);
+    // Drops everything the spectator has not read yet; its next read starts
+    // at the newest readable keyframe
+    void skip(int id);
+    // Drops every frame, e.g. when nobody is watching; spectators wait for
+    // the next keyframe
+    void clear();
+
+    // Sequence number the next appended frame gets
+    uint64_t getNextSequence() const { return nextSequence; }
+    // Frames still in the ring
+    size_t getFrameCount() const { return (size_t)(nextSequence - firstSequence); }
+    // Spectators moved to a keyframe after falling behind
+    uint64_t getSkipCount() const { return skips; }
+
+private:
+    struct Entry {
+        Frame data;
+        Clock::time_point appended;
+        bool keyframe;
+    };
+
+    struct Cursor {
+        uint64_t next;      // sequence of the next frame to read
+        bool synced;        // false until placed on a keyframe
+    };
+
+    Entry& entry(uint64_t sequence) { return ring[sequence % ring.size()]; }
+    // Moves the readable end up to now
+    void release(Clock::time_point now);
+
+    std::vector<Entry> ring;
+    std::unordered_map<int, Cursor> cursors;
+    std::chrono::milliseconds delay;
+
+    uint64_t firstSequence;     // oldest frame still in the ring
+    uint64_t nextSequence;
+    uint64_t releasedSequence;  // frames before this one are readable
+    uint64_t keyframeSequence;  // newest readable keyframe, if hasKeyframe
+    bool hasKeyframe;
+    uint64_t skips;
+};
+
+#endif // SPECTATORSTREAM_H
@@ -0,0 +1,67 @@
+#ifndef FILESTORE_H
+#define FILESTORE_H
+
+#include "persistence/StorageBackend.h"
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Embedded single-file store. Each batch is appended to the data file and
+// fsynced once; reads are served from an in-memory index rebuilt on open().
+// The file is rewritten without dead records once they outweigh live ones.
+// File I/O runs under its own mutex, so reads never wait for a sync or a
+// compaction, only for the index update after one.
+class FileStore : public StorageBackend {
+public:
+    explicit FileStore(const std::string& path);
+    ~FileStore();
+
+    bool open() override;
+    void close() override;
+    bool writeBatch(const std::vector<StorageRecord>& records) override;
+    bool read(const std::string& key, std::string& value) override;
+    void scan(const std::string& prefix, const Visitor& visit) override;
+    std::string name() const override { return "file"; }
+
+    bool compact();
+    size_t getFileSize();
+    size_t getKeyCount();
+
+private:
+    FileStore(const FileStore&) = delete;
+    FileStore& operator=(const FileStore&) = delete;
+
+    bool lockFile();
+    // Needs fileMutex
+    bool compactLocked();
+
+    std::string path;
+
+    // Taken before indexMutex when both are needed
+    std::mutex fileMutex;
+    std::FILE* file;
+    int lockFd;
+    size_t fileBytes;
+
+    std::mutex indexMutex;
+    std::map<std::string, std::string> index;
+    size_t liveBytes;
+};
+
+// Non-durable backend for tests and benchmarks
+class MemoryStore : public StorageBackend {
+public:
+    bool open() override { return true; }
+    void close() override {}
+    bool writeBatch(const std::vector<StorageRecord>& records) override;
+    bool read(const std::string& key, std::string& value) override;
+    void scan(const std::string& prefix, const Visitor& visit) override;
+    std::string name() const override { return "memory"; }
+
+private:
+    std::mutex mutex;
+    std::map<std::string, std::string> data;
+};
+
+#endif // FILESTORE_H
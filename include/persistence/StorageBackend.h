@@ -0,0 +1,54 @@
+#ifndef STORAGEBACKEND_H
+#define STORAGEBACKEND_H
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One key/value change. Keys are namespaced by convention:
+// "player/<id>", "match/<time>-<room>", ...
+struct StorageRecord {
+    std::string key;
+    std::string value;
+    bool erased;
+};
+
+// Durable key/value store behind WriteBehindStore. Implementations must be
+// safe to read from any thread while the writer thread calls writeBatch().
+class StorageBackend {
+public:
+    using Visitor = std::function<void(const std::string& key, const std::string& value)>;
+
+    virtual ~StorageBackend() {}
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+
+    // Must not return true before the whole batch would survive a crash
+    virtual bool writeBatch(const std::vector<StorageRecord>& records) = 0;
+    virtual bool read(const std::string& key, std::string& value) = 0;
+    // Visits keys starting with prefix in key order
+    virtual void scan(const std::string& prefix, const Visitor& visit) = 0;
+
+    virtual std::string name() const = 0;
+};
+
+// "file" (default, stores under directory) or "memory"; nullptr if unknown
+std::unique_ptr<StorageBackend> createStorageBackend(const std::string& type,
+                                                     const std::string& directory);
+
+// Record framing shared by the file store and the recovery journal:
+//   crc32 | key length | value length | flags | key | value
+// Integers are 32-bit little endian; the CRC covers everything after it.
+void encodeStorageRecord(std::string& out, const StorageRecord& record);
+// Calls visit for each intact record and returns the length of the valid
+// prefix; a torn or corrupt tail (from a crash mid-write) is where it stops.
+size_t decodeStorageRecords(const std::string& data, const std::function<void(StorageRecord&)>& visit);
+
+bool readWholeFile(const std::string& path, std::string& data);
+// fflush + fsync, so the data is on disk and not just in our buffers
+bool syncFile(std::FILE* file);
+
+#endif // STORAGEBACKEND_H
@@ -0,0 +1,94 @@
+#ifndef WRITEBEHINDSTORE_H
+#define WRITEBEHINDSTORE_H
+
+#include "persistence/StorageBackend.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Write-behind persistence so the game loop never waits on storage.
+//
+// put()/erase() append the update to a recovery journal and return; that
+// return is the acknowledgement. A background thread coalesces updates per
+// key and writes them to the backend in batches, then deletes the journal
+// segments the batch covered. start() replays any segments left behind by a
+// crash before anything else, so an acknowledged update is never lost.
+//
+// The journal is written but not fsynced per update by default, which
+// survives a process crash. setJournalSync(true) also survives power loss at
+// the cost of one fsync per update.
+class WriteBehindStore {
+public:
+    // journalPrefix names the segments: <journalPrefix>.<sequence>
+    WriteBehindStore(std::unique_ptr<StorageBackend> backend, const std::string& journalPrefix);
+    ~WriteBehindStore();
+
+    void setFlushInterval(std::chrono::milliseconds interval) { flushInterval = interval; }
+    void setMaxBatchSize(size_t records) { maxBatchSize = records; }
+    void setJournalSync(bool sync) { journalSync = sync; }
+
+    bool start();
+    // Writes everything still queued, then stops the writer thread
+    void stop();
+    bool isRunning() const { return running; }
+
+    bool put(const std::string& key, const std::string& value);
+    bool erase(const std::string& key);
+    // Sees queued updates before the backend has them
+    bool get(const std::string& key, std::string& value);
+    // Blocks until everything acknowledged so far is in the backend
+    bool flush();
+
+    size_t getPendingCount();
+    StorageBackend& getBackend() { return *backend; }
+
+private:
+    WriteBehindStore(const WriteBehindStore&) = delete;
+    WriteBehindStore& operator=(const WriteBehindStore&) = delete;
+
+    struct Pending {
+        std::string value;
+        bool erased;
+    };
+
+    bool enqueue(const std::string& key, const std::string& value, bool erased);
+    bool recoverJournal();
+    bool openSegment();
+    std::vector<std::pair<uint64_t, std::string>> listSegments();
+    std::string segmentPath(uint64_t sequence) const;
+    void writerLoop();
+
+    std::unique_ptr<StorageBackend> backend;
+    std::string journalPrefix;
+    std::chrono::milliseconds flushInterval;
+    size_t maxBatchSize;
+    bool journalSync;
+
+    std::mutex mutex;
+    std::condition_variable writerWake;
+    std::condition_variable batchDone;
+    std::map<std::string, Pending> pending;
+    std::map<std::string, Pending> inflight;   // batch the writer is storing right now
+    uint64_t acknowledged;                     // updates accepted so far
+    uint64_t persisted;                        // updates known to be in the backend
+    bool flushRequested;
+    bool stopping;
+    bool running;
+
+    // Journal segments: the current one takes appends; sealed ones wait for
+    // the batch that covers them to reach the backend
+    std::FILE* journal;
+    uint64_t journalSequence;
+    std::vector<std::string> sealedSegments;
+
+    std::thread writer;
+};
+
+#endif // WRITEBEHINDSTORE_H
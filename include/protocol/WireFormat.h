@@ -0,0 +1,348 @@
+#ifndef WIREFORMAT_H
+#define WIREFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Runtime support for the codecs that SchemaCompiler generates from
+// schema/*.schema (see docs in the schema file).
+//
+// A frame is FRAME_MAGIC, the message id, the varint length of the fields
+// that follow, then the message fields:
+//   uint32/uint64      LEB128 varint
+//   int32/int64        zigzag varint
+//   float              4 bytes little-endian
+//   bool, bits<N>      consecutive ones packed together, little-endian,
+//                      rounded up to whole bytes
+//   string<N>          varint length + bytes
+//   T[N]               varint count + elements
+//
+// Everything works on caller buffers and fixed-capacity members; encoding
+// and decoding never allocate.
+namespace protocol {
+
+// Not valid as the first byte of UTF-8 text, which makes stray text easy to
+// report; frames are only read once the connection switched, see BINARY_COMMAND
+const uint8_t FRAME_MAGIC = 0xB7;
+const size_t FRAME_HEADER_SIZE = 2;
+
+template <size_t N>
+struct FixedString {
+    char data[N];
+    uint32_t length;
+
+    FixedString() : length(0) {}
+
+    bool assign(const char* text, size_t len) {
+        if (len > N) {
+            return false;
+        }
+        memcpy(data, text, len);
+        length = (uint32_t)len;
+        return true;
+    }
+    bool assign(const char* text) { return assign(text, strlen(text)); }
+
+    size_t size() const { return length; }
+    static constexpr size_t capacity() { return N; }
+    bool operator==(const FixedString& other) const {
+        return length == other.length && memcmp(data, other.data, length) == 0;
+    }
+};
+
+template <typename T, size_t N>
+struct FixedArray {
+    T items[N];
+    uint32_t count;
+
+    FixedArray() : count(0) {}
+
+    bool push_back(const T& item) {
+        if (count == N) {
+            return false;
+        }
+        items[count++] = item;
+        return true;
+    }
+    bool resize(size_t size) {
+        if (size > N) {
+            return false;
+        }
+        count = (uint32_t)size;
+        return true;
+    }
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    static constexpr size_t capacity() { return N; }
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+};
+
+constexpr size_t varintSize(uint64_t value) {
+    return value < 0x80 ? 1 : 1 + varintSize(value >> 7);
+}
+
+class WireWriter {
+public:
+    WireWriter(uint8_t* buffer, size_t capacity)
+        : start(buffer), pos(buffer), limit(buffer + capacity), overflow(false) {}
+
+    void putByte(uint8_t value) {
+        if (pos == limit) {
+            overflow = true;
+            return;
+        }
+        *pos++ = value;
+    }
+
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            putByte((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        putByte((uint8_t)value);
+    }
+
+    void putZigZag(int64_t value) {
+        putVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    // Bytes is fixed by the generator, so this unrolls to plain stores
+    template <size_t Bytes>
+    void putPacked(uint64_t value) {
+        static_assert(Bytes >= 1 && Bytes <= 8, "packed groups are 1 to 8 bytes");
+        if ((size_t)(limit - pos) < Bytes) {
+            overflow = true;
+            return;
+        }
+        for (size_t i = 0; i < Bytes; ++i) {
+            pos[i] = (uint8_t)(value >> (8 * i));
+        }
+        pos += Bytes;
+    }
+
+    void putFloat(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putPacked<4>(bits);
+    }
+
+    template <size_t N>
+    void putString(const FixedString<N>& value) {
+        putVarint(value.length);
+        if ((size_t)(limit - pos) < value.length) {
+            overflow = true;
+            return;
+        }
+        memcpy(pos, value.data, value.length);
+        pos += value.length;
+    }
+
+    bool ok() const { return !overflow; }
+    size_t size() const { return (size_t)(pos - start); }
+
+private:
+    uint8_t* start;
+    uint8_t* pos;
+    uint8_t* limit;
+    bool overflow;
+};
+
+// Every get* returns false on truncated or out-of-range input
+class WireReader {
+public:
+    WireReader(const uint8_t* data, size_t len)
+        : pos(data), limit(data + len) {}
+
+    bool getByte(uint8_t& value) {
+        if (pos == limit) {
+            return false;
+        }
+        value = *pos++;
+        return true;
+    }
+
+    template <typename T>
+    bool getVarint(T& value) {
+        static_assert(std::is_unsigned<T>::value, "varints decode into unsigned types");
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == limit) {
+                return false;
+            }
+            uint8_t byte = *pos++;
+            result |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                if (result > std::numeric_limits<T>::max()) {
+                    return false;
+                }
+                value = (T)result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool getZigZag(T& value) {
+        typename std::make_unsigned<T>::type raw;
+        if (!getVarint(raw)) {
+            return false;
+        }
+        value = (T)(raw >> 1) ^ -(T)(raw & 1);
+        return true;
+    }
+
+    template <size_t Bytes>
+    bool getPacked(uint64_t& value) {
+        static_assert(Bytes >= 1 && Bytes <= 8, "packed groups are 1 to 8 bytes");
+        if ((size_t)(limit - pos) < Bytes) {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < Bytes; ++i) {
+            value |= (uint64_t)pos[i] << (8 * i);
+        }
+        pos += Bytes;
+        return true;
+    }
+
+    bool getFloat(float& value) {
+        uint64_t bits;
+        if (!getPacked<4>(bits)) {
+            return false;
+        }
+        uint32_t narrow = (uint32_t)bits;
+        memcpy(&value, &narrow, sizeof(value));
+        return true;
+    }
+
+    template <size_t N>
+    bool getString(FixedString<N>& value) {
+        uint32_t length;
+        if (!getVarint(length) || length > N || (size_t)(limit - pos) < length) {
+            return false;
+        }
+        memcpy(value.data, pos, length);
+        value.length = length;
+        pos += length;
+        return true;
+    }
+
+    bool atEnd() const { return pos == limit; }
+    size_t remaining() const { return (size_t)(limit - pos); }
+
+private:
+    const uint8_t* pos;
+    const uint8_t* limit;
+};
+
+// Id of the frame in data, or 0 if it is not a binary frame
+inline uint8_t peekMessageId(const uint8_t* data, size_t len) {
+    return len >= FRAME_HEADER_SIZE && data[0] == FRAME_MAGIC ? data[1] : 0;
+}
+
+// A connection sends text commands, one per read, until BINARY_COMMAND on a
+// line of its own. The server answers BINARY_REPLY, and every byte after the
+// command is frames from then on.
+const char BINARY_COMMAND[] = "BINARY";
+const char BINARY_REPLY[] = "BINARY\n";
+
+// Length of BINARY_COMMAND and its line ending at the start of a read, or 0
+inline size_t binaryCommandLength(const char* data, size_t len) {
+    const size_t commandLen = sizeof(BINARY_COMMAND) - 1;
+    if (len < commandLen || std::memcmp(data, BINARY_COMMAND, commandLen) != 0) {
+        return 0;
+    }
+    size_t end = commandLen;
+    if (end < len && data[end] == '\r') {
+        ++end;
+    }
+    if (end < len && data[end] == '\n') {
+        return end + 1;
+    }
+    return end == len ? end : 0;
+}
+
+enum class FrameStatus { Complete, Incomplete, Invalid };
+
+// Finds the frame at the start of a stream buffer and sets size to its
+// length once it is Complete. Invalid when data does not start with
+// FRAME_MAGIC or the length prefix is corrupt or makes the frame longer than
+// maxSize; nothing after that point can be split into frames.
+inline FrameStatus findFrame(const uint8_t* data, size_t len, size_t maxSize, size_t& size) {
+    if (len > 0 && data[0] != FRAME_MAGIC) {
+        return FrameStatus::Invalid;
+    }
+    if (len <= FRAME_HEADER_SIZE) {
+        return FrameStatus::Incomplete;
+    }
+    WireReader reader(data + FRAME_HEADER_SIZE, len - FRAME_HEADER_SIZE);
+    uint64_t bodySize;
+    if (!reader.getVarint(bodySize)) {
+        // Truncated, unless the prefix already has more bytes than any length needs
+        return len - FRAME_HEADER_SIZE < varintSize(maxSize) ? FrameStatus::Incomplete : FrameStatus::Invalid;
+    }
+    size_t headerSize = len - reader.remaining();
+    if (bodySize > maxSize - std::min(maxSize, headerSize)) {
+        return FrameStatus::Invalid;
+    }
+    if (reader.remaining() < bodySize) {
+        return FrameStatus::Incomplete;
+    }
+    size = headerSize + (size_t)bodySize;
+    return FrameStatus::Complete;
+}
+
+// Returns the frame size, or 0 if capacity is too small. A buffer of
+// Message::MAX_FRAME_SIZE bytes always fits.
+template <typename Message>
+size_t encodeMessage(const Message& message, uint8_t* buffer, size_t capacity) {
+    // Fields go after room for the longest length prefix, then move up
+    // behind the actual one
+    const size_t reserved = FRAME_HEADER_SIZE + varintSize(Message::MAX_ENCODED_SIZE);
+    if (capacity < reserved) {
+        return 0;
+    }
+    WireWriter body(buffer + reserved, capacity - reserved);
+    encodeFields(body, message);
+    if (!body.ok()) {
+        return 0;
+    }
+    WireWriter header(buffer, reserved);
+    header.putByte(FRAME_MAGIC);
+    header.putByte(Message::MESSAGE_ID);
+    header.putVarint(body.size());
+    if (header.size() < reserved) {
+        memmove(buffer + header.size(), buffer + reserved, body.size());
+    }
+    return header.size() + body.size();
+}
+
+// The whole buffer must be exactly one frame of this message type; use
+// findFrame() to cut frames from a stream first
+template <typename Message>
+bool decodeMessage(const uint8_t* data, size_t len, Message& message) {
+    if (peekMessageId(data, len) != Message::MESSAGE_ID) {
+        return false;
+    }
+    WireReader reader(data + FRAME_HEADER_SIZE, len - FRAME_HEADER_SIZE);
+    uint64_t bodySize;
+    if (!reader.getVarint(bodySize) || bodySize != reader.remaining()) {
+        return false;
+    }
+    return decodeFields(reader, message) && reader.atEnd();
+}
+
+} // namespace protocol
+
+#endif // WIREFORMAT_H
@@ -0,0 +1,142 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Counters and histograms are sharded per thread on separate cache lines so
+// hot paths never contend; shards are only summed when a value is read.
+const size_t METRICS_MAX_THREADS = 64;
+const size_t METRICS_CACHE_LINE = 64;
+
+// Stable small index for the calling thread, shared by every metric
+inline size_t metricsThreadSlot() {
+    static std::atomic<size_t> nextSlot(0);
+    thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % METRICS_MAX_THREADS;
+    return slot;
+}
+
+class Counter {
+public:
+    Counter(const std::string& name, const std::string& help);
+
+    void inc(uint64_t n = 1) {
+        shards[metricsThreadSlot()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+    const std::string& getName() const { return name; }
+    const std::string& getHelp() const { return help; }
+
+private:
+    struct alignas(METRICS_CACHE_LINE) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::string name;
+    std::string help;
+    Shard shards[METRICS_MAX_THREADS];
+};
+
+class Gauge {
+public:
+    Gauge(const std::string& name, const std::string& help);
+
+    void set(int64_t v) { current.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { current.fetch_add(n, std::memory_order_relaxed); }
+    void sub(int64_t n) { current.fetch_sub(n, std::memory_order_relaxed); }
+    int64_t value() const { return current.load(std::memory_order_relaxed); }
+
+    const std::string& getName() const { return name; }
+    const std::string& getHelp() const { return help; }
+
+private:
+    std::string name;
+    std::string help;
+    alignas(METRICS_CACHE_LINE) std::atomic<int64_t> current;
+};
+
+// Merged view of a histogram at one point in time
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    // Upper bound of the bucket holding the p-th quantile (0.0 - 1.0)
+    uint64_t percentile(double p) const;
+    double mean() const { return count ? (double)sum / (double)count : 0.0; }
+};
+
+// HDR-style log-linear histogram: exact below 32, then 16 sub-buckets per
+// power of two (about 6% relative error) up to 2^40.
+class Histogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const size_t LINEAR_BUCKETS = 32;
+    static const size_t BUCKET_COUNT = LINEAR_BUCKETS + 35 * (1 << SUB_BUCKET_BITS);
+
+    Histogram(const std::string& name, const std::string& help);
+    ~Histogram();
+
+    void record(uint64_t v);
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t v);
+    static uint64_t bucketUpperBound(size_t index);
+
+    const std::string& getName() const { return name; }
+    const std::string& getHelp() const { return help; }
+
+private:
+    struct alignas(METRICS_CACHE_LINE) Shard {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+        std::atomic<uint64_t> buckets[BUCKET_COUNT];
+        Shard();
+    };
+
+    Shard* getShard();
+
+    std::string name;
+    std::string help;
+    // Allocated the first time a thread records into its slot
+    std::atomic<Shard*> shards[METRICS_MAX_THREADS];
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& getInstance();
+
+    // Get-or-create; returned references stay valid for the process lifetime,
+    // so callers should look metrics up once and keep the reference.
+    Counter& counter(const std::string& name, const std::string& help = "");
+    Gauge& gauge(const std::string& name, const std::string& help = "");
+    Histogram& histogram(const std::string& name, const std::string& help = "");
+
+    // Prometheus text exposition format (version 0.0.4)
+    std::string renderPrometheus();
+
+    std::vector<std::pair<std::string, uint64_t>> counterValues();
+    std::vector<std::pair<std::string, int64_t>> gaugeValues();
+    std::vector<std::pair<std::string, HistogramSnapshot>> histogramSnapshots();
+
+private:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    std::mutex registryMutex;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+#endif // METRICS_H
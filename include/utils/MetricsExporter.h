@@ -0,0 +1,51 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Serves MetricsRegistry in Prometheus text format on 127.0.0.1:<port>/metrics.
+// Runs on its own thread so scrapes never touch the game loop.
+class MetricsExporter {
+public:
+    using Handler = std::function<std::string()>;
+    MetricsExporter();
+    ~MetricsExporter();
+
+    // Port 0 picks a free port, see getPort()
+    bool start(int port);
+    void stop();
+
+    // Extra admin pages served next to /metrics; handlers run on the exporter thread
+    void addHandler(const std::string& path, Handler handler,
+                    const std::string& contentType = "text/plain");
+
+    int getPort() const { return boundPort; }
+    bool isRunning() const { return running; }
+
+private:
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    void serve();
+    void handleRequest(int client);
+
+    struct Page {
+        Handler handler;
+        std::string contentType;
+    };
+
+    std::mutex pagesMutex;
+    std::map<std::string, Page> pages;
+
+    int listenFd;
+    int boundPort;
+    std::atomic<bool> running;
+    std::thread worker;
+};
+
+#endif // METRICSEXPORTER_H
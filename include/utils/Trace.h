@@ -0,0 +1,137 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+// Scoped hot-path tracing exported as Chrome trace-event JSON
+// (open in chrome://tracing or https://ui.perfetto.dev).
+//
+//   TRACE_SCOPE("GameServer::HandleGameLogic");
+//
+// Each thread records complete events into its own fixed-size ring, so a
+// scope costs two timestamp reads and one store when enabled and a single
+// relaxed load when disabled. Old events are overwritten once a ring wraps.
+
+// Raw timestamp: TSC on x86, steady_clock nanoseconds elsewhere
+inline uint64_t traceTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct TraceEvent {
+    const char* name;   // must be a string literal or otherwise outlive the tracer
+    uint64_t start;
+    uint64_t end;
+};
+
+class TraceBuffer {
+public:
+    static const size_t CAPACITY = 16384;   // power of two
+
+    TraceBuffer(uint32_t threadId) : threadId(threadId), position(0) {}
+
+    void record(const char* name, uint64_t start, uint64_t end) {
+        uint64_t pos = position.load(std::memory_order_relaxed);
+        TraceEvent& event = events[pos & (CAPACITY - 1)];
+        event.name = name;
+        event.start = start;
+        event.end = end;
+        position.store(pos + 1, std::memory_order_release);
+    }
+
+    uint32_t threadId;
+    std::string threadName;
+    std::atomic<uint64_t> position;
+    TraceEvent events[CAPACITY];
+};
+
+class Tracer {
+public:
+    static Tracer& getInstance();
+
+    void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Label for the calling thread in the exported trace
+    void setThreadName(const std::string& name);
+
+    // Calling thread's ring, created on first use
+    TraceBuffer& threadBuffer() {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            buffer = registerThread();
+        }
+        return *buffer;
+    }
+
+    // Async-signal-safe: only sets a flag picked up by consumeDumpRequest()
+    void requestDump() { dumpRequested.store(true, std::memory_order_relaxed); }
+    bool consumeDumpRequest() { return dumpRequested.exchange(false, std::memory_order_relaxed); }
+
+    void writeChromeJson(std::ostream& out);
+    std::string renderChromeJson();
+    bool dumpToFile(const std::string& filename);
+
+private:
+    Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    TraceBuffer* registerThread();
+    double toMicroseconds(uint64_t timestamp) const;
+
+    std::atomic<bool> enabled;
+    std::atomic<bool> dumpRequested;
+
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+    // Timestamp calibration against steady_clock
+    uint64_t baseTimestamp;
+    double ticksPerMicrosecond;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : name(name), start(Tracer::getInstance().isEnabled() ? traceTimestamp() : 0) {}
+
+    ~TraceScope() {
+        if (start != 0) {
+            Tracer::getInstance().threadBuffer().record(name, start, traceTimestamp());
+        }
+    }
+
+private:
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    const char* name;
+    uint64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef GAMESERVER_DISABLE_TRACING
+    #define TRACE_SCOPE(name)
+#else
+    #define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#endif
+
+#endif // TRACE_H
@@ -1,65 +1,270 @@
+#include "cluster/ClusterNode.h"
 #include "core/GameServer.h"
+#include "core/RateLimiter.h"
+#include "core/TlsContext.h"
+#include "game/LeaderboardService.h"
+#include "persistence/WriteBehindStore.h"
 #include "utils/Logger.h"
+#include "utils/MetricsExporter.h"
+#include "utils/Trace.h"
 #include <thread>
 #include <chrono>
 #include <csignal>
+#include <cstdlib>
+#include <string>
 
-volatile bool server_running = true;
-// Signal handler for graceful shutdown
+volatile sig_atomic_t server_running = 1;
+volatile sig_atomic_t received_signal = 0;
+GameServer* running_server = nullptr;
+// Signal handler for graceful shutdown. Only async-signal-safe work here:
+// flags, and requestShutdown() which just writes to the server's wakeup fd.
+// Logging happens on the main thread once it sees the flag.
 void signal_handler(int signal) {
-    LOG_INFO("Received signal " + std::to_string(signal) + ". Shutting down server...");
-    server_running = false;
+    received_signal = signal;
+    server_running = 0;
+    if (running_server) {
+        running_server->requestShutdown();
+    }
+}
+#ifdef SIGUSR1
+// SIGUSR1 asks the main loop to write the trace buffers to a file
+void trace_signal_handler(int) {
+    Tracer::getInstance().requestDump();
 }
-int main() {
+#endif
+int main(int argc, char* argv[]) {
     // Set up signal handlers for graceful shutdown
     signal(SIGINT, signal_handler);
 #ifdef SIGTERM
     signal(SIGTERM, signal_handler);
+#endif
+#ifdef SIGUSR1
+    signal(SIGUSR1, trace_signal_handler);
 #endif
     GameServer server;
+    // Signals during startup must reach the server too, or run() never returns
+    running_server = &server;
+    Tracer::getInstance().setThreadName("main");
+
+    // I/O backend: --io-backend=<select|io_uring>, or GAMESERVER_IO_BACKEND
+    std::string backendName;
+    if (const char* env = std::getenv("GAMESERVER_IO_BACKEND")) {
+        backendName = env;
+    }
+    int port = 8080;
+    // Prometheus text endpoint on 127.0.0.1, --metrics-port=0 disables it
+    int metricsPort = 9100;
+    // Rooms are saved here when a drain finishes and restored on the next
+    // start; off unless --state-file= names a file
+    std::string stateFile;
+    int drainTimeoutMs = 5000;
+    // Hot restart: a running server listens here, --takeover connects to it
+    std::string handoffSocket = "gameserver.sock";
+    bool takeover = false;
+    // Player stats and match history: --storage=<file|memory|none>
+    std::string storageType = "file";
+    std::string dataDir = "data";
+    // Leaderboards are per season; a new season starts with empty boards
+    std::string season = "1";
+    // Cluster node mode: rooms come from GameRouter through this control port
+    int clusterPort = 0;
+    // Per-IP and per-connection flood limits, --rate-limit=off disables them
+    bool rateLimit = true;
+    RateLimitConfig rateLimits;
+    // Encrypted transport: --tls with --tls-cert/--tls-key, or a self-signed
+    // certificate for testing when only --tls is given
+    bool useTls = false;
+    TlsConfig tlsConfig;
+    // Spectators see each room this long after the players do
+    int spectatorDelayMs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--io-backend=", 0) == 0) {
+            backendName = arg.substr(13);
+        } else if (arg.rfind("--port=", 0) == 0) {
+            port = std::atoi(arg.substr(7).c_str());
+        } else if (arg.rfind("--metrics-port=", 0) == 0) {
+            metricsPort = std::atoi(arg.substr(15).c_str());
+        } else if (arg.rfind("--state-file=", 0) == 0) {
+            stateFile = arg.substr(13);
+        } else if (arg.rfind("--drain-timeout=", 0) == 0) {
+            drainTimeoutMs = std::atoi(arg.substr(16).c_str());
+        } else if (arg.rfind("--handoff-socket=", 0) == 0) {
+            handoffSocket = arg.substr(17);
+        } else if (arg == "--takeover") {
+            takeover = true;
+        } else if (arg.rfind("--storage=", 0) == 0) {
+            storageType = arg.substr(10);
+        } else if (arg.rfind("--data-dir=", 0) == 0) {
+            dataDir = arg.substr(11);
+        } else if (arg.rfind("--season=", 0) == 0) {
+            season = arg.substr(9);
+        } else if (arg.rfind("--cluster-port=", 0) == 0) {
+            clusterPort = std::atoi(arg.substr(15).c_str());
+        } else if (arg.rfind("--rate-limit=", 0) == 0) {
+            rateLimit = arg.substr(13) != "off";
+        } else if (arg.rfind("--max-connections-per-ip=", 0) == 0) {
+            rateLimits.maxConnectionsPerIp = (uint32_t)std::atoi(arg.substr(25).c_str());
+        } else if (arg == "--tls") {
+            useTls = true;
+        } else if (arg.rfind("--tls-cert=", 0) == 0) {
+            useTls = true;
+            tlsConfig.certFile = arg.substr(11);
+        } else if (arg.rfind("--tls-key=", 0) == 0) {
+            useTls = true;
+            tlsConfig.keyFile = arg.substr(10);
+        } else if (arg.rfind("--ktls=", 0) == 0) {
+            tlsConfig.kernelOffload = arg.substr(7) != "off";
+        } else if (arg.rfind("--spectator-delay=", 0) == 0) {
+            spectatorDelayMs = std::atoi(arg.substr(18).c_str());
+        } else if (arg == "--trace") {
+            // Trace scopes record from startup instead of waiting for /debug/trace/start
+            Tracer::getInstance().setEnabled(true);
+        }
+    }
+    if (!backendName.empty()) {
+        IoBackend backend;
+        if (!GameServer::parseIoBackend(backendName, backend)) {
+            LOG_ERR("Unknown I/O backend: " + backendName);
+            return 1;
+        }
+        server.setIoBackend(backend);
+    }
+    std::unique_ptr<WriteBehindStore> persistence;
+    if (storageType != "none") {
+        auto storage = createStorageBackend(storageType, dataDir);
+        if (!storage) {
+            LOG_ERR("Unknown storage backend: " + storageType);
+            return 1;
+        }
+        persistence.reset(new WriteBehindStore(std::move(storage), dataDir + "/journal"));
+    }
+    server.setStateFile(stateFile);
+    server.setDrainTimeout(std::chrono::milliseconds(drainTimeoutMs));
+    if (rateLimit) {
+        server.setRateLimits(rateLimits);
+    }
+    if (useTls && !server.enableTls(tlsConfig)) {
+        return 1;
+    }
+    server.setSpectatorDelay(std::chrono::milliseconds(spectatorDelayMs));
     
-    // Create some sample rooms
-    auto room1 = server.createRoom("Battle Room", 4);
-    auto room2 = server.createRoom("Casual Game", 2);
-    
-    // Create some players
-    auto player1 = std::make_shared<Player>(1, "Alice");
-    auto player2 = std::make_shared<Player>(2, "Bob");
-    auto player3 = std::make_shared<Player>(3, "Charlie");
-    
-    // Add players to rooms
-    room1->addPlayer(player1);
-    room1->addPlayer(player2);
-    
-    room2->addPlayer(player3);
-    
-    // List all rooms
-    server.listRooms();
-    
-    // Start a game in room1
-    room1->startGame();
-    
-    LOG_INFO("After starting game:");
-    server.listRooms();
-    
-    // Simulate server running
-    LOG_INFO("Server is running... (Press Ctrl+C to stop)");
-    
-    // Initialize and start the server
-    if (!server.initialize(8080)) {
-        LOG_ERR("Failed to initialize server!");
+    if (takeover) {
+        // Rooms, sessions and sockets all come from the running server
+        if (!server.takeOver(handoffSocket)) {
+            LOG_ERR("Hot restart failed, the running server keeps serving");
+            return 1;
+        }
+    } else {
+        if (!stateFile.empty() && server.loadRoomState(stateFile)) {
+            server.listRooms();
+        } else if (clusterPort == 0) {
+            // Create some sample rooms
+            auto room1 = server.createRoom("Battle Room", 4);
+            auto room2 = server.createRoom("Casual Game", 2);
+
+            // Create some players
+            auto player1 = std::make_shared<Player>(1, "Alice");
+            auto player2 = std::make_shared<Player>(2, "Bob");
+            auto player3 = std::make_shared<Player>(3, "Charlie");
+
+            // Add players to rooms
+            room1->addPlayer(player1);
+            room1->addPlayer(player2);
+
+            room2->addPlayer(player3);
+
+            // List all rooms
+            server.listRooms();
+
+            // Start a game in room1
+            room1->startGame();
+
+            LOG_INFO("After starting game:");
+            server.listRooms();
+        }
+
+        // Simulate server running
+        LOG_INFO("Server is running... (Press Ctrl+C to stop)");
+
+        // Initialize and start the server
+        if (!server.initialize(port)) {
+            LOG_ERR("Failed to initialize server!");
+            return 1;
+        }
+    }
+    // After a takeover the previous process still flushes its store and
+    // leaderboard snapshots; it closes the handoff channel once they are free
+    if (takeover && !server.waitForHandoffRelease()) {
+        LOG_WARN("Previous process did not release the store in time");
+    }
+    if (persistence) {
+        if (!persistence->start()) {
+            LOG_ERR("Failed to open storage in " + dataDir);
+            return 1;
+        }
+        server.setPersistence(persistence.get());
+    }
+    LeaderboardService leaderboards;
+    if (storageType == "file") {
+        leaderboards.setSnapshotDirectory(dataDir + "/leaderboards");
+    }
+    if (!LeaderboardService::isValidName(season) || !leaderboards.start()) {
+        LOG_ERR("Failed to start leaderboards for season " + season);
         return 1;
     }
-    LOG_INFO("Server is running on port 8080... (Press Ctrl+C to stop)");
+    server.setLeaderboards(&leaderboards, season);
+    ClusterNode clusterNode(server);
+    if (clusterPort > 0 && !clusterNode.start(clusterPort)) {
+        LOG_ERR("Failed to start the cluster control channel on port " + std::to_string(clusterPort));
+        return 1;
+    }
+    LOG_INFO("Server is running on port " + std::to_string(port) + "... (Press Ctrl+C to stop)");
+    if (!handoffSocket.empty()) {
+        server.enableHandoff(handoffSocket);
+    }
+
+    MetricsExporter metricsExporter;
+    if (metricsPort > 0) {
+        // Trace admin commands share the loopback metrics endpoint
+        metricsExporter.addHandler("/debug/trace", []() {
+            return Tracer::getInstance().renderChromeJson();
+        }, "application/json");
+        metricsExporter.addHandler("/debug/trace/start", []() {
+            Tracer::getInstance().setEnabled(true);
+            return std::string("tracing enabled\n");
+        });
+        metricsExporter.addHandler("/debug/trace/stop", []() {
+            Tracer::getInstance().setEnabled(false);
+            return std::string("tracing disabled\n");
+        });
+        // Only if the previous process did not release in time
+        int attempts = takeover ? 20 : 1;
+        while (!metricsExporter.start(metricsPort) && --attempts > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
     
     std::thread server_thread([&server]() {
         server.run();
     });
-    while(server_running) {
-        server.CleanUpRooms();
-        server.SendUpdatesToClients();
-        server.LogServerStats();
-        server.HandleGameLogic();
+    while(server_running && !server.hasHandedOff()) {
+        auto tick_start = std::chrono::steady_clock::now();
+        {
+            TRACE_SCOPE("tick");
+            server.CleanUpRooms();
+            server.SendUpdatesToClients();
+            server.LogServerStats();
+            server.HandleGameLogic();
+        }
+        server.recordTick(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - tick_start));
+
+        if (Tracer::getInstance().consumeDumpRequest()) {
+            auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            Tracer::getInstance().dumpToFile("trace-" + std::to_string(stamp) + ".json");
+        }
         static auto last_stats = std::chrono::steady_clock::now();
         auto now = std::chrono::steady_clock::now();
         if (std::chrono::duration_cast<std::chrono::seconds>(now - last_stats).count() >= 30) {
@@ -70,9 +275,27 @@ int main() {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
     
-    // Wait for server thread to finish
+    if (server.hasHandedOff()) {
+        LOG_INFO("New process took over, exiting");
+    } else {
+        LOG_INFO("Received signal " + std::to_string(received_signal) + ". Draining and shutting down server...");
+    }
+
+    // Wait for server thread to finish; it returns once the drain is done
     if (server_thread.joinable()) {
         server_thread.join();
     }
+    running_server = nullptr;
+    clusterNode.stop();
+    server.setLeaderboards(nullptr, season);
+    leaderboards.stop();
+    if (persistence) {
+        server.setPersistence(nullptr);
+        persistence->stop();
+    }
+    metricsExporter.stop();
+    // The new process waits for this after a hot restart
+    server.releaseHandoff();
+    LOG_INFO("Server stopped");
     return 0;
 }
\ No newline at end of file
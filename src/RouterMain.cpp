@@ -0,0 +1,99 @@
+#include "cluster/ClusterRouter.h"
+#include "utils/Logger.h"
+#include "utils/MetricsExporter.h"
+#include "utils/Trace.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cluster gateway: forwards game clients to the GameServer node that owns
+// their room, see ClusterRouter.h.
+//
+// Usage: GameRouter [--port=7000] [--control-port=7100] [--metrics-port=0]
+//                   --node=<name@host:gamePort:controlPort> [--node=...]
+//        GameRouter [--control-port=7100] --send="<command>"
+
+volatile sig_atomic_t router_running = 1;
+
+void signal_handler(int) {
+    router_running = 0;
+}
+
+int main(int argc, char* argv[]) {
+    signal(SIGINT, signal_handler);
+#ifdef SIGTERM
+    signal(SIGTERM, signal_handler);
+#endif
+    Tracer::getInstance().setThreadName("main");
+
+    int port = 7000;
+    int controlPort = 7100;
+    int metricsPort = 0;
+    std::vector<ClusterNodeInfo> nodes;
+    std::string command;
+    bool sendCommand = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--port=", 0) == 0) {
+            port = std::atoi(arg.substr(7).c_str());
+        } else if (arg.rfind("--control-port=", 0) == 0) {
+            controlPort = std::atoi(arg.substr(15).c_str());
+        } else if (arg.rfind("--metrics-port=", 0) == 0) {
+            metricsPort = std::atoi(arg.substr(15).c_str());
+        } else if (arg.rfind("--node=", 0) == 0) {
+            ClusterNodeInfo node;
+            if (!parseClusterNode(arg.substr(7), node)) {
+                std::cerr << "Expected --node=<name@host:gamePort:controlPort>, got " << arg << std::endl;
+                return 1;
+            }
+            nodes.push_back(node);
+        } else if (arg.rfind("--send=", 0) == 0) {
+            command = arg.substr(7);
+            sendCommand = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Operator mode: one control command against a running router
+    if (sendCommand) {
+        ControlClient client;
+        client.setAddress("127.0.0.1", controlPort);
+        std::string response;
+        bool ok = client.request(command, "", response);
+        (ok ? std::cout : std::cerr) << response << (response.empty() || response.back() == '\n' ? "" : "\n");
+        return ok ? 0 : 1;
+    }
+
+    ClusterRouter router;
+    for (const auto& node : nodes) {
+        std::string error;
+        if (!router.addNode(node, error)) {
+            LOG_ERR("Router: " + error);
+            return 1;
+        }
+    }
+    if (!router.start(port, controlPort)) {
+        LOG_ERR("Failed to start the router");
+        return 1;
+    }
+
+    MetricsExporter metricsExporter;
+    if (metricsPort > 0) {
+        metricsExporter.start(metricsPort);
+    }
+
+    while (router_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    LOG_INFO("Router shutting down");
+    metricsExporter.stop();
+    router.stop();
+    return 0;
+}
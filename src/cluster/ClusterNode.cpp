@@ -0,0 +1,65 @@
+#include "cluster/ClusterNode.h"
+#include "core/GameServer.h"
+#include "utils/Logger.h"
+#include "utils/Trace.h"
+#include <cstdlib>
+
+ClusterNode::ClusterNode(GameServer& server)
+    : server(server) {}
+
+ClusterNode::~ClusterNode() {
+    stop();
+}
+
+bool ClusterNode::start(int controlPort) {
+    bool started = control.start(controlPort, [this](const std::string& command, const std::string& payload,
+                                                    std::string& response) {
+        return handle(command, payload, response);
+    });
+    if (started) {
+        LOG_INFO("Cluster node: control channel on 127.0.0.1:" + std::to_string(control.getPort()));
+    }
+    return started;
+}
+
+void ClusterNode::stop() {
+    control.stop();
+}
+
+bool ClusterNode::handle(const std::string& command, const std::string& payload, std::string& response) {
+    TRACE_SCOPE("ClusterNode::handle");
+    if (command == "PING") {
+        response = "pong";
+        return true;
+    }
+    if (command == "ROOMS") {
+        response.clear();
+        for (int roomId : server.getRoomIds()) {
+            response += std::to_string(roomId) + "\n";
+        }
+        return true;
+    }
+    if (command.compare(0, 7, "EXPORT ") == 0) {
+        int roomId = std::atoi(command.c_str() + 7);
+        if (!server.exportRoom(roomId, response)) {
+            response = "no room " + std::to_string(roomId);
+            return false;
+        }
+        return true;
+    }
+    if (command == "IMPORT") {
+        response = std::to_string(server.importRooms(payload));
+        return true;
+    }
+    if (command.compare(0, 5, "DROP ") == 0) {
+        int roomId = std::atoi(command.c_str() + 5);
+        if (!server.deleteRoom(roomId)) {
+            response = "no room " + std::to_string(roomId);
+            return false;
+        }
+        response = "dropped";
+        return true;
+    }
+    response = "unknown command: " + command;
+    return false;
+}
@@ -0,0 +1,906 @@
+#include "cluster/ClusterRouter.h"
+#include "protocol/GameProtocol.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include "utils/Trace.h"
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <netdb.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <errno.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <sstream>
+
+namespace {
+
+const char JOIN_PREFIX[] = "JOIN ";
+const char SPECTATE_PREFIX[] = "SPECTATE ";
+// Sessions that have not joined a room all go to the owner of this key
+const char LOBBY_KEY[] = "lobby";
+// A peer that stops reading is dropped once this much is queued for it
+const size_t MAX_BUFFERED_BYTES = 1024 * 1024;
+const int CREATE_ROOM_ATTEMPTS = 16;
+
+struct RouterMetrics {
+    Gauge& sessions;
+    Gauge& nodes;
+    Counter& roomsMigrated;
+    Counter& migrationFailures;
+    Counter& sessionsMoved;
+
+    RouterMetrics()
+        : sessions(MetricsRegistry::getInstance().gauge(
+              "gameserver_router_sessions", "Client sessions forwarded by the router"))
+        , nodes(MetricsRegistry::getInstance().gauge(
+              "gameserver_router_nodes", "Nodes on the router's hash ring"))
+        , roomsMigrated(MetricsRegistry::getInstance().counter(
+              "gameserver_router_rooms_migrated_total", "Rooms moved to their new owner after a ring change"))
+        , migrationFailures(MetricsRegistry::getInstance().counter(
+              "gameserver_router_migration_failures_total", "Room moves that failed, leaving the room on its old node"))
+        , sessionsMoved(MetricsRegistry::getInstance().counter(
+              "gameserver_router_sessions_moved_total", "Client sessions reconnected to another node")) {}
+};
+
+RouterMetrics& routerMetrics() {
+    static RouterMetrics metrics;
+    return metrics;
+}
+
+// Room id argument of JOIN or SPECTATE, parsed like GameServer does: a
+// positive number, then at most a line ending. 0 when it is anything else.
+int parseRoomId(const char* data, size_t len) {
+    std::string text(data, len);
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.pop_back();
+    }
+    if (text.empty() || !isdigit((unsigned char)text[0])) {
+        return 0;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long value = strtol(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || value <= 0 || value > INT_MAX) {
+        return 0;
+    }
+    return (int)value;
+}
+
+} // namespace
+
+ClusterRouter::ClusterRouter()
+    : maxRoomId(0)
+    , listenFd(-1)
+    , clientPort(0)
+    , wakeReadFd(-1)
+    , wakeWriteFd(-1)
+    , sessionCount(0)
+    , running(false) {}
+
+ClusterRouter::~ClusterRouter() {
+    stop();
+}
+
+void ClusterRouter::runOnLoop(const std::function<void()>& task) {
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> finished = done->get_future();
+    {
+        std::unique_lock<std::mutex> lock(tasksMutex);
+        if (!running) {
+            // No router thread to race with
+            lock.unlock();
+            task();
+            return;
+        }
+        tasks.push_back([task, done]() {
+            task();
+            done->set_value();
+        });
+    }
+#ifndef _WIN32
+    char byte = 1;
+    if (write(wakeWriteFd, &byte, 1) < 0) {
+        // Pipe full: the router thread is already awake
+    }
+#endif
+    finished.wait();
+}
+
+void ClusterRouter::runQueuedTasks() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+bool ClusterRouter::addNode(const ClusterNodeInfo& node, std::string& error) {
+    bool ok = false;
+    runOnLoop([this, &node, &error, &ok]() {
+        if (!ring.addNode(node)) {
+            error = "node " + node.name + " already exists";
+            return;
+        }
+        routerMetrics().nodes.set((int64_t)ring.size());
+        LOG_INFO("Router: node " + formatClusterNode(node) + " joined");
+        if (running) {
+            ok = rebalanceFrom(ring.getNodes());
+            if (!ok) {
+                error = "some rooms could not be moved, see the router log";
+            }
+        } else {
+            ok = true;
+        }
+    });
+    return ok;
+}
+
+bool ClusterRouter::removeNode(const std::string& name, std::string& error) {
+    bool ok = false;
+    runOnLoop([this, &name, &error, &ok]() {
+        const ClusterNodeInfo* found = ring.findNode(name);
+        if (!found) {
+            error = "no node " + name;
+            return;
+        }
+        ClusterNodeInfo departing = *found;
+        ring.removeNode(name);
+        routerMetrics().nodes.set((int64_t)ring.size());
+        LOG_INFO("Router: node " + name + " leaving");
+        if (!running) {
+            ok = true;
+            return;
+        }
+        // The departing node is scanned too, so all its rooms find a new owner
+        std::vector<ClusterNodeInfo> sources = ring.getNodes();
+        sources.push_back(departing);
+        ok = rebalanceFrom(sources);
+        controls.erase(name);
+        if (!ok) {
+            error = "some rooms could not be moved, see the router log";
+        }
+    });
+    return ok;
+}
+
+bool ClusterRouter::rebalance() {
+    bool ok = false;
+    runOnLoop([this, &ok]() { ok = rebalanceFrom(ring.getNodes()); });
+    return ok;
+}
+
+int ClusterRouter::createRoom(const std::string& name, int maxPlayers) {
+    int created = 0;
+    runOnLoop([this, &name, maxPlayers, &created]() {
+        std::string clean = name;
+        std::replace(clean.begin(), clean.end(), '\t', ' ');
+        std::replace(clean.begin(), clean.end(), '\n', ' ');
+        for (int attempt = 0; attempt < CREATE_ROOM_ATTEMPTS && !created; ++attempt) {
+            int roomId = ++maxRoomId;
+            const ClusterNodeInfo* owner = ring.ownerOfRoom(roomId);
+            if (!owner) {
+                return;
+            }
+            std::string record = "room\t" + std::to_string(roomId) + "\t" + std::to_string(maxPlayers) +
+                                 "\t0\t" + clean + "\n";
+            std::string reply;
+            if (!controlFor(*owner).request("IMPORT", record, reply)) {
+                LOG_ERR("Router: cannot create room on " + owner->name + ": " + reply);
+                return;
+            }
+            // "0" means the id was taken on that node; try the next one
+            if (reply != "0") {
+                roomNodes[roomId] = owner->name;
+                created = roomId;
+            }
+        }
+    });
+    return created;
+}
+
+std::vector<ClusterNodeInfo> ClusterRouter::getNodes() {
+    std::vector<ClusterNodeInfo> nodes;
+    runOnLoop([this, &nodes]() { nodes = ring.getNodes(); });
+    return nodes;
+}
+
+std::string ClusterRouter::describeRooms() {
+    std::string out;
+    runOnLoop([this, &out]() {
+        for (const auto& pair : roomNodes) {
+            out += std::to_string(pair.first) + " " + pair.second + "\n";
+        }
+    });
+    return out;
+}
+
+const ClusterNodeInfo* ClusterRouter::nodeForRoom(int roomId) {
+    // A room whose move failed stays where it is until the next rebalance
+    auto it = roomNodes.find(roomId);
+    if (it != roomNodes.end()) {
+        const ClusterNodeInfo* node = ring.findNode(it->second);
+        if (node) {
+            return node;
+        }
+    }
+    return ring.ownerOfRoom(roomId);
+}
+
+ControlClient& ClusterRouter::controlFor(const ClusterNodeInfo& node) {
+    auto& client = controls[node.name];
+    if (!client) {
+        client.reset(new ControlClient());
+    }
+    client->setAddress(node.host, node.controlPort);
+    return *client;
+}
+
+bool ClusterRouter::rebalanceFrom(const std::vector<ClusterNodeInfo>& sources) {
+    TRACE_SCOPE("ClusterRouter::rebalance");
+    bool ok = true;
+    // A room listed by two nodes was copied by a move whose DROP failed
+    std::map<int, std::vector<const ClusterNodeInfo*>> holders;
+    for (const auto& source : sources) {
+        std::string reply;
+        if (!controlFor(source).request("ROOMS", "", reply)) {
+            LOG_ERR("Router: cannot list rooms on " + source.name + ": " + reply);
+            ok = false;
+            continue;
+        }
+        std::istringstream ids(reply);
+        int roomId;
+        while (ids >> roomId) {
+            maxRoomId = std::max(maxRoomId, roomId);
+            holders[roomId].push_back(&source);
+        }
+    }
+
+    std::map<int, std::string> located;
+    for (const auto& pair : holders) {
+        int roomId = pair.first;
+        const ClusterNodeInfo* live = pair.second.front();
+        if (pair.second.size() > 1) {
+            // Sessions were routed to the copy recorded in roomNodes, the others are stale
+            auto known = roomNodes.find(roomId);
+            live = nullptr;
+            for (const ClusterNodeInfo* holder : pair.second) {
+                if (known != roomNodes.end() && holder->name == known->second) {
+                    live = holder;
+                }
+            }
+            if (!live) {
+                LOG_ERR("Router: room " + std::to_string(roomId) + " is on " +
+                        std::to_string(pair.second.size()) + " nodes and none is known to be live, leaving it");
+                ok = false;
+                continue;
+            }
+            for (const ClusterNodeInfo* holder : pair.second) {
+                std::string reply;
+                if (holder != live && !controlFor(*holder).request("DROP " + std::to_string(roomId), "", reply)) {
+                    LOG_WARN("Router: cannot drop stale room " + std::to_string(roomId) + " on " +
+                             holder->name + ": " + reply);
+                    ok = false;
+                }
+            }
+        }
+        const ClusterNodeInfo* owner = ring.ownerOfRoom(roomId);
+        if (owner && owner->name != live->name && migrateRoom(roomId, *live, *owner)) {
+            located[roomId] = owner->name;
+        } else {
+            if (owner && owner->name != live->name) {
+                ok = false;
+            }
+            located[roomId] = live->name;
+        }
+    }
+    if (ok) {
+        roomNodes.swap(located);
+    } else {
+        // Keep what we knew about nodes that did not answer
+        for (const auto& pair : located) {
+            roomNodes[pair.first] = pair.second;
+        }
+    }
+    rehomeSessions();
+    return ok;
+}
+
+bool ClusterRouter::migrateRoom(int roomId, const ClusterNodeInfo& from, const ClusterNodeInfo& to) {
+    const std::string id = std::to_string(roomId);
+    // The source keeps the room until the target has it, so a lost reply
+    // at any step leaves at least one copy
+    std::string data;
+    if (!controlFor(from).request("EXPORT " + id, "", data)) {
+        LOG_ERR("Router: cannot export room " + id + " from " + from.name + ": " + data);
+        routerMetrics().migrationFailures.inc();
+        return false;
+    }
+    std::string reply;
+    if (!controlFor(to).request("IMPORT", data, reply)) {
+        // The import may have happened before the reply was lost
+        std::string dropped;
+        if (!controlFor(to).request("DROP " + id, "", dropped)) {
+            LOG_WARN("Router: " + to.name + " may keep a stale copy of room " + id);
+        }
+        LOG_ERR("Router: cannot import room " + id + " into " + to.name + ", it stays on " + from.name +
+                ": " + reply);
+        routerMetrics().migrationFailures.inc();
+        return false;
+    }
+    if (reply != "1") {
+        LOG_ERR("Router: " + to.name + " already has a room " + id + ", it stays on " + from.name);
+        routerMetrics().migrationFailures.inc();
+        return false;
+    }
+    std::string dropped;
+    if (!controlFor(from).request("DROP " + id, "", dropped)) {
+        // Sessions follow roomNodes to the new copy; the next rebalance drops this one
+        LOG_WARN("Router: cannot drop room " + id + " on " + from.name + " after the move: " + dropped);
+    }
+    routerMetrics().roomsMigrated.inc();
+    LOG_INFO("Router: moved room " + id + " from " + from.name + " to " + to.name);
+    return true;
+}
+
+#ifdef _WIN32
+
+bool ClusterRouter::start(int port, int controlPort) {
+    LOG_WARN("Cluster router is not supported on Windows");
+    return false;
+}
+
+void ClusterRouter::stop() {}
+void ClusterRouter::run() {}
+void ClusterRouter::acceptClients() {}
+void ClusterRouter::onClientReadable(Session& session) {}
+void ClusterRouter::onUpstreamReadable(Session& session) {}
+bool ClusterRouter::flushSession(Session& session) { return false; }
+void ClusterRouter::forwardFrames(Session& session) {}
+bool ClusterRouter::attach(Session& session, const ClusterNodeInfo& node) { return false; }
+void ClusterRouter::closeSession(int clientFd) {}
+void ClusterRouter::rehomeSessions() {}
+
+bool ClusterRouter::handleControl(const std::string& command, const std::string& payload, std::string& response) {
+    return false;
+}
+
+#else
+
+namespace {
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+int connectTo(const std::string& host, int port) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        return -1;
+    }
+    // Blocking connect: nodes run on the router's host, see ControlServer
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd >= 0) {
+        setNonBlocking(fd);
+    }
+    return fd;
+}
+
+// false when the peer is gone
+bool flushTo(int fd, std::string& buffer) {
+    while (!buffer.empty()) {
+        ssize_t sent = send(fd, buffer.data(), buffer.size(), MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        buffer.erase(0, (size_t)sent);
+    }
+    return true;
+}
+
+} // namespace
+
+bool ClusterRouter::start(int port, int controlPort) {
+    if (running) {
+        return true;
+    }
+    int pipeFds[2];
+    if (pipe(pipeFds) < 0) {
+        LOG_ERR("Router: cannot create wakeup pipe");
+        return false;
+    }
+    wakeReadFd = pipeFds[0];
+    wakeWriteFd = pipeFds[1];
+    fcntl(wakeReadFd, F_SETFL, O_NONBLOCK);
+    fcntl(wakeWriteFd, F_SETFL, O_NONBLOCK);
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int opt = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        LOG_ERR("Router: bind/listen on port " + std::to_string(port) + " failed: " + std::string(strerror(errno)));
+        close(wakeReadFd);
+        close(wakeWriteFd);
+        wakeReadFd = wakeWriteFd = -1;
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+        return false;
+    }
+    setNonBlocking(listenFd);
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, (struct sockaddr*)&addr, &len);
+    clientPort = ntohs(addr.sin_port);
+
+    // Rooms left on the wrong node by an earlier run move now
+    if (!rebalanceFrom(ring.getNodes())) {
+        LOG_WARN("Router: initial rebalance incomplete");
+    }
+
+    running = true;
+    worker = std::thread(&ClusterRouter::run, this);
+
+    if (controlPort >= 0) {
+        bool controlStarted = control.start(controlPort, [this](const std::string& command,
+                                                                const std::string& payload,
+                                                                std::string& response) {
+            return handleControl(command, payload, response);
+        });
+        if (!controlStarted) {
+            stop();
+            return false;
+        }
+        LOG_INFO("Router: control channel on 127.0.0.1:" + std::to_string(control.getPort()));
+    }
+    LOG_INFO("Router: forwarding clients on port " + std::to_string(clientPort) + " to " +
+             std::to_string(ring.size()) + " nodes");
+    return true;
+}
+
+void ClusterRouter::stop() {
+    control.stop();
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    char byte = 1;
+    if (write(wakeWriteFd, &byte, 1) < 0) {
+        // The thread notices running on its next poll timeout
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    runQueuedTasks();
+
+    std::vector<int> clients;
+    for (const auto& pair : sessions) {
+        clients.push_back(pair.first);
+    }
+    for (int clientFd : clients) {
+        closeSession(clientFd);
+    }
+    close(listenFd);
+    close(wakeReadFd);
+    close(wakeWriteFd);
+    listenFd = wakeReadFd = wakeWriteFd = -1;
+    controls.clear();
+}
+
+bool ClusterRouter::handleControl(const std::string& command, const std::string& payload, std::string& response) {
+    std::string verb = command.substr(0, command.find(' '));
+    std::string argument = command.size() > verb.size() ? command.substr(verb.size() + 1) : std::string();
+    if (verb == "NODES") {
+        response.clear();
+        for (const auto& node : getNodes()) {
+            response += formatClusterNode(node) + "\n";
+        }
+        return true;
+    }
+    if (verb == "ROOMS") {
+        response = describeRooms();
+        return true;
+    }
+    if (verb == "ADD_NODE") {
+        ClusterNodeInfo node;
+        if (!parseClusterNode(argument, node)) {
+            response = "expected <name>@<host>:<gamePort>:<controlPort>";
+            return false;
+        }
+        response = "added " + node.name;
+        return addNode(node, response);
+    }
+    if (verb == "REMOVE_NODE") {
+        response = "removed " + argument;
+        return removeNode(argument, response);
+    }
+    if (verb == "CREATE_ROOM") {
+        size_t space = argument.find(' ');
+        int maxPlayers = std::atoi(argument.c_str());
+        if (space == std::string::npos || maxPlayers <= 0) {
+            response = "expected CREATE_ROOM <maxPlayers> <name>";
+            return false;
+        }
+        int roomId = createRoom(argument.substr(space + 1), maxPlayers);
+        response = roomId ? std::to_string(roomId) : "no node accepted the room";
+        return roomId != 0;
+    }
+    if (verb == "REBALANCE") {
+        bool ok = rebalance();
+        response = ok ? "ok" : "incomplete, see the router log";
+        return ok;
+    }
+    response = "unknown command: " + verb;
+    return false;
+}
+
+void ClusterRouter::run() {
+    Tracer::getInstance().setThreadName("router");
+    std::vector<struct pollfd> pfds;
+    // For each pollfd past the first two: client fd, and whether it is the upstream
+    std::vector<std::pair<int, bool>> owners;
+
+    while (running) {
+        pfds.clear();
+        owners.clear();
+        pfds.push_back(pollfd{wakeReadFd, POLLIN, 0});
+        pfds.push_back(pollfd{listenFd, POLLIN, 0});
+        for (const auto& pair : sessions) {
+            const Session& session = pair.second;
+            // Hold client input until a rejoin is answered, the node reads one message per recv
+            short clientEvents = session.swallowReply ? 0 : POLLIN;
+            pfds.push_back(pollfd{session.clientFd,
+                                  (short)(clientEvents | (session.toClient.empty() ? 0 : POLLOUT)), 0});
+            owners.emplace_back(session.clientFd, false);
+            if (session.upstreamFd >= 0) {
+                pfds.push_back(pollfd{session.upstreamFd,
+                                      (short)(POLLIN | (session.toUpstream.empty() ? 0 : POLLOUT)), 0});
+                owners.emplace_back(session.clientFd, true);
+            }
+        }
+
+        int ready = poll(pfds.data(), pfds.size(), 200);
+        if (ready < 0 && errno != EINTR) {
+            LOG_ERR("Router: poll failed: " + std::string(strerror(errno)));
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        if (pfds[0].revents) {
+            char drain[64];
+            while (read(wakeReadFd, drain, sizeof(drain)) > 0) {
+            }
+            runQueuedTasks();
+        }
+        if (pfds[1].revents) {
+            acceptClients();
+        }
+        for (size_t i = 2; i < pfds.size(); ++i) {
+            if (!pfds[i].revents) {
+                continue;
+            }
+            // Earlier events in this round (or a task) may have closed or moved it
+            auto it = sessions.find(owners[i - 2].first);
+            bool isUpstream = owners[i - 2].second;
+            if (it == sessions.end() || (isUpstream && it->second.upstreamFd != pfds[i].fd)) {
+                continue;
+            }
+            Session& session = it->second;
+            if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (isUpstream) {
+                    onUpstreamReadable(session);
+                } else {
+                    onClientReadable(session);
+                }
+            } else if (!flushSession(session)) {
+                closeSession(session.clientFd);
+            }
+        }
+    }
+}
+
+void ClusterRouter::acceptClients() {
+    while (true) {
+        int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            return;
+        }
+        setNonBlocking(clientFd);
+        Session session;
+        session.clientFd = clientFd;
+        session.upstreamFd = -1;
+        session.roomId = 0;
+        session.spectating = false;
+        session.binary = false;
+        session.swallowReply = false;
+        sessions.emplace(clientFd, std::move(session));
+        sessionCount = sessions.size();
+        routerMetrics().sessions.set((int64_t)sessions.size());
+    }
+}
+
+void ClusterRouter::onClientReadable(Session& session) {
+    TRACE_SCOPE("ClusterRouter::onClientReadable");
+    char buffer[4096];
+    ssize_t received = recv(session.clientFd, buffer, sizeof(buffer), 0);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (received <= 0) {
+        closeSession(session.clientFd);
+        return;
+    }
+
+    if (session.binary) {
+        session.partialInput.append(buffer, (size_t)received);
+        // Held back while the node is being switched after a move
+        if (!session.swallowReply) {
+            forwardFrames(session);
+        }
+        if (session.partialInput.size() > MAX_BUFFERED_BYTES ||
+            session.toUpstream.size() > MAX_BUFFERED_BYTES || !flushSession(session)) {
+            closeSession(session.clientFd);
+        }
+        return;
+    }
+
+    // Same framing as GameServer::handle_input for text commands: one read, one message
+    const size_t joinLen = sizeof(JOIN_PREFIX) - 1;
+    const size_t spectateLen = sizeof(SPECTATE_PREFIX) - 1;
+    bool join = (size_t)received > joinLen && strncmp(buffer, JOIN_PREFIX, joinLen) == 0;
+    bool spectate = (size_t)received > spectateLen && strncmp(buffer, SPECTATE_PREFIX, spectateLen) == 0;
+    // A seated player cannot spectate; its node answers that without a move
+    if (spectate && session.roomId != 0 && !session.spectating) {
+        spectate = false;
+    }
+    if (join || spectate) {
+        size_t prefixLen = join ? joinLen : spectateLen;
+        int roomId = parseRoomId(buffer + prefixLen, (size_t)received - prefixLen);
+        const ClusterNodeInfo* owner = roomId > 0 ? nodeForRoom(roomId) : nullptr;
+        if (!owner || (owner->name != session.node && !attach(session, *owner))) {
+            session.toClient += (join ? "JOIN_FAILED " : "SPECTATE_FAILED ") + std::to_string(roomId) + "\n";
+            if (!flushSession(session)) {
+                closeSession(session.clientFd);
+            }
+            return;
+        }
+        session.roomId = roomId;
+        session.spectating = spectate;
+    } else if (session.upstreamFd < 0) {
+        const ClusterNodeInfo* lobby = ring.ownerOfKey(LOBBY_KEY);
+        if (!lobby || !attach(session, *lobby)) {
+            closeSession(session.clientFd);
+            return;
+        }
+    }
+
+    size_t switchLen = protocol::binaryCommandLength(buffer, (size_t)received);
+    if (switchLen > 0) {
+        session.binary = true;
+        session.toUpstream.append(buffer, switchLen);
+        session.partialInput.append(buffer + switchLen, (size_t)received - switchLen);
+        forwardFrames(session);
+    } else {
+        session.toUpstream.append(buffer, (size_t)received);
+    }
+    if (session.toUpstream.size() > MAX_BUFFERED_BYTES || !flushSession(session)) {
+        closeSession(session.clientFd);
+    }
+}
+
+void ClusterRouter::forwardFrames(Session& session) {
+    size_t complete = 0;
+    while (complete < session.partialInput.size()) {
+        size_t size = 0;
+        protocol::FrameStatus status = protocol::findFrame(
+            (const uint8_t*)session.partialInput.data() + complete, session.partialInput.size() - complete,
+            protocol::MAX_FRAME_SIZE, size);
+        if (status == protocol::FrameStatus::Incomplete) {
+            break;
+        }
+        // The node reports a broken stream and discards it; pass it all on
+        complete = status == protocol::FrameStatus::Complete ? complete + size : session.partialInput.size();
+    }
+    session.toUpstream.append(session.partialInput, 0, complete);
+    session.partialInput.erase(0, complete);
+}
+
+void ClusterRouter::onUpstreamReadable(Session& session) {
+    char buffer[4096];
+    ssize_t received = recv(session.upstreamFd, buffer, sizeof(buffer), 0);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (received <= 0) {
+        // The node went away under the session; the client reconnects
+        LOG_WARN("Router: node " + session.node + " closed a session");
+        closeSession(session.clientFd);
+        return;
+    }
+
+    const char* data = buffer;
+    size_t len = (size_t)received;
+    if (session.swallowReply) {
+        const char* newline = (const char*)memchr(data, '\n', len);
+        size_t take = newline ? (size_t)(newline - data) + 1 : len;
+        session.replyLine.append(data, take);
+        data += take;
+        len -= take;
+        if (newline) {
+            session.swallowReply = false;
+            if (session.replyLine != protocol::BINARY_REPLY) {
+                const std::string expected = session.spectating ? "SPECTATING " : "JOINED ";
+                if (session.replyLine.compare(0, expected.size(), expected) != 0) {
+                    LOG_WARN("Router: rejoin of room " + std::to_string(session.roomId) + " on " +
+                             session.node + " failed: " + session.replyLine);
+                    session.roomId = 0;
+                    session.spectating = false;
+                }
+                // Commands are one read each, so the switch waits for the rejoin's reply
+                if (session.binary) {
+                    session.toUpstream += std::string(protocol::BINARY_COMMAND) + "\n";
+                    session.swallowReply = true;
+                }
+            }
+            session.replyLine.clear();
+            if (session.binary && !session.swallowReply) {
+                forwardFrames(session);
+            }
+        }
+    }
+    if (session.spectating || session.binary) {
+        // Only whole frames go out, so a move to another node never leaves
+        // half of one on the client's stream
+        session.partialFrame.append(data, len);
+        size_t complete = 0;
+        while (complete < session.partialFrame.size()) {
+            size_t size = 0;
+            protocol::FrameStatus status = protocol::findFrame(
+                (const uint8_t*)session.partialFrame.data() + complete, session.partialFrame.size() - complete,
+                protocol::MAX_FRAME_SIZE, size);
+            if (status == protocol::FrameStatus::Incomplete) {
+                break;
+            }
+            if (status == protocol::FrameStatus::Complete) {
+                complete += size;
+                continue;
+            }
+            // Text replies pass through as they are, up to the end of the line
+            const char* start = session.partialFrame.data() + complete;
+            const char* newline = (const char*)memchr(start, '\n', session.partialFrame.size() - complete);
+            complete = newline ? (size_t)(newline - session.partialFrame.data()) + 1 : session.partialFrame.size();
+        }
+        session.toClient.append(session.partialFrame, 0, complete);
+        session.partialFrame.erase(0, complete);
+    } else {
+        session.toClient.append(data, len);
+    }
+    if (session.toClient.size() > MAX_BUFFERED_BYTES || !flushSession(session)) {
+        closeSession(session.clientFd);
+    }
+}
+
+bool ClusterRouter::flushSession(Session& session) {
+    if (!flushTo(session.clientFd, session.toClient)) {
+        return false;
+    }
+    return session.upstreamFd < 0 || flushTo(session.upstreamFd, session.toUpstream);
+}
+
+bool ClusterRouter::attach(Session& session, const ClusterNodeInfo& node) {
+    if (session.upstreamFd >= 0) {
+        // The old node sees a disconnect and drops the player from its room
+        close(session.upstreamFd);
+        session.upstreamFd = -1;
+        session.toUpstream.clear();
+        session.partialFrame.clear();
+        session.swallowReply = false;
+        session.replyLine.clear();
+    }
+    int fd = connectTo(node.host, node.gamePort);
+    if (fd < 0) {
+        LOG_ERR("Router: cannot reach node " + node.name + " at " + node.host + ":" +
+                std::to_string(node.gamePort));
+        session.node.clear();
+        return false;
+    }
+    session.upstreamFd = fd;
+    session.node = node.name;
+    return true;
+}
+
+void ClusterRouter::closeSession(int clientFd) {
+    auto it = sessions.find(clientFd);
+    if (it == sessions.end()) {
+        return;
+    }
+    if (it->second.upstreamFd >= 0) {
+        close(it->second.upstreamFd);
+    }
+    close(clientFd);
+    sessions.erase(it);
+    sessionCount = sessions.size();
+    routerMetrics().sessions.set((int64_t)sessions.size());
+}
+
+void ClusterRouter::rehomeSessions() {
+    std::vector<int> lost;
+    for (auto& pair : sessions) {
+        Session& session = pair.second;
+        if (session.upstreamFd < 0) {
+            continue;
+        }
+        const ClusterNodeInfo* target = session.roomId ? nodeForRoom(session.roomId)
+                                                       : ring.ownerOfKey(LOBBY_KEY);
+        if (target && target->name == session.node) {
+            continue;
+        }
+        if (!target || !attach(session, *target)) {
+            lost.push_back(session.clientFd);
+            continue;
+        }
+        if (session.roomId) {
+            session.toUpstream = std::string(session.spectating ? SPECTATE_PREFIX : JOIN_PREFIX) +
+                                 std::to_string(session.roomId);
+            session.swallowReply = true;
+        } else if (session.binary) {
+            session.toUpstream = std::string(protocol::BINARY_COMMAND) + "\n";
+            session.swallowReply = true;
+        }
+        routerMetrics().sessionsMoved.inc();
+        if (!flushSession(session)) {
+            lost.push_back(session.clientFd);
+        }
+    }
+    for (int clientFd : lost) {
+        closeSession(clientFd);
+    }
+}
+
+#endif
@@ -0,0 +1,299 @@
+#include "cluster/ControlChannel.h"
+#include "utils/Logger.h"
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <netdb.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const size_t MAX_LINE_BYTES = 4096;
+const size_t MAX_PAYLOAD_BYTES = 64 * 1024 * 1024;
+const int IO_TIMEOUT_SECONDS = 5;
+
+} // namespace
+
+ControlServer::ControlServer()
+    : listenFd(-1)
+    , boundPort(0)
+    , running(false) {}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+ControlClient::ControlClient()
+    : port(0)
+    , fd(-1) {}
+
+ControlClient::~ControlClient() {
+    close();
+}
+
+void ControlClient::setAddress(const std::string& newHost, int newPort) {
+    if (newHost != host || newPort != port) {
+        close();
+        host = newHost;
+        port = newPort;
+    }
+}
+
+#ifdef _WIN32
+
+bool ControlServer::start(int port, Handler handler) {
+    LOG_WARN("Cluster control channel is not supported on Windows");
+    return false;
+}
+
+void ControlServer::stop() {}
+void ControlServer::serve() {}
+bool ControlServer::handleRequest(int connection) { return false; }
+
+bool ControlClient::connect() { return false; }
+void ControlClient::close() {}
+
+bool ControlClient::request(const std::string& command, const std::string& payload, std::string& response) {
+    response = "not supported on Windows";
+    return false;
+}
+
+#else
+
+namespace {
+
+bool sendAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        offset += (size_t)sent;
+    }
+    return true;
+}
+
+bool recvAll(int fd, std::string& data, size_t len) {
+    data.resize(len);
+    size_t offset = 0;
+    while (offset < len) {
+        ssize_t received = recv(fd, &data[offset], len - offset, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        offset += (size_t)received;
+    }
+    return true;
+}
+
+// Lines are short and rare, so a byte at a time keeps the payload unbuffered
+bool recvLine(int fd, std::string& line) {
+    line.clear();
+    char c;
+    while (line.size() < MAX_LINE_BYTES) {
+        ssize_t received = recv(fd, &c, 1, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        if (c == '\n') {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        }
+        line.push_back(c);
+    }
+    return false;
+}
+
+bool recvFrame(int fd, std::string& head, std::string& payload) {
+    std::string lengthLine;
+    if (!recvLine(fd, head) || !recvLine(fd, lengthLine)) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long long length = std::strtoull(lengthLine.c_str(), &end, 10);
+    if (lengthLine.empty() || *end != '\0' || length > MAX_PAYLOAD_BYTES) {
+        return false;
+    }
+    return recvAll(fd, payload, (size_t)length);
+}
+
+std::string frame(const std::string& head, const std::string& payload) {
+    return head + "\n" + std::to_string(payload.size()) + "\n" + payload;
+}
+
+void setTimeouts(int fd) {
+    struct timeval timeout;
+    timeout.tv_sec = IO_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+} // namespace
+
+bool ControlServer::start(int port, Handler handler) {
+    if (running) {
+        return true;
+    }
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        LOG_ERR("Control channel: failed to create socket");
+        return false;
+    }
+    int opt = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Loopback only: the channel is unauthenticated
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        LOG_ERR("Control channel: bind/listen on port " + std::to_string(port) +
+                " failed: " + std::string(strerror(errno)));
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, (struct sockaddr*)&addr, &len);
+    boundPort = ntohs(addr.sin_port);
+
+    onRequest = std::move(handler);
+    running = true;
+    worker = std::thread(&ControlServer::serve, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    for (int connection : connections) {
+        ::close(connection);
+    }
+    connections.clear();
+    ::close(listenFd);
+    listenFd = -1;
+}
+
+void ControlServer::serve() {
+    while (running) {
+        std::vector<struct pollfd> pfds(connections.size() + 1);
+        pfds[0].fd = listenFd;
+        pfds[0].events = POLLIN;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            pfds[i + 1].fd = connections[i];
+            pfds[i + 1].events = POLLIN;
+        }
+        // Short poll timeout so stop() does not need to wake us up
+        if (poll(pfds.data(), pfds.size(), 200) <= 0) {
+            continue;
+        }
+
+        std::vector<int> closed;
+        for (size_t i = 1; i < pfds.size(); ++i) {
+            if (pfds[i].revents && !handleRequest(pfds[i].fd)) {
+                closed.push_back(pfds[i].fd);
+            }
+        }
+        for (int connection : closed) {
+            ::close(connection);
+            connections.erase(std::find(connections.begin(), connections.end(), connection));
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            int connection = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (connection >= 0) {
+                setTimeouts(connection);
+                connections.push_back(connection);
+            }
+        }
+    }
+}
+
+bool ControlServer::handleRequest(int connection) {
+    std::string command;
+    std::string payload;
+    if (!recvFrame(connection, command, payload)) {
+        return false;
+    }
+    std::string response;
+    bool ok = onRequest(command, payload, response);
+    return sendAll(connection, frame(ok ? "OK" : "ERR", response));
+}
+
+bool ControlClient::connect() {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        return false;
+    }
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0) {
+        return false;
+    }
+    setTimeouts(fd);
+    return true;
+}
+
+void ControlClient::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool ControlClient::request(const std::string& command, const std::string& payload, std::string& response) {
+    if (fd < 0 && !connect()) {
+        response = "cannot connect to " + host + ":" + std::to_string(port);
+        return false;
+    }
+    std::string status;
+    if (!sendAll(fd, frame(command, payload)) || !recvFrame(fd, status, response)) {
+        close();
+        response = "control connection to " + host + ":" + std::to_string(port) + " failed";
+        return false;
+    }
+    return status == "OK";
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "cluster/HashRing.h"
+#include <cstdlib>
+
+bool parseClusterNode(const std::string& spec, ClusterNodeInfo& node) {
+    size_t at = spec.find('@');
+    size_t controlColon = spec.rfind(':');
+    if (at == std::string::npos || at == 0 || controlColon == std::string::npos || controlColon < at) {
+        return false;
+    }
+    size_t gameColon = spec.rfind(':', controlColon - 1);
+    if (gameColon == std::string::npos || gameColon <= at + 1) {
+        return false;
+    }
+    node.name = spec.substr(0, at);
+    node.host = spec.substr(at + 1, gameColon - at - 1);
+    node.gamePort = std::atoi(spec.substr(gameColon + 1, controlColon - gameColon - 1).c_str());
+    node.controlPort = std::atoi(spec.substr(controlColon + 1).c_str());
+    return node.gamePort > 0 && node.gamePort < 65536 && node.controlPort > 0 && node.controlPort < 65536;
+}
+
+std::string formatClusterNode(const ClusterNodeInfo& node) {
+    return node.name + "@" + node.host + ":" + std::to_string(node.gamePort) + ":" +
+           std::to_string(node.controlPort);
+}
+
+HashRing::HashRing(int virtualNodes)
+    : virtualNodes(virtualNodes) {}
+
+uint64_t HashRing::hash(const std::string& key) {
+    // FNV-1a, then a splitmix64 finalizer so nearby keys spread over the ring
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+bool HashRing::addNode(const ClusterNodeInfo& node) {
+    if (node.name.empty() || nodes.count(node.name)) {
+        return false;
+    }
+    nodes[node.name] = node;
+    for (int i = 0; i < virtualNodes; ++i) {
+        // On the rare collision the earlier node keeps the point
+        ring.emplace(hash(node.name + "#" + std::to_string(i)), node.name);
+    }
+    return true;
+}
+
+bool HashRing::removeNode(const std::string& name) {
+    if (!nodes.erase(name)) {
+        return false;
+    }
+    for (auto it = ring.begin(); it != ring.end();) {
+        if (it->second == name) {
+            it = ring.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+const ClusterNodeInfo* HashRing::ownerOfHash(uint64_t point) const {
+    if (ring.empty()) {
+        return nullptr;
+    }
+    auto it = ring.lower_bound(point);
+    if (it == ring.end()) {
+        it = ring.begin();
+    }
+    return &nodes.at(it->second);
+}
+
+const ClusterNodeInfo* HashRing::ownerOfRoom(int roomId) const {
+    return ownerOfHash(hash("room/" + std::to_string(roomId)));
+}
+
+const ClusterNodeInfo* HashRing::ownerOfKey(const std::string& key) const {
+    return ownerOfHash(hash(key));
+}
+
+const ClusterNodeInfo* HashRing::findNode(const std::string& name) const {
+    auto it = nodes.find(name);
+    return it == nodes.end() ? nullptr : &it->second;
+}
+
+std::vector<ClusterNodeInfo> HashRing::getNodes() const {
+    std::vector<ClusterNodeInfo> list;
+    for (const auto& pair : nodes) {
+        list.push_back(pair.second);
+    }
+    return list;
+}
@@ -10,13 +10,197 @@
     #include <fcntl.h>
     #include <errno.h>
 #endif
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+#ifdef __linux__
+    #include <sys/eventfd.h>
+#endif
 
 #include "core/GameServer.h"
+#include "core/HotRestart.h"
+#include "core/RateLimiter.h"
+#include "core/TlsContext.h"
+#include "game/MatchResult.h"
+#include "persistence/WriteBehindStore.h"
+#include "game/LeaderboardService.h"
+#include "protocol/GameProtocol.h"
 #include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef GAMESERVER_HAS_IO_URING
+    #include "core/IoUringBackend.h"
+#endif
+
+static const char JOIN_COMMAND[] = "JOIN ";
+// "SPECTATE <roomId>" watches a room without taking a seat
+static const char SPECTATE_COMMAND[] = "SPECTATE ";
+// "TOP <n>" and "RANK" query the standard leaderboard of the current season
+static const char TOP_COMMAND[] = "TOP ";
+static const char RANK_COMMAND[] = "RANK";
+static const char TOP_MODE[] = "standard";
+static const size_t MAX_TOP_ENTRIES = 100;
+
+// protocol::ProtocolError codes
+static const uint32_t PROTOCOL_UNKNOWN_MESSAGE = 1;
+static const uint32_t PROTOCOL_MALFORMED_FRAME = 2;
+
+// select() path: a client whose unsent output grows past this is dropped
+static const size_t MAX_OUTBOUND_BYTES = 1024 * 1024;
+
+// Spectator frames: every this many ticks a keyframe with every player, deltas in between
+static const uint32_t SPECTATOR_KEYFRAME_TICKS = 10;
+// A spectator with more unsent output than this skips ahead to the next keyframe
+static const size_t SPECTATOR_BACKLOG_BYTES = 64 * 1024;
+// Keeps delayed frames inside a stream's ring at the main loop's 10 ticks per second
+static const std::chrono::milliseconds SPECTATOR_MAX_DELAY(20000);
+
+// Player ids are reserved in the store this many at a time
+static const int PLAYER_ID_BLOCK = 1000;
+static const char PLAYER_ID_KEY[] = "meta/next-player-id";
+
+// How often reads held back by a rate limit are offered again
+static const std::chrono::milliseconds THROTTLE_RETRY_INTERVAL(10);
+
+// How long a hot restart waits for queued output before handing the sockets over
+static const std::chrono::milliseconds HANDOFF_FLUSH_TIMEOUT(500);
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+namespace {
+
+// Looked up once; the registry keeps these alive for the process lifetime
+struct ServerMetrics {
+    Counter& connectionsAccepted;
+    Counter& connectionsClosed;
+    Gauge& connectionsActive;
+    Counter& bytesReceived;
+    Counter& bytesSent;
+    Counter& messagesReceived;
+    Counter& binaryFrames;
+    Counter& protocolErrors;
+    Gauge& rooms;
+    Gauge& roomsInGame;
+    Gauge& players;
+    Gauge& spectators;
+    Counter& handoffOutputBytes;
+    Histogram& tickDuration;
+
+    ServerMetrics()
+        : connectionsAccepted(MetricsRegistry::getInstance().counter(
+              "gameserver_connections_accepted_total", "Client connections accepted"))
+        , connectionsClosed(MetricsRegistry::getInstance().counter(
+              "gameserver_connections_closed_total", "Client connections closed"))
+        , connectionsActive(MetricsRegistry::getInstance().gauge(
+              "gameserver_connections_active", "Currently open client connections"))
+        , bytesReceived(MetricsRegistry::getInstance().counter(
+              "gameserver_bytes_received_total", "Bytes read from clients"))
+        , bytesSent(MetricsRegistry::getInstance().counter(
+              "gameserver_bytes_sent_total", "Bytes queued or written to clients"))
+        , messagesReceived(MetricsRegistry::getInstance().counter(
+              "gameserver_messages_received_total", "Client reads handled"))
+        , binaryFrames(MetricsRegistry::getInstance().counter(
+              "gameserver_binary_frames_total", "Binary protocol frames received"))
+        , protocolErrors(MetricsRegistry::getInstance().counter(
+              "gameserver_protocol_errors_total", "Binary frames rejected as unknown or malformed"))
+        , rooms(MetricsRegistry::getInstance().gauge(
+              "gameserver_rooms", "Rooms currently open"))
+        , roomsInGame(MetricsRegistry::getInstance().gauge(
+              "gameserver_rooms_in_game", "Rooms with a game in progress"))
+        , players(MetricsRegistry::getInstance().gauge(
+              "gameserver_players", "Players across all rooms"))
+        , spectators(MetricsRegistry::getInstance().gauge(
+              "gameserver_spectators", "Spectators across all rooms"))
+        , handoffOutputBytes(MetricsRegistry::getInstance().counter(
+              "gameserver_handoff_output_bytes_total", "Unsent output passed on in hot restart snapshots"))
+        , tickDuration(MetricsRegistry::getInstance().histogram(
+              "gameserver_tick_duration_us", "Main loop tick duration in microseconds")) {}
+};
+
+ServerMetrics& serverMetrics() {
+    static ServerMetrics metrics;
+    return metrics;
+}
+
+#ifndef _WIN32
+// IPv4 address of the peer in host byte order, 0 if unknown
+uint32_t peerAddress(int fd) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr*)&addr, &len) != 0 || addr.sin_family != AF_INET) {
+        return 0;
+    }
+    return ntohl(addr.sin_addr.s_addr);
+}
+#endif
+
+// Room id argument of JOIN or SPECTATE: a positive number, then at most a
+// line ending. 0 when it is anything else.
+int parseRoomId(const char* data, size_t len) {
+    std::string text(data, len);
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.pop_back();
+    }
+    if (text.empty() || !isdigit((unsigned char)text[0])) {
+        return 0;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long value = strtol(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || value <= 0 || value > INT_MAX) {
+        return 0;
+    }
+    return (int)value;
+}
+
+} // namespace
+
+GameServer::GameServer()
+    : nextRoomId(1)
+    , nextPlayerId(1)
+    , reservedPlayerIds(0)
+    , server_socket(INVALID_SOCKET)
+    , max_fd(0)
+    , shutdownRequested(false)
+    , forceShutdown(false)
+    , draining(false)
+    , drainTimeout(std::chrono::seconds(5))
+    , wake_read_fd(-1)
+    , wake_write_fd(-1)
+    , handoffChannel(-1)
+    , handingOff(false)
+    , handedOff(false)
+    , releaseChannel(-1)
+    , ioBackend(IoBackend::Select)
+    , persistence(nullptr)
+    , leaderboards(nullptr)
+    , spectatorDelay(0)
+    , spectatorTick(0)
+    , statsInterval(std::chrono::seconds(10))
+    , lastStatsTime(std::chrono::steady_clock::now())
+    , lastMessages(0)
+    , lastBytesReceived(0)
+    , lastBytesSent(0) {}
 
-#ifdef _WIN32
 GameServer::~GameServer() {
+    // Stop taking handoff requests before anything else goes away
+    handoffListener.reset();
+#ifdef _WIN32
     if (server_socket != INVALID_SOCKET) {
         closesocket(server_socket);
     }
@@ -28,8 +212,77 @@ GameServer::~GameServer() {
     }
     
     WSACleanup();
+#else
+    if (handoffChannel >= 0) {
+        close(handoffChannel);
+    }
+    releaseHandoff();
+    if (wake_read_fd >= 0) {
+        close(wake_read_fd);
+    }
+    if (wake_write_fd >= 0 && wake_write_fd != wake_read_fd) {
+        close(wake_write_fd);
+    }
+#endif
+}
+
+void GameServer::setRateLimits(const RateLimitConfig& config) {
+    limiter.reset(new RateLimiter(config));
+}
+
+bool GameServer::enableTls(const TlsConfig& config) {
+    std::unique_ptr<TlsContext> context(new TlsContext());
+    if (!context->initialize(config)) {
+        return false;
+    }
+#ifdef SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    tls = std::move(context);
+    return true;
+}
+
+void GameServer::setSpectatorDelay(std::chrono::milliseconds delay) {
+    if (delay > SPECTATOR_MAX_DELAY) {
+        LOG_WARN("Spectator delay capped at " + std::to_string(SPECTATOR_MAX_DELAY.count()) + " ms");
+        delay = SPECTATOR_MAX_DELAY;
+    }
+    spectatorDelay = std::max(delay, std::chrono::milliseconds(0));
 }
+
+bool GameServer::isIoBackendAvailable(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::Select:
+            return true;
+        case IoBackend::IoUring:
+#ifdef GAMESERVER_HAS_IO_URING
+            return true;
+#else
+            return false;
 #endif
+    }
+    return false;
+}
+
+bool GameServer::parseIoBackend(const std::string& name, IoBackend& backend) {
+    if (name == "select") {
+        backend = IoBackend::Select;
+        return true;
+    }
+    if (name == "io_uring" || name == "uring") {
+        backend = IoBackend::IoUring;
+        return true;
+    }
+    return false;
+}
+
+std::string GameServer::ioBackendToString(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::Select:  return "select";
+        case IoBackend::IoUring: return "io_uring";
+    }
+    return "unknown";
+}
 
 bool GameServer::initialize(int port) {
 #ifdef _WIN32
@@ -95,224 +348,2037 @@ bool GameServer::initialize(int port) {
     }
     
     max_fd = (int)server_socket;
-    LOG_INFO("Server listening on port " + std::to_string(port));
+    if (!start_backend()) {
+        return false;
+    }
+
+    LOG_INFO("Server listening on port " + std::to_string(getPort()) +
+             " (" + ioBackendToString(ioBackend) + " backend" + (tls ? ", TLS" : "") + ")");
     return true;
 }
 
-void GameServer::run() {
-    while (true) {
-        // Clear the socket set
-        FD_ZERO(&read_fds);
-        
-        // Add server socket to set
-        FD_SET(server_socket, &read_fds);
-        
-        // Add client sockets to set
-        for (auto it = client_sockets.begin(); it != client_sockets.end();) {
-#ifdef _WIN32
-            if (*it != INVALID_SOCKET) {
-                FD_SET(*it, &read_fds);
-            } else {
-                it = client_sockets.erase(it);
-                continue;
-            }
-#else
-            if (*it > 0) {
-                FD_SET(*it, &read_fds);
-            }
-#endif
-            ++it;
+int GameServer::getPort() const {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(server_socket, (struct sockaddr*)&addr, &len) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+bool GameServer::start_backend() {
+    if (!create_wakeup_fd()) {
+        return false;
+    }
+
+    // The io_uring path hands raw buffers around; TLS records are read through OpenSSL
+    if (tls && ioBackend == IoBackend::IoUring) {
+        LOG_WARN("TLS is served by the select() backend, not using io_uring");
+        ioBackend = IoBackend::Select;
+    }
+    if (ioBackend == IoBackend::IoUring) {
+#ifdef GAMESERVER_HAS_IO_URING
+        uring.reset(new IoUringBackend());
+        if (!uring->initialize((int)server_socket)) {
+            LOG_WARN("io_uring unavailable, falling back to select()");
+            uring.reset();
+            ioBackend = IoBackend::Select;
         }
-        
-        // Wait for activity
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, NULL);
-        if (activity < 0) {
-#ifdef _WIN32
-            LOG_ERR("Select error: " + std::to_string(WSAGetLastError()));
 #else
-            if (errno != EINTR) {
-                LOG_ERR("Select error");
-            }
+        LOG_WARN("Built without io_uring support, falling back to select()");
+        ioBackend = IoBackend::Select;
 #endif
-            break;
-        }
-        
-        // Check for new connection
-        if (FD_ISSET(server_socket, &read_fds)) {
-            handle_new_connection();
-        }
-        
-        // Check for data from clients
-        handle_client_data();
     }
+    return true;
 }
 
-void GameServer::handle_new_connection() {
-    struct sockaddr_in client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-    
-    auto new_socket = accept(server_socket, (struct sockaddr*)&client_addr, &addr_len);
-    if (new_socket == INVALID_SOCKET) {
+bool GameServer::takeOver(const std::string& path) {
 #ifdef _WIN32
-        LOG_ERR("Accept failed: " + std::to_string(WSAGetLastError()));
+    LOG_ERR("Hot restart is not supported on Windows");
+    return false;
 #else
-        LOG_ERR("Accept failed");
-#endif
-        return;
+    auto start = std::chrono::steady_clock::now();
+
+    // Every client socket of the old process lands in this one
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
     }
-    
-    char ip_str[INET_ADDRSTRLEN];
-#ifdef _WIN32
-    strcpy_s(ip_str, INET_ADDRSTRLEN, inet_ntoa(client_addr.sin_addr));
-#else
-    inet_ntop(AF_INET, &client_addr.sin_addr, ip_str, INET_ADDRSTRLEN);
-#endif
 
-    LOG_INFO("New connection from " + std::string(ip_str) + 
-             ":" + std::to_string(ntohs(client_addr.sin_port)));
-    
-    // Add new socket to list
-    client_sockets.push_back(new_socket);
-    
-    // Update max_fd
-#ifndef _WIN32
-    if ((int)new_socket > max_fd) {
-        max_fd = (int)new_socket;
+    int channel = connectHandoff(path);
+    if (channel < 0) {
+        return false;
+    }
+    std::string snapshot;
+    std::vector<int> fds;
+    if (!receiveHandoff(channel, snapshot, fds)) {
+        close(channel);
+        return false;
+    }
+    if (!restore_snapshot(snapshot, fds)) {
+        LOG_ERR("Handoff: malformed snapshot");
+        for (int fd : fds) {
+            close(fd);
+        }
+        close(channel);
+        return false;
     }
-#endif
-}
 
-void GameServer::handle_client_data() {
-    for (auto it = client_sockets.begin(); it != client_sockets.end();) {
-#ifdef _WIN32
-        SOCKET client_socket = *it;
-#else
-        int client_socket = *it;
-#endif
-        
-        if (FD_ISSET(client_socket, &read_fds)) {
-            char buffer[1024] = {0};
-#ifdef _WIN32
-            int valread = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-#else
-            ssize_t valread = read(client_socket, buffer, sizeof(buffer) - 1);
-#endif
-            
-            if (valread == 0) {
-                // Client disconnected
-                LOG_INFO("Client disconnected");
-#ifdef _WIN32
-                closesocket(client_socket);
-#else
-                close(client_socket);
-#endif
-                it = client_sockets.erase(it);
-                continue;
-            } 
-#ifdef _WIN32
-            else if (valread == SOCKET_ERROR) {
-                LOG_ERR("Recv failed: " + std::to_string(WSAGetLastError()));
-                closesocket(client_socket);
-                it = client_sockets.erase(it);
-                continue;
-            }
-#else
-            else if (valread < 0) {
-                LOG_ERR("Read failed: " + std::string(strerror(errno)));
-                close(client_socket);
-                it = client_sockets.erase(it);
-                continue;
+    max_fd = (int)server_socket;
+    if (!start_backend()) {
+        close(channel);
+        return false;
+    }
+
+    std::vector<int> clients;
+    std::map<int, std::string> pending;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.swap(client_sockets);
+        pending.swap(outbound);
+    }
+    for (int client : clients) {
+        if (limiter) {
+            limiter->trackConnection(client, peerAddress(client));
+        }
+#ifdef GAMESERVER_HAS_IO_URING
+        if (uring) {
+            uring->adoptConnection(client);
+            if (throttled.count(client)) {
+                uring->pauseReading(client);
             }
+            serverMetrics().connectionsActive.add(1);
+            continue;
+        }
 #endif
-            else {
-                // Process data
-                LOG_DEBUG("Received: " + std::string(buffer));
-                // Echo back for testing
-#ifdef _WIN32
-                send(client_socket, buffer, valread, 0);
-#else
-                write(client_socket, buffer, valread);
-#endif
-            }
+        serverMetrics().connectionsActive.add(1);
+        if (client >= FD_SETSIZE) {
+            LOG_WARN("Dropping handed over connection: fd " + std::to_string(client) +
+                     " exceeds FD_SETSIZE, use the io_uring backend for more clients");
+            close_client(client);
+            continue;
         }
-        ++it;
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL, 0) | O_NONBLOCK);
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        client_sockets.push_back(client);
+        max_fd = std::max(max_fd, client);
     }
-}
-
-void GameServer::broadcast_message(const std::string& message) {
-    for (auto client_socket : client_sockets) {
-#ifdef _WIN32
-        send(client_socket, message.c_str(), message.length(), 0);
-#else
-        write(client_socket, message.c_str(), message.length());
+    // Output the old process could not flush in time
+    for (const auto& pair : pending) {
+#ifdef GAMESERVER_HAS_IO_URING
+        if (uring) {
+            uring->send(pair.first, pair.second.data(), pair.second.size());
+            continue;
+        }
 #endif
+        send_to_client(pair.first, pair.second.data(), pair.second.size());
+    }
+    // Reads the old process held back for its rate limits
+    schedule_throttle_retry();
+
+    if (!acknowledgeHandoff(channel)) {
+        LOG_ERR("Handoff: failed to acknowledge, the old process keeps serving");
+        close(channel);
+        return false;
     }
+    releaseChannel = channel;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Took over " + std::to_string(clients.size()) + " connections and " +
+             std::to_string(rooms.size()) + " rooms in " + std::to_string(elapsed) + " ms (" +
+             ioBackendToString(ioBackend) + " backend)");
+    return true;
+#endif
 }
 
-std::shared_ptr<Room> GameServer::createRoom(const std::string& roomName, int maxPlayers) {
-    std::lock_guard<std::mutex> lock(roomsMutex);
-    
-    auto room = std::make_shared<Room>(nextRoomId, roomName, maxPlayers);
-    rooms[nextRoomId] = room;
-    
-    LOG_INFO("Created room " + std::to_string(nextRoomId) + ": " + roomName);
-    return room;
+void GameServer::releaseHandoff() {
+#ifndef _WIN32
+    if (releaseChannel >= 0) {
+        close(releaseChannel);
+        releaseChannel = -1;
+    }
+#endif
 }
 
-bool GameServer::deleteRoom(int roomId) {
-    std::lock_guard<std::mutex> lock(roomsMutex);
-    
-    auto it = rooms.find(roomId);
-    if (it != rooms.end()) {
-        rooms.erase(it);
-        LOG_INFO("Deleted room " + std::to_string(roomId));
+bool GameServer::waitForHandoffRelease() {
+    if (releaseChannel < 0) {
         return true;
     }
-    return false;
+    bool released = waitForRelease(releaseChannel);
+    releaseHandoff();
+    return released;
 }
 
-std::shared_ptr<Room> GameServer::getRoom(int roomId) {
-    std::lock_guard<std::mutex> lock(roomsMutex);
-    
-    auto it = rooms.find(roomId);
-    if (it != rooms.end()) {
-        return it->second;
-    }
-    return nullptr;
+bool GameServer::enableHandoff(const std::string& path) {
+    handoffListener.reset(new HandoffListener());
+    return handoffListener->start(path, [this](int channel) {
+        int expected = -1;
+        if (shutdownRequested || !handoffChannel.compare_exchange_strong(expected, channel)) {
+            LOG_WARN("Rejecting hot restart request, server is shutting down or busy");
+#ifndef _WIN32
+            close(channel);
+#endif
+            return;
+        }
+        wake_loop();
+    });
 }
 
-std::vector<std::shared_ptr<Room>> GameServer::getAllRooms() {
-    std::lock_guard<std::mutex> lock(roomsMutex);
-    
-    std::vector<std::shared_ptr<Room>> roomList;
-    for (const auto& pair : rooms) {
-        roomList.push_back(pair.second);
+void GameServer::begin_handoff() {
+    handingOff = true;
+    handoffDeadline = std::chrono::steady_clock::now() + HANDOFF_FLUSH_TIMEOUT;
+    LOG_INFO("Pausing input for hot restart");
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        uring->pause();
     }
-    return roomList;
+#endif
 }
 
-void GameServer::listRooms() {
-    std::lock_guard<std::mutex> lock(roomsMutex);
-    
-    LOG_INFO("=== Room List ===");
-    for (const auto& pair : rooms) {
-        auto room = pair.second;
-        std::string status = room->getIsStarted() ? " [IN GAME]" : "";
-        LOG_INFO("Room " + std::to_string(room->getRoomId()) + 
-                 " (" + room->getRoomName() + "): " +
-                 std::to_string(room->getPlayerCount()) + "/" + 
-                 std::to_string(room->getMaxPlayers()) + " players" + status);
+bool GameServer::handoff_ready() {
+    auto now = std::chrono::steady_clock::now();
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        // Every recv has to be cancelled before the sockets can change owner
+        if (now < handoffDeadline && (uring->getArmedRecvCount() > 0 || has_pending_output())) {
+            return false;
+        }
+        // Output still queued goes into the snapshot; a send in flight is
+        // cancelled first so its bytes are neither lost nor sent twice
+        uring->pauseSends();
+        return uring->getSendsInFlight() == 0 || now >= handoffDeadline + HANDOFF_FLUSH_TIMEOUT;
     }
+#endif
+    return now >= handoffDeadline || !has_pending_output();
 }
-void GameServer::CleanUpRooms(){
 
+bool GameServer::complete_handoff() {
+    int channel = handoffChannel.exchange(-1);
+    handingOff = false;
+    bool handed = false;
+#ifndef _WIN32
+    bool paused = true;
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        paused = uring->getArmedRecvCount() == 0 && uring->getSendsInFlight() == 0;
+    }
+#endif
+    if (!paused) {
+        LOG_ERR("Hot restart: reads and sends did not pause in time");
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<int> fds;
+        std::string snapshot = serialize_snapshot(fds);
+        handed = sendHandoff(channel, snapshot, fds);
+        if (handed) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            LOG_INFO("Handed off " + std::to_string(fds.size() - 1) + " connections (" +
+                     std::to_string(snapshot.size()) + " byte snapshot) in " +
+                     std::to_string(elapsed) + " ms");
+        }
+    }
+    if (handed) {
+        // Closed by releaseHandoff() once the store is flushed
+        releaseChannel = channel;
+        // Left out of the snapshot; these clients reconnect to the new process
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (auto& pair : tlsConnections) {
+            pair.second->shutdown();
+            close(pair.first);
+        }
+        tlsConnections.clear();
+    } else {
+        close(channel);
+    }
+#endif
+    if (!handed) {
+        LOG_WARN("Hot restart failed, resuming service");
+#ifdef GAMESERVER_HAS_IO_URING
+        if (uring) {
+            uring->resume();
+            schedule_throttle_retry();
+        }
+#endif
+    }
+    return handed;
 }
-void GameServer::SendUpdatesToClients(){
 
-}
-void GameServer::HandleGameLogic(){
+// Snapshot layout, all integers varints:
+//   nextRoomId, roomCount, per room:
+//     id, maxPlayers, started, name, playerCount, per player: id, ready, name
+//   nextPlayerId, connectionCount, per connection (fds[i + 1]):
+//     playerId (0 = none), roomId, unsent output, binary mode, start of an
+//     unread frame, read held back by a rate limit
+// fds[0] is the listening socket.
+std::string GameServer::serialize_snapshot(std::vector<int>& fds) {
+    // TLS sessions cannot change process; their sockets and players stay behind
+    std::set<int> skipSockets;
+    std::set<int> skipPlayers;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (const auto& pair : tlsConnections) {
+            skipSockets.insert(pair.first);
+        }
+    }
+    if (!skipSockets.empty()) {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        for (int client : skipSockets) {
+            auto session = sessions.find(client);
+            if (session != sessions.end()) {
+                skipPlayers.insert(session->second.playerId);
+            }
+        }
+    }
 
-}
-void GameServer::LogServerStats(){
+    SnapshotWriter writer;
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        writer.putVarint((uint64_t)nextRoomId);
+        writer.putVarint(rooms.size());
+        for (const auto& pair : rooms) {
+            const auto& room = pair.second;
+            writer.putVarint((uint64_t)room->getRoomId());
+            writer.putVarint((uint64_t)room->getMaxPlayers());
+            writer.putVarint(room->getIsStarted() ? 1 : 0);
+            writer.putString(room->getRoomName());
+            auto players = room->getPlayers();
+            players.erase(std::remove_if(players.begin(), players.end(),
+                                         [&skipPlayers](const std::shared_ptr<Player>& player) {
+                                             return skipPlayers.count(player->id) != 0;
+                                         }),
+                          players.end());
+            writer.putVarint(players.size());
+            for (const auto& player : players) {
+                writer.putVarint((uint64_t)player->id);
+                writer.putVarint(player->isReady ? 1 : 0);
+                writer.putString(player->name);
+            }
+        }
+    }
+
+    std::vector<int> clients;
+    std::map<int, std::string> unsent;
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        // Sends are paused, so the queues are what the kernel never accepted
+        clients = uring->getConnectionFds();
+        for (int client : clients) {
+            std::string output = uring->getUnsent(client);
+            if (!output.empty()) {
+                unsent[client] = std::move(output);
+            }
+        }
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        if (!uring) {
+            for (int client : client_sockets) {
+                if (!skipSockets.count(client)) {
+                    clients.push_back(client);
+                }
+            }
+            unsent = outbound;
+        }
+    }
+
+    fds.clear();
+    fds.reserve(clients.size() + 1);
+    fds.push_back((int)server_socket);
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    writer.putVarint((uint64_t)nextPlayerId);
+    writer.putVarint(clients.size());
+    for (int client : clients) {
+        auto session = sessions.find(client);
+        auto output = unsent.find(client);
+        writer.putVarint(session != sessions.end() ? (uint64_t)session->second.playerId : 0);
+        writer.putVarint(session != sessions.end() ? (uint64_t)session->second.roomId : 0);
+        if (output != unsent.end()) {
+            writer.putString(output->second);
+            serverMetrics().handoffOutputBytes.inc(output->second.size());
+        } else {
+            writer.putString(std::string());
+        }
+        auto input = inbound.find(client);
+        writer.putVarint(input != inbound.end() ? 1 : 0);
+        writer.putString(input != inbound.end() ? input->second : std::string());
+        auto held = throttled.find(client);
+        writer.putString(held != throttled.end() ? held->second : std::string());
+        fds.push_back(client);
+    }
+    return writer.data();
+}
+
+bool GameServer::restore_snapshot(const std::string& snapshot, const std::vector<int>& fds) {
+    SnapshotReader reader(snapshot);
+    uint64_t roomIdCounter, roomCount;
+    if (fds.empty() || !reader.getVarint(roomIdCounter) || !reader.getVarint(roomCount)) {
+        return false;
+    }
+
+    std::map<int, std::shared_ptr<Room>> restoredRooms;
+    for (uint64_t r = 0; r < roomCount; ++r) {
+        uint64_t id, maxPlayers, started, playerCount;
+        std::string name;
+        if (!reader.getVarint(id) || !reader.getVarint(maxPlayers) || !reader.getVarint(started) ||
+            !reader.getString(name) || !reader.getVarint(playerCount)) {
+            return false;
+        }
+        auto room = std::make_shared<Room>((int)id, name, (int)maxPlayers);
+        for (uint64_t p = 0; p < playerCount; ++p) {
+            uint64_t playerId, ready;
+            std::string playerName;
+            if (!reader.getVarint(playerId) || !reader.getVarint(ready) || !reader.getString(playerName)) {
+                return false;
+            }
+            auto player = std::make_shared<Player>((int)playerId, playerName);
+            player->isReady = ready != 0;
+            room->addPlayer(player);
+        }
+        // Started rooms refuse new players, so the flag goes on last
+        room->setIsStarted(started != 0);
+        restoredRooms[(int)id] = room;
+    }
+
+    uint64_t playerIdCounter, connectionCount;
+    if (!reader.getVarint(playerIdCounter) || !reader.getVarint(connectionCount) ||
+        connectionCount != fds.size() - 1) {
+        return false;
+    }
+    std::map<int, ClientSession> restoredSessions;
+    std::map<int, std::string> restoredOutput;
+    std::map<int, std::string> restoredInput;
+    std::map<int, std::string> restoredHeld;
+    for (uint64_t c = 0; c < connectionCount; ++c) {
+        uint64_t playerId, roomId, binary;
+        std::string output, input, held;
+        if (!reader.getVarint(playerId) || !reader.getVarint(roomId) || !reader.getString(output) ||
+            !reader.getVarint(binary) || !reader.getString(input) || !reader.getString(held)) {
+            return false;
+        }
+        int fd = fds[c + 1];
+        if (playerId != 0 || roomId != 0) {
+            restoredSessions[fd] = ClientSession{(int)playerId, (int)roomId};
+        }
+        // Spectators start again at the next keyframe
+        auto watched = restoredRooms.find((int)roomId);
+        if (playerId == 0 && watched != restoredRooms.end()) {
+            watched->second->getSpectatorStream().setDelay(spectatorDelay);
+            watched->second->addSpectator(fd);
+        }
+        if (!output.empty()) {
+            restoredOutput[fd] = output;
+        }
+        if (binary != 0) {
+            restoredInput[fd] = input;
+        }
+        if (!held.empty()) {
+            restoredHeld[fd] = held;
+        }
+    }
+    if (!reader.atEnd()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        rooms.swap(restoredRooms);
+        nextRoomId = (int)roomIdCounter;
+        serverMetrics().rooms.set((int64_t)rooms.size());
+    }
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        sessions.swap(restoredSessions);
+        nextPlayerId = (int)playerIdCounter;
+    }
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        client_sockets.assign(fds.begin() + 1, fds.end());
+        outbound.swap(restoredOutput);
+    }
+    inbound.swap(restoredInput);
+    throttled.swap(restoredHeld);
+    server_socket = fds[0];
+    return true;
+}
+
+void GameServer::run() {
+    Tracer::getInstance().setThreadName("network");
+    // A shutdown requested before the wakeup fd existed left nothing on it
+    if (shutdownRequested) {
+        wake_loop();
+    }
+    if (ioBackend == IoBackend::IoUring && uring) {
+        run_io_uring();
+    } else {
+        run_select();
+    }
+}
+
+bool GameServer::create_wakeup_fd() {
+#if defined(__linux__)
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERR("Failed to create wakeup eventfd: " + std::string(strerror(errno)));
+        return false;
+    }
+    wake_read_fd = fd;
+    wake_write_fd = fd;
+#elif !defined(_WIN32)
+    int fds[2];
+    if (pipe(fds) < 0) {
+        LOG_ERR("Failed to create wakeup pipe: " + std::string(strerror(errno)));
+        return false;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    wake_read_fd = fds[0];
+    wake_write_fd = fds[1];
+#endif
+    // Windows has no wakeup fd; run_select() polls the shutdown flag instead
+    if (wake_read_fd > max_fd) {
+        max_fd = wake_read_fd;
+    }
+    return true;
+}
+
+void GameServer::requestShutdown() {
+    // Called from signal handlers: atomics and write() only
+    if (shutdownRequested.exchange(true)) {
+        forceShutdown = true;
+    }
+    wake_loop();
+}
+
+void GameServer::wake_loop() {
+#ifndef _WIN32
+    if (wake_write_fd >= 0) {
+        // 8 bytes as eventfd requires; a pipe accepts them just as well
+        uint64_t one = 1;
+        ssize_t written = write(wake_write_fd, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+}
+
+void GameServer::consume_wakeup() {
+#ifndef _WIN32
+    char buffer[64];
+    while (read(wake_read_fd, buffer, sizeof(buffer)) > 0) {
+    }
+#endif
+}
+
+void GameServer::begin_drain() {
+    draining = true;
+    drainDeadline = std::chrono::steady_clock::now() + drainTimeout;
+    LOG_INFO("Draining: no longer accepting connections, flushing output for up to " +
+             std::to_string(drainTimeout.count()) + " ms");
+
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        uring->stopAccepting();
+    }
+#endif
+    // Closing the listener makes new connects fail fast, so a replacement
+    // process or load balancer can take them
+#ifdef _WIN32
+    closesocket(server_socket);
+#else
+    close(server_socket);
+#endif
+    server_socket = INVALID_SOCKET;
+}
+
+bool GameServer::has_pending_output() {
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        return uring->getPendingSendCount() > 0;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    return !outbound.empty();
+}
+
+bool GameServer::drain_complete() {
+    if (forceShutdown) {
+        LOG_WARN("Second shutdown request, skipping the rest of the drain");
+        return true;
+    }
+    if (!has_pending_output()) {
+        return true;
+    }
+    if (std::chrono::steady_clock::now() >= drainDeadline) {
+        LOG_WARN("Drain deadline reached with output still queued");
+        return true;
+    }
+    return false;
+}
+
+void GameServer::finish_drain() {
+    if (!stateFile.empty()) {
+        saveRoomState(stateFile);
+    }
+    LOG_INFO("Drain complete, closing client connections");
+}
+
+void GameServer::run_io_uring() {
+#ifdef GAMESERVER_HAS_IO_URING
+    uring->setAcceptHandler([this](int fd) {
+        struct sockaddr_in client_addr;
+        socklen_t addr_len = sizeof(client_addr);
+        char ip_str[INET_ADDRSTRLEN] = "unknown";
+        int port = 0;
+        uint32_t address = 0;
+        if (getpeername(fd, (struct sockaddr*)&client_addr, &addr_len) == 0) {
+            inet_ntop(AF_INET, &client_addr.sin_addr, ip_str, INET_ADDRSTRLEN);
+            port = ntohs(client_addr.sin_port);
+            address = ntohl(client_addr.sin_addr.s_addr);
+        }
+        // No log line per rejection, a flood would turn into a log flood
+        if (limiter && !limiter->admitConnection(fd, address)) {
+            return false;
+        }
+        LOG_INFO("New connection from " + std::string(ip_str) + ":" + std::to_string(port));
+        serverMetrics().connectionsAccepted.inc();
+        serverMetrics().connectionsActive.add(1);
+        return true;
+    });
+
+    uring->setDataHandler([this](int fd, const char* data, size_t len) {
+        // Input that arrives while draining is dropped, like in run_select()
+        if (draining) {
+            return;
+        }
+        if (!dispatch_read(fd, data, len)) {
+            uring->disconnect(fd);
+        }
+    });
+
+    uring->setCloseHandler([this](int fd, int error) {
+        handle_disconnect(fd);
+        if (error != 0) {
+            LOG_ERR("Read failed: " + std::string(strerror(error)));
+        } else {
+            LOG_INFO("Client disconnected");
+        }
+    });
+
+    uring->setWakeHandler(wake_read_fd, [this]() { on_uring_wakeup(); });
+
+    // A shutdown requested before run() is still pending on the eventfd
+    uring->run();
+#endif
+}
+
+void GameServer::on_uring_wakeup() {
+#ifdef GAMESERVER_HAS_IO_URING
+    if (draining || handingOff) {
+        return;
+    }
+    // Send queues and cancellations are polled; completions alone don't
+    // tell us they are done
+    if (handoffChannel >= 0 && !shutdownRequested) {
+        begin_handoff();
+        uring->setTimerHandler(std::chrono::milliseconds(10), [this]() {
+            if (!handoff_ready()) {
+                return;
+            }
+            uring->setTimerHandler(std::chrono::milliseconds(0), nullptr);
+            if (complete_handoff()) {
+                handedOff = true;
+                uring->stop();
+            } else {
+                // A shutdown may have arrived while we were paused
+                on_uring_wakeup();
+            }
+        });
+        return;
+    }
+    if (!shutdownRequested) {
+        return;
+    }
+    begin_drain();
+    uring->setTimerHandler(std::chrono::milliseconds(10), [this]() {
+        if (!drain_complete()) {
+            return;
+        }
+        uring->setTimerHandler(std::chrono::milliseconds(0), nullptr);
+        finish_drain();
+        uring->closeAllConnections();
+        uring->stop();
+    });
+#endif
+}
+
+void GameServer::run_select() {
+    while (true) {
+        if (handoffChannel >= 0 && !handingOff && !draining && !shutdownRequested) {
+            begin_handoff();
+        }
+        if (handingOff && handoff_ready() && complete_handoff()) {
+            // The sockets belong to the new process now; leave them alone
+            handedOff = true;
+            return;
+        }
+        if (shutdownRequested && !draining && !handingOff) {
+            begin_drain();
+        }
+        if (draining && drain_complete()) {
+            break;
+        }
+        // No new input while draining or handing off, only output is flushed
+        bool paused = draining || handingOff;
+
+        // Clear the socket sets
+        FD_ZERO(&read_fds);
+        FD_ZERO(&write_fds);
+        
+        // Add server socket to set; it is closed once draining starts
+        if (!paused) {
+            FD_SET(server_socket, &read_fds);
+        }
+#ifndef _WIN32
+        FD_SET(wake_read_fd, &read_fds);
+#endif
+        
+        // Add client sockets to set
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            for (auto it = client_sockets.begin(); it != client_sockets.end();) {
+#ifdef _WIN32
+                if (*it != INVALID_SOCKET) {
+                    if (!paused && !throttled.count((int)*it)) {
+                        FD_SET(*it, &read_fds);
+                    }
+                } else {
+                    it = client_sockets.erase(it);
+                    continue;
+                }
+#else
+                if (*it > 0 && !paused && !throttled.count(*it)) {
+                    FD_SET(*it, &read_fds);
+                }
+#endif
+                ++it;
+            }
+            for (const auto& pair : outbound) {
+                auto session = tlsConnections.find(pair.first);
+                if (session == tlsConnections.end() || session->second->isEstablished()) {
+                    FD_SET(pair.first, &write_fds);
+                }
+            }
+            for (const auto& pair : tlsConnections) {
+                if (pair.second->handshakeWantsWrite()) {
+                    FD_SET(pair.first, &write_fds);
+                }
+            }
+        }
+        
+        // Wait for activity. Without a wakeup fd (Windows) the shutdown flag
+        // is polled; while paused the deadline has to be checked as well, and
+        // held reads are offered to the rate limiter again.
+        struct timeval timeout = {0, 100000};
+        bool poll = paused;
+        if (!paused && !throttled.empty()) {
+            timeout.tv_usec = (long)std::chrono::microseconds(THROTTLE_RETRY_INTERVAL).count();
+            poll = true;
+        }
+#ifdef _WIN32
+        poll = true;
+#endif
+        int activity = select(max_fd + 1, &read_fds, &write_fds, NULL, poll ? &timeout : NULL);
+        if (activity < 0) {
+#ifdef _WIN32
+            LOG_ERR("Select error: " + std::to_string(WSAGetLastError()));
+            break;
+#else
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERR("Select error: " + std::string(strerror(errno)));
+            break;
+#endif
+        }
+        
+        TRACE_SCOPE("GameServer::run");
+
+#ifndef _WIN32
+        if (FD_ISSET(wake_read_fd, &read_fds)) {
+            consume_wakeup();
+        }
+#endif
+
+        // Check for new connection
+        if (!paused && FD_ISSET(server_socket, &read_fds)) {
+            handle_new_connection();
+        }
+        
+        // Check for data from clients
+        if (!paused) {
+            retry_throttled();
+            handle_client_data();
+        }
+        flush_outbound();
+    }
+
+    finish_drain();
+    std::vector<int> clients;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.assign(client_sockets.begin(), client_sockets.end());
+        client_sockets.clear();
+    }
+    for (int client : clients) {
+        close_client(client);
+    }
+}
+
+void GameServer::handle_new_connection() {
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    
+    auto new_socket = accept(server_socket, (struct sockaddr*)&client_addr, &addr_len);
+    if (new_socket == INVALID_SOCKET) {
+#ifdef _WIN32
+        LOG_ERR("Accept failed: " + std::to_string(WSAGetLastError()));
+#else
+        LOG_ERR("Accept failed");
+#endif
+        return;
+    }
+    
+#ifndef _WIN32
+    // fd_set cannot describe descriptors past FD_SETSIZE
+    if (new_socket >= FD_SETSIZE) {
+        LOG_WARN("Rejecting connection: fd " + std::to_string(new_socket) +
+                 " exceeds FD_SETSIZE, use the io_uring backend for more clients");
+        close(new_socket);
+        return;
+    }
+#endif
+
+    // Before anything is set up for it; no log line, a flood would turn into a log flood
+    if (limiter && !limiter->admitConnection((int)new_socket, ntohl(client_addr.sin_addr.s_addr))) {
+#ifdef _WIN32
+        closesocket(new_socket);
+#else
+        close(new_socket);
+#endif
+        return;
+    }
+
+    // Non-blocking so one slow reader cannot stall the loop; see send_to_client()
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(new_socket, FIONBIO, &nonBlocking);
+#else
+    fcntl(new_socket, F_SETFL, fcntl(new_socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    char ip_str[INET_ADDRSTRLEN];
+#ifdef _WIN32
+    strcpy_s(ip_str, INET_ADDRSTRLEN, inet_ntoa(client_addr.sin_addr));
+#else
+    inet_ntop(AF_INET, &client_addr.sin_addr, ip_str, INET_ADDRSTRLEN);
+#endif
+
+    // The handshake runs from handle_client_data() once the client hello arrives
+    std::unique_ptr<TlsConnection> session;
+    if (tls) {
+        session = tls->accept((int)new_socket);
+        if (!session) {
+            if (limiter) {
+                limiter->connectionClosed((int)new_socket);
+            }
+#ifdef _WIN32
+            closesocket(new_socket);
+#else
+            close(new_socket);
+#endif
+            return;
+        }
+    }
+
+    LOG_INFO("New connection from " + std::string(ip_str) + 
+             ":" + std::to_string(ntohs(client_addr.sin_port)));
+    
+    // Add new socket to list
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        client_sockets.push_back(new_socket);
+        if (session) {
+            tlsConnections[(int)new_socket] = std::move(session);
+        }
+    }
+    serverMetrics().connectionsAccepted.inc();
+    serverMetrics().connectionsActive.add(1);
+    
+    // Update max_fd
+#ifndef _WIN32
+    if ((int)new_socket > max_fd) {
+        max_fd = (int)new_socket;
+    }
+#endif
+}
+
+void GameServer::handle_client_data() {
+    TRACE_SCOPE("GameServer::handle_client_data");
+    // Only this thread adds or removes sockets, so iterating a copy is safe
+    std::vector<int> ready;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (auto client_socket : client_sockets) {
+            if (FD_ISSET(client_socket, &read_fds)) {
+                ready.push_back((int)client_socket);
+            }
+        }
+        // A handshake that stopped on a full send buffer continues here too
+        for (const auto& pair : tlsConnections) {
+            if (pair.second->handshakeWantsWrite() && FD_ISSET(pair.first, &write_fds) &&
+                !FD_ISSET(pair.first, &read_fds)) {
+                ready.push_back(pair.first);
+            }
+        }
+    }
+
+    for (int client_socket : ready) {
+        if (tls ? read_tls(client_socket) : read_plain(client_socket)) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            client_sockets.erase(std::remove(client_sockets.begin(), client_sockets.end(),
+                                             client_socket), client_sockets.end());
+        }
+        close_client(client_socket);
+    }
+}
+
+bool GameServer::read_plain(int client_socket) {
+    char buffer[1024] = {0};
+#ifdef _WIN32
+    int valread = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
+#else
+    ssize_t valread = read(client_socket, buffer, sizeof(buffer) - 1);
+#endif
+    
+    if (valread == 0) {
+        // Client disconnected
+        LOG_INFO("Client disconnected");
+        return false;
+    } 
+#ifdef _WIN32
+    if (valread == SOCKET_ERROR) {
+        if (WSAGetLastError() == WSAEWOULDBLOCK) {
+            return true;
+        }
+        LOG_ERR("Recv failed: " + std::to_string(WSAGetLastError()));
+        return false;
+    }
+#else
+    if (valread < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return true;
+        }
+        LOG_ERR("Read failed: " + std::string(strerror(errno)));
+        return false;
+    }
+#endif
+    return dispatch_read(client_socket, buffer, (size_t)valread);
+}
+
+bool GameServer::read_tls(int client) {
+    TRACE_SCOPE("GameServer::read_tls");
+    char buffer[1024];
+    // OpenSSL buffers whole records, so select() would not report what is
+    // left of one; keep reading until the socket is empty
+    while (true) {
+        TlsConnection::Result result;
+        size_t len = 0;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            auto it = tlsConnections.find(client);
+            if (it == tlsConnections.end()) {
+                return false;
+            }
+            TlsConnection& session = *it->second;
+            bool established = session.isEstablished();
+            result = session.handshake();
+            if (result == TlsConnection::Result::Done) {
+                if (!established) {
+                    LOG_DEBUG("TLS handshake with client " + std::to_string(client) + " done" +
+                              (session.wasResumed() ? " (resumed)" : "") +
+                              (session.isKernelOffloaded() ? " (kTLS)" : ""));
+                }
+                len = session.read(buffer, sizeof(buffer), result);
+            }
+        }
+        switch (result) {
+            case TlsConnection::Result::Done:
+                break;
+            case TlsConnection::Result::WantRead:
+            case TlsConnection::Result::WantWrite:
+                return true;
+            case TlsConnection::Result::Closed:
+                LOG_INFO("Client disconnected");
+                return false;
+            case TlsConnection::Result::Failed:
+                return false;
+        }
+        if (!dispatch_read(client, buffer, len)) {
+            return false;
+        }
+        // The rest stays with OpenSSL until the held read is admitted
+        if (throttled.count(client)) {
+            return true;
+        }
+    }
+}
+
+bool GameServer::dispatch_read(int client, const char* data, size_t len) {
+    // Bytes are never dropped from the middle of a stream: a read over the
+    // limit is held and the socket is left unread, so TCP slows the sender.
+    // TLS input is only charged after decryption, see read_tls().
+    auto held = throttled.find(client);
+    if (held != throttled.end()) {
+        // Received before reading stopped; it goes after the held bytes
+        held->second.append(data, len);
+        return true;
+    }
+    RateLimiter::Verdict verdict = limiter ? limiter->admitRead(client, len) : RateLimiter::Verdict::Allow;
+    if (verdict == RateLimiter::Verdict::Disconnect) {
+        LOG_WARN("Disconnecting client " + std::to_string(client) + ": rate limit exceeded");
+        return false;
+    }
+    if (verdict == RateLimiter::Verdict::Throttle) {
+        // run_select() leaves held clients out of read_fds
+        throttled[client].assign(data, len);
+#ifdef GAMESERVER_HAS_IO_URING
+        if (uring) {
+            uring->pauseReading(client);
+            if (throttled.size() == 1) {
+                schedule_throttle_retry();
+            }
+        }
+#endif
+        return true;
+    }
+    process_input(client, data, len);
+    return true;
+}
+
+void GameServer::process_input(int client, const char* data, size_t len) {
+    std::string reply;
+    handle_input(client, data, len, reply);
+    if (reply.empty()) {
+        return;
+    }
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        uring->send(client, reply.data(), reply.size());
+        return;
+    }
+#endif
+    send_to_client(client, reply.data(), reply.size());
+}
+
+void GameServer::retry_throttled() {
+    std::vector<int> resumed;
+    std::vector<int> closing;
+    for (auto it = throttled.begin(); it != throttled.end();) {
+        int client = it->first;
+        RateLimiter::Verdict verdict = limiter ? limiter->admitRead(client, it->second.size())
+                                               : RateLimiter::Verdict::Allow;
+        if (verdict == RateLimiter::Verdict::Throttle) {
+            ++it;
+            continue;
+        }
+        std::string data = std::move(it->second);
+        it = throttled.erase(it);
+        if (verdict == RateLimiter::Verdict::Disconnect) {
+            LOG_WARN("Disconnecting client " + std::to_string(client) + ": rate limit exceeded");
+            closing.push_back(client);
+            continue;
+        }
+        process_input(client, data.data(), data.size());
+        resumed.push_back(client);
+    }
+
+    for (int client : resumed) {
+#ifdef GAMESERVER_HAS_IO_URING
+        if (uring) {
+            uring->resumeReading(client);
+            continue;
+        }
+#endif
+        // Records OpenSSL already decrypted would not wake select()
+        bool tlsClient;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            tlsClient = tlsConnections.count(client) != 0;
+        }
+        if (tlsClient && !read_tls(client)) {
+            closing.push_back(client);
+        }
+    }
+
+    for (int client : closing) {
+#ifdef GAMESERVER_HAS_IO_URING
+        if (uring) {
+            uring->disconnect(client);
+            continue;
+        }
+#endif
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            client_sockets.erase(std::remove(client_sockets.begin(), client_sockets.end(), client),
+                                 client_sockets.end());
+        }
+        close_client(client);
+    }
+}
+
+void GameServer::schedule_throttle_retry() {
+#ifdef GAMESERVER_HAS_IO_URING
+    // The timer belongs to the drain or the handoff while one runs; held
+    // input is dropped by the first and carried over by the second
+    if (!uring || throttled.empty() || draining || handingOff) {
+        return;
+    }
+    uring->setTimerHandler(THROTTLE_RETRY_INTERVAL, [this]() {
+        retry_throttled();
+        if (throttled.empty()) {
+            uring->setTimerHandler(std::chrono::milliseconds(0), nullptr);
+        }
+    });
+#endif
+}
+
+long GameServer::write_client(int client, const char* data, size_t len, bool& wouldBlock) {
+    wouldBlock = false;
+    auto session = tlsConnections.find(client);
+    if (session != tlsConnections.end()) {
+        // Output queues up until the handshake is done
+        if (!session->second->isEstablished()) {
+            wouldBlock = true;
+            return 0;
+        }
+        // Partial writes end on a record boundary; go on until the socket is full
+        size_t written = 0;
+        while (written < len) {
+            TlsConnection::Result result;
+            written += session->second->write(data + written, len - written, result);
+            if (result == TlsConnection::Result::WantRead || result == TlsConnection::Result::WantWrite) {
+                wouldBlock = written == 0;
+                break;
+            }
+            if (result != TlsConnection::Result::Done) {
+                return -1;
+            }
+        }
+        return (long)written;
+    }
+#ifdef _WIN32
+    int result = send(client, data, (int)len, 0);
+    wouldBlock = result == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    ssize_t result = send(client, data, len, SEND_FLAGS);
+    wouldBlock = result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+    return wouldBlock ? 0 : (long)result;
+}
+
+void GameServer::send_to_client(int client, const char* data, size_t len) {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    auto pending = outbound.find(client);
+    size_t written = 0;
+    // Anything already queued has to go out first
+    if (pending == outbound.end()) {
+        bool wouldBlock;
+        long result = write_client(client, data, len, wouldBlock);
+        if (result < 0 && !wouldBlock) {
+            // The read side sees the same error and closes the socket
+            return;
+        }
+        written = result > 0 ? (size_t)result : 0;
+    }
+    if (written == len) {
+        return;
+    }
+
+    bool firstQueued = pending == outbound.end();
+    std::string& queue = outbound[client];
+    if (queue.size() + len - written > MAX_OUTBOUND_BYTES) {
+        LOG_WARN("Client " + std::to_string(client) + " is not reading, dropping its output");
+        outbound.erase(client);
+#ifdef _WIN32
+        shutdown(client, SD_BOTH);
+#else
+        shutdown(client, SHUT_RDWR);
+#endif
+        return;
+    }
+    queue.append(data + written, len - written);
+    // The network thread may be blocked in select() without this socket in write_fds
+    if (firstQueued) {
+        wake_loop();
+    }
+}
+
+void GameServer::flush_outbound() {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (auto it = outbound.begin(); it != outbound.end();) {
+        if (!FD_ISSET(it->first, &write_fds)) {
+            ++it;
+            continue;
+        }
+        std::string& queue = it->second;
+        bool wouldBlock;
+        long result = write_client(it->first, queue.data(), queue.size(), wouldBlock);
+        if (result > 0) {
+            queue.erase(0, (size_t)result);
+        } else if (!wouldBlock) {
+            queue.clear();
+        }
+        if (queue.empty()) {
+            it = outbound.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void GameServer::close_client(int client) {
+    handle_disconnect(client);
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        outbound.erase(client);
+        auto session = tlsConnections.find(client);
+        if (session != tlsConnections.end()) {
+            session->second->shutdown();
+            tlsConnections.erase(session);
+        }
+    }
+#ifdef _WIN32
+    closesocket(client);
+#else
+    close(client);
+#endif
+}
+
+void GameServer::handle_input(int client, const char* data, size_t len, std::string& reply) {
+    auto stream = inbound.find(client);
+    if (stream == inbound.end()) {
+        size_t commandLen = protocol::binaryCommandLength(data, len);
+        if (commandLen == 0) {
+            handle_message(client, data, len, reply);
+            return;
+        }
+        // Frames may follow the switch in the same read
+        reply = protocol::BINARY_REPLY;
+        serverMetrics().bytesSent.inc(reply.size());
+        stream = inbound.emplace(client, std::string()).first;
+        data += commandLen;
+        len -= commandLen;
+    }
+
+    std::string& buffer = stream->second;
+    buffer.append(data, len);
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        const uint8_t* start = (const uint8_t*)buffer.data() + offset;
+        size_t available = buffer.size() - offset;
+        size_t size = 0;
+        protocol::FrameStatus status = protocol::findFrame(start, available, protocol::MAX_FRAME_SIZE, size);
+        if (status == protocol::FrameStatus::Incomplete) {
+            break;
+        }
+        if (status == protocol::FrameStatus::Invalid) {
+            // No frame boundary to resume from: reported as one bad frame, and
+            // the rest of what is buffered goes with it
+            size = available;
+        }
+        ServerMetrics& metrics = serverMetrics();
+        metrics.messagesReceived.inc();
+        metrics.bytesReceived.inc(size);
+        std::string frameReply;
+        binary_reply(start, size, frameReply);
+        metrics.bytesSent.inc(frameReply.size());
+        reply += frameReply;
+        offset += size;
+    }
+    buffer.erase(0, offset);
+}
+
+void GameServer::handle_message(int client, const char* data, size_t len, std::string& reply) {
+    TRACE_SCOPE("GameServer::handle_message");
+    ServerMetrics& metrics = serverMetrics();
+    metrics.messagesReceived.inc();
+    metrics.bytesReceived.inc(len);
+
+    // "JOIN <roomId>" places the connection's player in a room
+    const size_t joinLen = sizeof(JOIN_COMMAND) - 1;
+    if (len > joinLen && strncmp(data, JOIN_COMMAND, joinLen) == 0) {
+        int roomId = parseRoomId(data + joinLen, len - joinLen);
+        if (roomId > 0 && join_room(client, roomId)) {
+            reply = "JOINED " + std::to_string(roomId) + "\n";
+        } else {
+            reply = "JOIN_FAILED " + std::to_string(roomId) + "\n";
+        }
+        metrics.bytesSent.inc(reply.size());
+        return;
+    }
+    const size_t spectateLen = sizeof(SPECTATE_COMMAND) - 1;
+    if (len > spectateLen && strncmp(data, SPECTATE_COMMAND, spectateLen) == 0) {
+        int roomId = parseRoomId(data + spectateLen, len - spectateLen);
+        if (roomId > 0 && spectate_room(client, roomId)) {
+            reply = "SPECTATING " + std::to_string(roomId) + "\n";
+        } else {
+            reply = "SPECTATE_FAILED " + std::to_string(roomId) + "\n";
+        }
+        metrics.bytesSent.inc(reply.size());
+        return;
+    }
+    const size_t topLen = sizeof(TOP_COMMAND) - 1;
+    const size_t rankLen = sizeof(RANK_COMMAND) - 1;
+    bool isTop = len > topLen && strncmp(data, TOP_COMMAND, topLen) == 0;
+    // RANK takes no argument; only a line ending may follow it
+    size_t commandLen = len;
+    while (commandLen > 0 && (data[commandLen - 1] == '\n' || data[commandLen - 1] == '\r')) {
+        --commandLen;
+    }
+    bool isRank = commandLen == rankLen && strncmp(data, RANK_COMMAND, rankLen) == 0;
+    if (leaderboards && (isTop || isRank)) {
+        leaderboard_reply(client, data, len, reply);
+        metrics.bytesSent.inc(reply.size());
+        return;
+    }
+
+    // Process data
+    LOG_DEBUG("Received: " + std::string(data, len));
+    // Echo back for testing
+    reply.assign(data, len);
+    metrics.bytesSent.inc(reply.size());
+}
+
+void GameServer::binary_reply(const uint8_t* data, size_t len, std::string& reply) {
+    TRACE_SCOPE("GameServer::binary_reply");
+    serverMetrics().binaryFrames.inc();
+    protocol::Ping ping;
+    if (protocol::decodeMessage(data, len, ping)) {
+        protocol::Pong pong;
+        pong.sequence = ping.sequence;
+        pong.clientTimeMs = ping.clientTimeMs;
+        pong.serverTimeMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        uint8_t frame[protocol::Pong::MAX_FRAME_SIZE];
+        reply.assign((const char*)frame, protocol::encodeMessage(pong, frame, sizeof(frame)));
+        return;
+    }
+    if (protocol::isValidFrame(data, len)) {
+        // Nothing simulates the game yet, so well-formed frames echo like text
+        reply.assign((const char*)data, len);
+        return;
+    }
+
+    serverMetrics().protocolErrors.inc();
+    protocol::ProtocolError error;
+    error.messageId = len > 1 && data[0] == protocol::FRAME_MAGIC ? data[1] : 0;
+    error.code = protocol::messageName(error.messageId) ? PROTOCOL_MALFORMED_FRAME : PROTOCOL_UNKNOWN_MESSAGE;
+    uint8_t frame[protocol::ProtocolError::MAX_FRAME_SIZE];
+    reply.assign((const char*)frame, protocol::encodeMessage(error, frame, sizeof(frame)));
+}
+
+void GameServer::leaderboard_reply(int client, const char* data, size_t len, std::string& reply) {
+    TRACE_SCOPE("GameServer::leaderboard_reply");
+    Leaderboard* board = leaderboards->findBoard(TOP_MODE, season);
+    if (data[0] == 'T') {
+        const size_t topLen = sizeof(TOP_COMMAND) - 1;
+        int requested = atoi(std::string(data + topLen, len - topLen).c_str());
+        size_t count = (size_t)std::max(0, requested);
+        reply = "TOP";
+        if (board) {
+            for (const auto& entry : board->getTop(std::min(count, MAX_TOP_ENTRIES))) {
+                reply += " " + std::to_string(entry.playerId) + ":" + std::to_string(entry.score);
+            }
+        }
+        reply += "\n";
+        return;
+    }
+
+    int playerId = 0;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(client);
+        if (it != sessions.end()) {
+            playerId = it->second.playerId;
+        }
+    }
+    int64_t score = 0;
+    size_t rank = 0;
+    if (board && playerId != 0 && board->getScore(playerId, score)) {
+        rank = board->getRank(playerId);
+    }
+    reply = "RANK " + std::to_string(rank) + " " + std::to_string(score) + "\n";
+}
+
+bool GameServer::join_room(int client, int roomId) {
+    int previousRoom = 0;
+    int playerId = 0;
+    int watchedRoom = 0;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(client);
+        if (it == sessions.end()) {
+            it = sessions.emplace(client, ClientSession{allocate_player_id(), 0}).first;
+        }
+        if (it->second.playerId == 0) {
+            // A spectator taking a seat; it keeps watching if that fails
+            watchedRoom = it->second.roomId;
+            playerId = allocate_player_id();
+        } else {
+            previousRoom = it->second.roomId;
+            playerId = it->second.playerId;
+        }
+    }
+    if (watchedRoom == 0 && previousRoom == roomId) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    auto roomIt = rooms.find(roomId);
+    if (roomIt == rooms.end()) {
+        return false;
+    }
+    auto player = std::make_shared<Player>(playerId, "player" + std::to_string(playerId));
+    if (!roomIt->second->addPlayer(player)) {
+        return false;
+    }
+
+    auto previousIt = rooms.find(previousRoom);
+    if (previousIt != rooms.end()) {
+        previousIt->second->removePlayer(playerId);
+    }
+    auto watchedIt = rooms.find(watchedRoom);
+    if (watchedIt != rooms.end()) {
+        watchedIt->second->removeSpectator(client);
+    }
+    std::lock_guard<std::mutex> sessionLock(sessionsMutex);
+    sessions[client] = ClientSession{playerId, roomId};
+    return true;
+}
+
+bool GameServer::spectate_room(int client, int roomId) {
+    int watchedRoom = 0;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(client);
+        if (it != sessions.end()) {
+            // Seated players have to stay with their room
+            if (it->second.playerId != 0 && it->second.roomId != 0) {
+                return false;
+            }
+            if (it->second.playerId == 0) {
+                watchedRoom = it->second.roomId;
+            }
+        }
+    }
+    if (watchedRoom == roomId) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    auto roomIt = rooms.find(roomId);
+    if (roomIt == rooms.end()) {
+        return false;
+    }
+    roomIt->second->getSpectatorStream().setDelay(spectatorDelay);
+    roomIt->second->addSpectator(client);
+
+    auto watchedIt = rooms.find(watchedRoom);
+    if (watchedIt != rooms.end()) {
+        watchedIt->second->removeSpectator(client);
+    }
+    // An unseated player gives up its id; JOIN hands out a new one
+    std::lock_guard<std::mutex> sessionLock(sessionsMutex);
+    sessions[client] = ClientSession{0, roomId};
+    return true;
+}
+
+void GameServer::handle_disconnect(int client) {
+    serverMetrics().connectionsClosed.inc();
+    serverMetrics().connectionsActive.sub(1);
+    if (limiter) {
+        limiter->connectionClosed(client);
+    }
+    inbound.erase(client);
+    throttled.erase(client);
+
+    ClientSession session;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(client);
+        if (it == sessions.end()) {
+            return;
+        }
+        session = it->second;
+        sessions.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    auto roomIt = rooms.find(session.roomId);
+    if (roomIt == rooms.end()) {
+        return;
+    }
+    if (session.playerId == 0) {
+        roomIt->second->removeSpectator(client);
+    } else {
+        roomIt->second->removePlayer(session.playerId);
+    }
+}
+
+void GameServer::broadcast_message(const std::string& message) {
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        // One shared buffer for every connection; all sends go out in one submission
+        serverMetrics().bytesSent.inc(message.size() * uring->getConnectionCount());
+        uring->broadcast(std::make_shared<const std::string>(message));
+        return;
+    }
+#endif
+    std::vector<int> clients;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.assign(client_sockets.begin(), client_sockets.end());
+    }
+    serverMetrics().bytesSent.inc(message.size() * clients.size());
+    for (int client_socket : clients) {
+        send_to_client(client_socket, message.data(), message.size());
+    }
+}
+
+std::shared_ptr<Room> GameServer::createRoom(const std::string& roomName, int maxPlayers) {
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    
+    int roomId = nextRoomId++;
+    auto room = std::make_shared<Room>(roomId, roomName, maxPlayers);
+    rooms[roomId] = room;
+    serverMetrics().rooms.set((int64_t)rooms.size());
+    
+    LOG_INFO("Created room " + std::to_string(roomId) + ": " + roomName);
+    return room;
+}
+
+bool GameServer::deleteRoom(int roomId) {
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    
+    auto it = rooms.find(roomId);
+    if (it != rooms.end()) {
+        rooms.erase(it);
+        serverMetrics().rooms.set((int64_t)rooms.size());
+        // Its players and spectators stay connected without a room
+        {
+            std::lock_guard<std::mutex> sessionLock(sessionsMutex);
+            for (auto& pair : sessions) {
+                if (pair.second.roomId == roomId) {
+                    pair.second.roomId = 0;
+                }
+            }
+        }
+        LOG_INFO("Deleted room " + std::to_string(roomId));
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<Room> GameServer::getRoom(int roomId) {
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    
+    auto it = rooms.find(roomId);
+    if (it != rooms.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<Room>> GameServer::getAllRooms() {
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    
+    std::vector<std::shared_ptr<Room>> roomList;
+    for (const auto& pair : rooms) {
+        roomList.push_back(pair.second);
+    }
+    return roomList;
+}
+
+void GameServer::listRooms() {
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    
+    LOG_INFO("=== Room List ===");
+    for (const auto& pair : rooms) {
+        auto room = pair.second;
+        std::string status = room->getIsStarted() ? " [IN GAME]" : "";
+        LOG_INFO("Room " + std::to_string(room->getRoomId()) + 
+                 " (" + room->getRoomName() + "): " +
+                 std::to_string(room->getPlayerCount()) + "/" + 
+                 std::to_string(room->getMaxPlayers()) + " players" + status);
+    }
+}
+
+// Plain text, one record per line, tab separated:
+//   room   <id> <maxPlayers> <started> <name>
+//   player <roomId> <id> <ready> <name>
+// Also the format rooms migrate between cluster nodes in.
+void GameServer::write_room_records(std::ostream& out, const Room& room, const std::set<int>& skipPlayers) {
+    out << "room\t" << room.getRoomId() << '\t' << room.getMaxPlayers() << '\t'
+        << (room.getIsStarted() ? 1 : 0) << '\t' << room.getRoomName() << '\n';
+    for (const auto& player : room.getPlayers()) {
+        if (skipPlayers.count(player->id)) {
+            continue;
+        }
+        out << "player\t" << room.getRoomId() << '\t' << player->id << '\t'
+            << (player->isReady ? 1 : 0) << '\t' << player->name << '\n';
+    }
+}
+
+std::set<int> GameServer::session_players() {
+    std::set<int> players;
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    for (const auto& pair : sessions) {
+        if (pair.second.playerId != 0) {
+            players.insert(pair.second.playerId);
+        }
+    }
+    return players;
+}
+
+size_t GameServer::read_room_records(std::istream& in, const std::string& source, bool replaceExisting) {
+    // Ids of connected players stay theirs; a record reusing one is dropped
+    std::set<int> connected = session_players();
+    int highestPlayerId = 0;
+    std::vector<std::shared_ptr<Room>> started;
+    std::set<int> accepted;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string kind;
+        int first = 0, second = 0, flag = 0;
+        std::string name;
+        if (!std::getline(fields, kind, '\t') || !(fields >> first >> second >> flag) ||
+            fields.get() != '\t' || !std::getline(fields, name)) {
+            LOG_WARN("Skipping malformed line " + std::to_string(lineNumber) + " in " + source);
+            continue;
+        }
+
+        if (kind == "room") {
+            if (!replaceExisting && rooms.count(first)) {
+                LOG_WARN("Room " + std::to_string(first) + " from " + source + " already exists, skipped");
+                continue;
+            }
+            auto room = std::make_shared<Room>(first, name, second);
+            if (flag != 0) {
+                started.push_back(room);
+            }
+            rooms[first] = room;
+            accepted.insert(first);
+            nextRoomId = std::max(nextRoomId, first + 1);
+        } else if (kind == "player") {
+            if (!accepted.count(first)) {
+                continue;
+            }
+            highestPlayerId = std::max(highestPlayerId, second);
+            if (connected.count(second)) {
+                LOG_WARN("Player " + std::to_string(second) + " from " + source +
+                         " has the id of a connected player, skipped");
+                continue;
+            }
+            auto player = std::make_shared<Player>(second, name);
+            player->isReady = flag != 0;
+            rooms[first]->addPlayer(player);
+        }
+    }
+    // Started rooms refuse new players, so the flag goes on after they are back
+    for (const auto& room : started) {
+        room->setIsStarted(true);
+    }
+    // New sessions must not be handed an id a restored player already has
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        nextPlayerId = std::max(nextPlayerId, highestPlayerId + 1);
+    }
+    serverMetrics().rooms.set((int64_t)rooms.size());
+    return accepted.size();
+}
+
+bool GameServer::saveRoomState(const std::string& filename) {
+    // Seats held by connections are gone once those connections close; saving
+    // them would bring back players nobody controls
+    std::set<int> connected = session_players();
+    std::ostringstream out;
+    size_t roomCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        for (const auto& pair : rooms) {
+            write_room_records(out, *pair.second, connected);
+        }
+        roomCount = rooms.size();
+    }
+
+    // Write then rename so a crash mid-write leaves the previous state intact
+    std::string tempFile = filename + ".tmp";
+    {
+        std::ofstream file(tempFile, std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERR("Failed to open room state file " + tempFile);
+            return false;
+        }
+        file << out.str();
+        if (!file.good()) {
+            LOG_ERR("Failed to write room state file " + tempFile);
+            return false;
+        }
+    }
+    if (std::rename(tempFile.c_str(), filename.c_str()) != 0) {
+        LOG_ERR("Failed to replace room state file " + filename);
+        return false;
+    }
+    LOG_INFO("Saved " + std::to_string(roomCount) + " rooms to " + filename);
+    return true;
+}
+
+bool GameServer::loadRoomState(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    size_t loaded = read_room_records(file, filename, true);
+    LOG_INFO("Restored " + std::to_string(loaded) + " rooms from " + filename);
+    return loaded > 0;
+}
+
+std::vector<int> GameServer::getRoomIds() {
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    std::vector<int> ids;
+    for (const auto& pair : rooms) {
+        ids.push_back(pair.first);
+    }
+    return ids;
+}
+
+bool GameServer::exportRoom(int roomId, std::string& data) {
+    std::ostringstream out;
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        auto it = rooms.find(roomId);
+        if (it == rooms.end()) {
+            return false;
+        }
+        // Players connected here rejoin on the new owner under a new
+        // session, so only the others travel with the room
+        write_room_records(out, *it->second, session_players());
+    }
+    data = out.str();
+    LOG_INFO("Exported room " + std::to_string(roomId));
+    return true;
+}
+
+size_t GameServer::importRooms(const std::string& data) {
+    std::istringstream in(data);
+    std::lock_guard<std::mutex> lock(roomsMutex);
+    size_t imported = read_room_records(in, "import", false);
+    LOG_INFO("Imported " + std::to_string(imported) + " rooms");
+    return imported;
+}
+
+void GameServer::setPersistence(WriteBehindStore* store) {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    persistence = store;
+    reservedPlayerIds = 0;
+    std::string stored;
+    if (persistence && persistence->get(PLAYER_ID_KEY, stored)) {
+        nextPlayerId = std::max(nextPlayerId, atoi(stored.c_str()));
+    }
+}
+
+int GameServer::allocate_player_id() {
+    int id = nextPlayerId++;
+    // Written before the id is used, so a restart on this store starts past it
+    if (persistence && id >= reservedPlayerIds) {
+        reservedPlayerIds = id + PLAYER_ID_BLOCK;
+        persistence->put(PLAYER_ID_KEY, std::to_string(reservedPlayerIds));
+    }
+    return id;
+}
+
+bool GameServer::finishGame(int roomId, int winnerId, const std::string& mode) {
+    TRACE_SCOPE("GameServer::finishGame");
+    MatchResult result;
+    std::vector<std::shared_ptr<Player>> players;
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        auto it = rooms.find(roomId);
+        if (it == rooms.end() || !it->second->getIsStarted()) {
+            return false;
+        }
+        // Players who left during the game still played it
+        players = it->second->getLineup();
+        if (players.empty()) {
+            players = it->second->getPlayers();
+        }
+        result.roomId = roomId;
+        result.roomName = it->second->getRoomName();
+        it->second->resetRoom();
+    }
+    result.winnerId = winnerId;
+    result.endedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (const auto& player : players) {
+        result.playerIds.push_back(player->id);
+    }
+    LOG_INFO("Game finished in room " + std::to_string(roomId) +
+             (winnerId ? ", winner " + std::to_string(winnerId) : ", no winner"));
+
+    // Everyone who played gets an entry, the winner one more win
+    Leaderboard* board = leaderboards ? leaderboards->getBoard(mode, season) : nullptr;
+    if (board) {
+        for (const auto& player : players) {
+            board->addScore(player->id, player->id == winnerId ? 1 : 0);
+        }
+    }
+
+    if (!persistence) {
+        return true;
+    }
+    // Only queues and journals; the write-behind thread does the storage I/O
+    persistence->put(result.key(), result.serialize());
+    for (const auto& player : players) {
+        PlayerStats stats;
+        std::string stored;
+        if (persistence->get(PlayerStats::key(player->id), stored)) {
+            PlayerStats::parse(stored, stats);
+        }
+        stats.name = player->name;
+        stats.gamesPlayed++;
+        if (player->id == winnerId) {
+            stats.wins++;
+        }
+        persistence->put(PlayerStats::key(player->id), stats.serialize());
+    }
+    return true;
+}
+
+void GameServer::CleanUpRooms(){
+    TRACE_SCOPE("GameServer::CleanUpRooms");
+
+}
+void GameServer::SendUpdatesToClients(){
+    TRACE_SCOPE("GameServer::SendUpdatesToClients");
+    std::set<int> backlogged = backlogged_spectators();
+    auto now = std::chrono::steady_clock::now();
+    uint32_t tick = ++spectatorTick;
+
+    // Spectators reading the same frames share one delivery. Reads in a tick
+    // all end at the same frame, so the first frame identifies the list.
+    struct Delivery {
+        std::vector<SpectatorStream::Frame> frames;
+        std::vector<int> clients;
+    };
+    std::map<const std::string*, Delivery> deliveries;
+    std::map<int, std::set<int>> views;
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        for (auto& pair : rooms) {
+            Room& room = *pair.second;
+            if (room.getSpectatorCount() == 0) {
+                continue;
+            }
+            // Encoded once per room, whatever the number of spectators
+            auto previous = spectatorViews.find(pair.first);
+            bool keyframe = tick % SPECTATOR_KEYFRAME_TICKS == 0 || previous == spectatorViews.end();
+            std::set<int>& view = views[pair.first];
+            protocol::Snapshot snapshot;
+            snapshot.tick = tick;
+            for (const auto& player : room.getPlayers()) {
+                view.insert(player->id);
+                if (keyframe || previous->second.count(player->id) == 0) {
+                    protocol::EntityState entity;
+                    entity.entityId = (uint32_t)player->id;
+                    entity.alive = true;
+                    snapshot.entities.push_back(entity);
+                }
+            }
+            if (!keyframe) {
+                for (int id : previous->second) {
+                    if (view.count(id) == 0) {
+                        protocol::EntityState entity;
+                        entity.entityId = (uint32_t)id;
+                        entity.alive = false;
+                        snapshot.entities.push_back(entity);
+                    }
+                }
+            }
+            SpectatorStream& stream = room.getSpectatorStream();
+            // A tick without changes appends nothing
+            if (keyframe || snapshot.entities.size() > 0) {
+                uint8_t frame[protocol::Snapshot::MAX_FRAME_SIZE];
+                size_t size = protocol::encodeMessage(snapshot, frame, sizeof(frame));
+                stream.append(std::make_shared<const std::string>((const char*)frame, size), keyframe, now);
+            }
+
+            std::vector<SpectatorStream::Frame> frames;
+            for (int client : stream.getSpectators()) {
+                if (backlogged.count(client) != 0) {
+                    stream.skip(client);
+                    continue;
+                }
+                frames.clear();
+                if (stream.read(client, now, frames) == 0) {
+                    continue;
+                }
+                Delivery& delivery = deliveries[frames.front().get()];
+                if (delivery.frames.empty()) {
+                    delivery.frames = frames;
+                }
+                delivery.clients.push_back(client);
+            }
+        }
+    }
+    spectatorViews.swap(views);
+
+    for (const auto& pair : deliveries) {
+        for (const auto& frame : pair.second.frames) {
+            send_shared(pair.second.clients, frame);
+        }
+    }
+}
+
+std::set<int> GameServer::backlogged_spectators() {
+    std::vector<int> spectators;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        for (const auto& pair : sessions) {
+            if (pair.second.playerId == 0 && pair.second.roomId != 0) {
+                spectators.push_back(pair.first);
+            }
+        }
+    }
+    std::set<int> backlogged;
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        for (int client : spectators) {
+            if (uring->getQueuedBytes(client) > SPECTATOR_BACKLOG_BYTES) {
+                backlogged.insert(client);
+            }
+        }
+        return backlogged;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (int client : spectators) {
+        auto pending = outbound.find(client);
+        if (pending != outbound.end() && pending->second.size() > SPECTATOR_BACKLOG_BYTES) {
+            backlogged.insert(client);
+        }
+    }
+    return backlogged;
+}
+
+void GameServer::send_shared(const std::vector<int>& clients, const std::shared_ptr<const std::string>& frame) {
+    serverMetrics().bytesSent.inc(frame->size() * clients.size());
+#ifdef GAMESERVER_HAS_IO_URING
+    if (uring) {
+        // The buffer is queued on every socket as is, no copies
+        uring->multicast(clients, frame);
+        return;
+    }
+#endif
+    for (int client : clients) {
+        send_to_client(client, frame->data(), frame->size());
+    }
+}
+void GameServer::HandleGameLogic(){
+    TRACE_SCOPE("GameServer::HandleGameLogic");
+    // Nothing simulates a game yet, so the only way one ends is by players
+    // leaving it: the last one left wins, an empty room ends without a winner
+    std::vector<std::pair<int, int>> finished;
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        for (const auto& pair : rooms) {
+            const Room& room = *pair.second;
+            if (!room.getIsStarted() || room.getPlayerCount() > 1) {
+                continue;
+            }
+            auto players = room.getPlayers();
+            finished.emplace_back(pair.first, players.empty() ? 0 : players.front()->id);
+        }
+    }
+    for (const auto& game : finished) {
+        finishGame(game.first, game.second);
+    }
+}
+void GameServer::recordTick(std::chrono::microseconds duration) {
+    serverMetrics().tickDuration.record((uint64_t)duration.count());
+}
+
+void GameServer::LogServerStats(){
+    TRACE_SCOPE("GameServer::LogServerStats");
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastStatsTime < statsInterval) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - lastStatsTime).count();
+    lastStatsTime = now;
+
+    ServerMetrics& metrics = serverMetrics();
+
+    // Room gauges are refreshed here rather than on every join/leave
+    {
+        std::lock_guard<std::mutex> lock(roomsMutex);
+        int64_t inGame = 0;
+        int64_t playerCount = 0;
+        int64_t spectatorCount = 0;
+        for (const auto& pair : rooms) {
+            if (pair.second->getIsStarted()) {
+                ++inGame;
+            }
+            playerCount += pair.second->getPlayerCount();
+            spectatorCount += pair.second->getSpectatorCount();
+        }
+        metrics.rooms.set((int64_t)rooms.size());
+        metrics.roomsInGame.set(inGame);
+        metrics.players.set(playerCount);
+        metrics.spectators.set(spectatorCount);
+    }
+
+    uint64_t messages = metrics.messagesReceived.value();
+    uint64_t bytesIn = metrics.bytesReceived.value();
+    uint64_t bytesOut = metrics.bytesSent.value();
+    HistogramSnapshot tick = metrics.tickDuration.snapshot();
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "Stats: %lld connections, %.0f msg/s, in %.1f KB/s, out %.1f KB/s, "
+             "%lld rooms (%lld in game), %lld players, tick p50 %llu us p99 %llu us",
+             (long long)metrics.connectionsActive.value(),
+             (double)(messages - lastMessages) / elapsed,
+             (double)(bytesIn - lastBytesReceived) / elapsed / 1024.0,
+             (double)(bytesOut - lastBytesSent) / elapsed / 1024.0,
+             (long long)metrics.rooms.value(),
+             (long long)metrics.roomsInGame.value(),
+             (long long)metrics.players.value(),
+             (unsigned long long)tick.percentile(0.50),
+             (unsigned long long)tick.percentile(0.99));
+    LOG_INFO(line);
 
+    lastMessages = messages;
+    lastBytesReceived = bytesIn;
+    lastBytesSent = bytesOut;
 }
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include "core/HotRestart.h"
+#include "utils/Logger.h"
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <errno.h>
+#endif
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const uint32_t HANDOFF_MAGIC = 0x4F485347;   // "GSHO"
+const uint32_t HANDOFF_VERSION = 4;
+const char HANDOFF_ACK = 'K';
+
+// SCM_MAX_FD on Linux; more than this per message is rejected by the kernel
+const size_t FDS_PER_MESSAGE = 253;
+
+struct HandoffHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t snapshotSize;
+    uint32_t fdCount;
+};
+
+} // namespace
+
+void SnapshotWriter::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((char)value);
+}
+
+void SnapshotWriter::putString(const std::string& value) {
+    putVarint(value.size());
+    buffer.append(value);
+}
+
+bool SnapshotReader::getVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= data.size()) {
+            return false;
+        }
+        uint8_t byte = (uint8_t)data[offset++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SnapshotReader::getString(std::string& value) {
+    uint64_t size;
+    if (!getVarint(size) || size > data.size() - offset) {
+        return false;
+    }
+    value.assign(data, offset, (size_t)size);
+    offset += (size_t)size;
+    return true;
+}
+
+HandoffListener::HandoffListener()
+    : socketInode(0)
+    , listenFd(-1)
+    , running(false) {}
+
+HandoffListener::~HandoffListener() {
+    stop();
+}
+
+#ifdef _WIN32
+
+bool HandoffListener::start(const std::string& path, Handler handler) {
+    LOG_WARN("Hot restart is not supported on Windows");
+    return false;
+}
+
+void HandoffListener::stop() {}
+void HandoffListener::serve() {}
+
+int connectHandoff(const std::string& path) {
+    LOG_ERR("Hot restart is not supported on Windows");
+    return -1;
+}
+
+bool sendHandoff(int channel, const std::string& snapshot, const std::vector<int>& fds) {
+    return false;
+}
+
+bool receiveHandoff(int channel, std::string& snapshot, std::vector<int>& fds) {
+    return false;
+}
+
+bool acknowledgeHandoff(int channel) {
+    return false;
+}
+
+bool waitForRelease(int channel) {
+    return false;
+}
+
+#else
+
+namespace {
+
+bool makeAddress(const std::string& path, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        LOG_ERR("Invalid handoff socket path: " + path);
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+bool sendAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+bool recvAll(int fd, char* data, size_t len) {
+    while (len > 0) {
+        ssize_t received = recv(fd, data, len, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        len -= (size_t)received;
+    }
+    return true;
+}
+
+void setTimeout(int fd, int seconds) {
+    struct timeval timeout;
+    timeout.tv_sec = seconds;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+} // namespace
+
+bool HandoffListener::start(const std::string& path, Handler handler) {
+    if (running) {
+        return true;
+    }
+    struct sockaddr_un addr;
+    if (!makeAddress(path, addr)) {
+        return false;
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        LOG_ERR("Handoff socket: failed to create socket");
+        return false;
+    }
+    // A previous owner is either gone or has already handed off to us
+    unlink(path.c_str());
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 4) < 0) {
+        LOG_ERR("Handoff socket: bind/listen on " + path + " failed: " + std::string(strerror(errno)));
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    // Only the owner may start a takeover
+    chmod(path.c_str(), 0600);
+
+    struct stat info;
+    socketInode = stat(path.c_str(), &info) == 0 ? (unsigned long)info.st_ino : 0;
+    socketPath = path;
+    onRequest = std::move(handler);
+    running = true;
+    worker = std::thread(&HandoffListener::serve, this);
+    LOG_INFO("Accepting hot restart requests on " + path);
+    return true;
+}
+
+void HandoffListener::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    close(listenFd);
+    listenFd = -1;
+
+    // A successor may already have bound its own socket at this path
+    struct stat info;
+    if (stat(socketPath.c_str(), &info) == 0 && (unsigned long)info.st_ino == socketInode) {
+        unlink(socketPath.c_str());
+    }
+}
+
+void HandoffListener::serve() {
+    while (running) {
+        // Short poll timeout so stop() does not need to wake us up
+        struct pollfd pfd;
+        pfd.fd = listenFd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int channel = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (channel < 0) {
+            continue;
+        }
+        LOG_INFO("Hot restart requested by a new process");
+        onRequest(channel);
+    }
+}
+
+int connectHandoff(const std::string& path) {
+    struct sockaddr_un addr;
+    if (!makeAddress(path, addr)) {
+        return -1;
+    }
+    int channel = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (channel < 0) {
+        LOG_ERR("Handoff: failed to create socket");
+        return -1;
+    }
+    if (connect(channel, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        LOG_ERR("Handoff: cannot connect to " + path + ": " + std::string(strerror(errno)));
+        close(channel);
+        return -1;
+    }
+    // The old server has to quiesce first, that is bounded by its flush timeout
+    setTimeout(channel, 10);
+    return channel;
+}
+
+bool sendHandoff(int channel, const std::string& snapshot, const std::vector<int>& fds) {
+    setTimeout(channel, 5);
+    HandoffHeader header = {HANDOFF_MAGIC, HANDOFF_VERSION,
+                            (uint32_t)snapshot.size(), (uint32_t)fds.size()};
+    if (!sendAll(channel, (const char*)&header, sizeof(header)) ||
+        !sendAll(channel, snapshot.data(), snapshot.size())) {
+        LOG_ERR("Handoff: failed to send snapshot: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    // Descriptors go in batches; each message carries its count as payload
+    std::vector<char> control(CMSG_SPACE(FDS_PER_MESSAGE * sizeof(int)));
+    for (size_t sent = 0; sent < fds.size();) {
+        uint32_t count = (uint32_t)std::min(FDS_PER_MESSAGE, fds.size() - sent);
+        struct iovec iov;
+        iov.iov_base = &count;
+        iov.iov_len = sizeof(count);
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fds[sent], count * sizeof(int));
+
+        ssize_t result;
+        do {
+            result = sendmsg(channel, &msg, MSG_NOSIGNAL);
+        } while (result < 0 && errno == EINTR);
+        if (result != (ssize_t)sizeof(count)) {
+            LOG_ERR("Handoff: failed to pass sockets: " + std::string(strerror(errno)));
+            return false;
+        }
+        sent += count;
+    }
+
+    char ack = 0;
+    if (!recvAll(channel, &ack, 1) || ack != HANDOFF_ACK) {
+        LOG_ERR("Handoff: new process did not acknowledge");
+        return false;
+    }
+    return true;
+}
+
+bool receiveHandoff(int channel, std::string& snapshot, std::vector<int>& fds) {
+    HandoffHeader header;
+    if (!recvAll(channel, (char*)&header, sizeof(header))) {
+        LOG_ERR("Handoff: no response from the running server");
+        return false;
+    }
+    if (header.magic != HANDOFF_MAGIC || header.version != HANDOFF_VERSION) {
+        LOG_ERR("Handoff: incompatible protocol version " + std::to_string(header.version));
+        return false;
+    }
+    snapshot.resize(header.snapshotSize);
+    if (!recvAll(channel, &snapshot[0], snapshot.size())) {
+        LOG_ERR("Handoff: snapshot truncated");
+        return false;
+    }
+
+    fds.clear();
+    fds.reserve(header.fdCount);
+    std::vector<char> control(CMSG_SPACE(FDS_PER_MESSAGE * sizeof(int)));
+    while (fds.size() < header.fdCount) {
+        uint32_t count = 0;
+        struct iovec iov;
+        iov.iov_base = &count;
+        iov.iov_len = sizeof(count);
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+
+        ssize_t result;
+        do {
+            result = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+        } while (result < 0 && errno == EINTR);
+        if (result != (ssize_t)sizeof(count)) {
+            LOG_ERR("Handoff: failed to receive sockets");
+            break;
+        }
+
+        size_t received = 0;
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int* data = (const int*)CMSG_DATA(cmsg);
+            fds.insert(fds.end(), data, data + n);
+            received += n;
+        }
+        // Truncation means we hit RLIMIT_NOFILE and the rest were dropped
+        if ((msg.msg_flags & MSG_CTRUNC) || received != count) {
+            LOG_ERR("Handoff: sockets were dropped in transit, raise the open file limit");
+            break;
+        }
+    }
+
+    if (fds.size() != header.fdCount) {
+        for (int fd : fds) {
+            close(fd);
+        }
+        fds.clear();
+        return false;
+    }
+    return true;
+}
+
+bool acknowledgeHandoff(int channel) {
+    return sendAll(channel, &HANDOFF_ACK, 1);
+}
+
+bool waitForRelease(int channel) {
+    // Nothing else is sent on the channel, only its end-of-file
+    char byte;
+    ssize_t received;
+    do {
+        received = recv(channel, &byte, 1, 0);
+    } while (received < 0 && errno == EINTR);
+    return received == 0;
+}
+
+#endif
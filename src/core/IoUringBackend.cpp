@@ -0,0 +1,895 @@
+#include "core/IoUringBackend.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include "utils/Trace.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nrArgs) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+template <typename T>
+T loadAcquire(const T* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+void storeRelease(T* p, T v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+// In C++ the uapi flex-array union places bufs[] after an empty struct, so
+// io_uring_buf_ring::bufs is not at offset 0. Index the ring directly instead.
+io_uring_buf* ringBuffers(io_uring_buf_ring* ring) {
+    return reinterpret_cast<io_uring_buf*>(ring);
+}
+
+Gauge& sendQueueDepth() {
+    static Gauge& gauge = MetricsRegistry::getInstance().gauge(
+        "gameserver_send_queue_depth", "Sends queued on io_uring connections");
+    return gauge;
+}
+
+const uint16_t BUFFER_GROUP = 0;
+const unsigned BUFFER_COUNT = 1024;   // must be a power of two
+const unsigned BUFFER_SIZE = 4096;
+
+} // namespace
+
+IoUringBackend::IoUringBackend()
+    : ringFd(-1)
+    , listenFd(-1)
+    , sqRingPtr(nullptr)
+    , sqRingSize(0)
+    , sqHead(nullptr)
+    , sqTail(nullptr)
+    , sqMask(nullptr)
+    , sqArray(nullptr)
+    , sqes(nullptr)
+    , sqesSize(0)
+    , sqEntries(0)
+    , sqLocalTail(0)
+    , cqRingPtr(nullptr)
+    , cqRingSize(0)
+    , cqHead(nullptr)
+    , cqTail(nullptr)
+    , cqMask(nullptr)
+    , cqes(nullptr)
+    , bufRing(nullptr)
+    , bufRingSize(0)
+    , bufPool(nullptr)
+    , bufCount(0)
+    , bufSize(0)
+    , bufTail(0)
+    , nextGeneration(1)
+    , running(false)
+    , acceptStopped(false)
+    , readingPaused(false)
+    , sendingPaused(false)
+    , wakeFd(-1)
+    , wakeValue(0)
+    , timerIntervalNanos(0)
+    , timerSpec{0, 0}
+    , timerArmed(false) {}
+
+IoUringBackend::~IoUringBackend() {
+    for (auto& pair : connections) {
+        sendQueueDepth().sub((int64_t)pair.second.sendQueue.size());
+        close(pair.first);
+    }
+    connections.clear();
+
+    if (bufRing) {
+        munmap(bufRing, bufRingSize);
+    }
+    delete[] bufPool;
+    if (sqes) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRingPtr && cqRingPtr != sqRingPtr) {
+        munmap(cqRingPtr, cqRingSize);
+    }
+    if (sqRingPtr) {
+        munmap(sqRingPtr, sqRingSize);
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+    }
+}
+
+bool IoUringBackend::initialize(int listen_fd, unsigned entries) {
+    listenFd = listen_fd;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+
+    ringFd = sys_io_uring_setup(entries, &params);
+    if (ringFd < 0 && errno == EINVAL) {
+        // Older kernels reject the optional setup flags; retry with defaults
+        memset(&params, 0, sizeof(params));
+        ringFd = sys_io_uring_setup(entries, &params);
+    }
+    if (ringFd < 0) {
+        LOG_WARN("io_uring_setup failed: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRingPtr = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRingPtr == MAP_FAILED) {
+        sqRingPtr = nullptr;
+        LOG_WARN("io_uring SQ ring mmap failed: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    if (singleMmap) {
+        cqRingPtr = sqRingPtr;
+    } else {
+        cqRingPtr = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRingPtr == MAP_FAILED) {
+            cqRingPtr = nullptr;
+            LOG_WARN("io_uring CQ ring mmap failed: " + std::string(strerror(errno)));
+            return false;
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesPtr == MAP_FAILED) {
+        LOG_WARN("io_uring SQE mmap failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(sqesPtr);
+
+    char* sq = static_cast<char*>(sqRingPtr);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqEntries = params.sq_entries;
+    sqLocalTail = *sqTail;
+
+    char* cq = static_cast<char*>(cqRingPtr);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Register the provided buffer ring used by multishot recv
+    bufCount = BUFFER_COUNT;
+    bufSize = BUFFER_SIZE;
+    bufRingSize = bufCount * sizeof(io_uring_buf);
+    void* ringMem = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMem == MAP_FAILED) {
+        LOG_WARN("io_uring buffer ring allocation failed");
+        return false;
+    }
+    bufRing = static_cast<io_uring_buf_ring*>(ringMem);
+    bufPool = new char[(size_t)bufCount * bufSize];
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = bufCount;
+    reg.bgid = BUFFER_GROUP;
+    if (sys_io_uring_register(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LOG_WARN("io_uring buffer ring registration failed: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    bufTail = 0;
+    for (unsigned i = 0; i < bufCount; ++i) {
+        io_uring_buf& buf = ringBuffers(bufRing)[i];
+        buf.addr = reinterpret_cast<uint64_t>(bufPool + (size_t)i * bufSize);
+        buf.len = bufSize;
+        buf.bid = (uint16_t)i;
+        ++bufTail;
+    }
+    storeRelease(&bufRing->tail, bufTail);
+
+    LOG_INFO("io_uring backend initialized (" + std::to_string(sqEntries) + " SQ entries, " +
+             std::to_string(bufCount) + " x " + std::to_string(bufSize) + " byte recv buffers)");
+    return true;
+}
+
+uint64_t IoUringBackend::encodeUserData(OpType type, int fd, uint32_t generation) {
+    return (uint64_t)type
+         | ((uint64_t)(uint32_t)fd << 8)
+         | ((uint64_t)(generation & 0xFFFFFF) << 40);
+}
+
+io_uring_sqe* IoUringBackend::getSqe() {
+    // Caller holds sqMutex
+    if (sqLocalTail - loadAcquire(sqHead) >= sqEntries) {
+        // Ring is full: hand what we have to the kernel before queueing more
+        submitPending(0);
+        if (sqLocalTail - loadAcquire(sqHead) >= sqEntries) {
+            return nullptr;
+        }
+    }
+
+    unsigned index = sqLocalTail & *sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    ++sqLocalTail;
+    return sqe;
+}
+
+void IoUringBackend::submitPending(unsigned waitFor) {
+    // Caller holds sqMutex
+    storeRelease(sqTail, sqLocalTail);
+    unsigned toSubmit = sqLocalTail - loadAcquire(sqHead);
+    if (toSubmit == 0 && waitFor == 0) {
+        return;
+    }
+    unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (sys_io_uring_enter(ringFd, toSubmit, waitFor, flags) < 0 &&
+        errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG_ERR("io_uring_enter failed: " + std::string(strerror(errno)));
+    }
+}
+
+void IoUringBackend::armAccept() {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        LOG_ERR("io_uring SQ full, cannot arm accept");
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = encodeUserData(OP_ACCEPT, listenFd, 0);
+}
+
+void IoUringBackend::armWakeRead() {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        LOG_ERR("io_uring SQ full, cannot arm wake read");
+        return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeFd;
+    sqe->addr = reinterpret_cast<uint64_t>(&wakeValue);
+    sqe->len = sizeof(wakeValue);
+    sqe->user_data = encodeUserData(OP_EVENTFD, wakeFd, 0);
+}
+
+void IoUringBackend::armTimer() {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        LOG_ERR("io_uring SQ full, cannot arm timer");
+        return;
+    }
+    timerSpec.tv_sec = timerIntervalNanos / 1000000000;
+    timerSpec.tv_nsec = timerIntervalNanos % 1000000000;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&timerSpec);
+    sqe->len = 1;
+    sqe->user_data = encodeUserData(OP_TIMER, -1, 0);
+    timerArmed = true;
+}
+
+void IoUringBackend::setWakeHandler(int eventFd, EventHandler handler) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    wakeFd = eventFd;
+    onWake = std::move(handler);
+}
+
+void IoUringBackend::setTimerHandler(std::chrono::milliseconds interval, EventHandler handler) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    timerIntervalNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count();
+    onTimer = std::move(handler);
+    // A running timer picks the new handler up when it fires next
+    if (onTimer && !timerArmed && ringFd >= 0 && running) {
+        armTimer();
+    }
+}
+
+void IoUringBackend::stopAccepting() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    if (acceptStopped) {
+        return;
+    }
+    acceptStopped = true;
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = encodeUserData(OP_ACCEPT, listenFd, 0);
+    sqe->user_data = encodeUserData(OP_CANCEL, -1, 0);
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::pause() {
+    stopAccepting();
+    std::lock_guard<std::mutex> lock(sqMutex);
+    readingPaused = true;
+    for (const auto& pair : connections) {
+        if (!pair.second.recvArmed || pair.second.closing) {
+            continue;
+        }
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) {
+            LOG_ERR("io_uring SQ full, cannot cancel recv");
+            continue;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = encodeUserData(OP_RECV, pair.first, pair.second.generation);
+        sqe->user_data = encodeUserData(OP_CANCEL, -1, 0);
+    }
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::pauseReading(int fd) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    auto it = connections.find(fd);
+    if (it == connections.end() || it->second.readPaused) {
+        return;
+    }
+    Connection& conn = it->second;
+    conn.readPaused = true;
+    if (!conn.recvArmed || conn.closing) {
+        return;
+    }
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        LOG_ERR("io_uring SQ full, cannot cancel recv");
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = encodeUserData(OP_RECV, fd, conn.generation);
+    sqe->user_data = encodeUserData(OP_CANCEL, -1, 0);
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::resumeReading(int fd) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    auto it = connections.find(fd);
+    if (it == connections.end() || !it->second.readPaused) {
+        return;
+    }
+    Connection& conn = it->second;
+    conn.readPaused = false;
+    if (!conn.recvArmed && !conn.closing && !readingPaused) {
+        armRecv(fd, conn);
+        if (!inLoopThread()) {
+            submitPending(0);
+        }
+    }
+}
+
+void IoUringBackend::pauseSends() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    if (sendingPaused) {
+        return;
+    }
+    sendingPaused = true;
+    for (const auto& pair : connections) {
+        if (!pair.second.sending) {
+            continue;
+        }
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) {
+            LOG_ERR("io_uring SQ full, cannot cancel send");
+            continue;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = encodeUserData(OP_SEND, pair.first, pair.second.generation);
+        sqe->user_data = encodeUserData(OP_CANCEL, -1, 0);
+    }
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::resume() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    readingPaused = false;
+    sendingPaused = false;
+    for (auto& pair : connections) {
+        if (!pair.second.recvArmed && !pair.second.readPaused && !pair.second.closing) {
+            armRecv(pair.first, pair.second);
+        }
+        if (!pair.second.sending && !pair.second.closing && !pair.second.sendQueue.empty()) {
+            startSend(pair.first, pair.second);
+        }
+    }
+    if (acceptStopped) {
+        acceptStopped = false;
+        armAccept();
+    }
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+size_t IoUringBackend::getArmedRecvCount() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    size_t armed = 0;
+    for (const auto& pair : connections) {
+        if (pair.second.recvArmed) {
+            ++armed;
+        }
+    }
+    return armed;
+}
+
+size_t IoUringBackend::getSendsInFlight() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    size_t sending = 0;
+    for (const auto& pair : connections) {
+        if (pair.second.sending) {
+            ++sending;
+        }
+    }
+    return sending;
+}
+
+std::string IoUringBackend::getUnsent(int fd) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    std::string unsent;
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return unsent;
+    }
+    for (const auto& pending : it->second.sendQueue) {
+        unsent.append(*pending.data, pending.offset, std::string::npos);
+    }
+    return unsent;
+}
+
+std::vector<int> IoUringBackend::getConnectionFds() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    std::vector<int> fds;
+    fds.reserve(connections.size());
+    for (const auto& pair : connections) {
+        if (!pair.second.closing) {
+            fds.push_back(pair.first);
+        }
+    }
+    return fds;
+}
+
+void IoUringBackend::adoptConnection(int fd) {
+    registerConnection(fd);
+    if (!inLoopThread()) {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::registerConnection(int fd) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    Connection& conn = connections[fd];
+    conn.generation = nextGeneration++ & 0xFFFFFF;
+    conn.sendQueue.clear();
+    conn.sending = false;
+    conn.recvArmed = false;
+    conn.readPaused = false;
+    conn.closing = false;
+    if (!readingPaused) {
+        armRecv(fd, conn);
+    }
+}
+
+void IoUringBackend::closeAllConnections() {
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        for (const auto& pair : connections) {
+            fds.push_back(pair.first);
+        }
+    }
+    for (int fd : fds) {
+        closeConnection(fd, 0);
+    }
+}
+
+void IoUringBackend::armRecv(int fd, Connection& conn) {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        LOG_ERR("io_uring SQ full, cannot arm recv");
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = encodeUserData(OP_RECV, fd, conn.generation);
+    conn.recvArmed = true;
+}
+
+void IoUringBackend::startSend(int fd, Connection& conn) {
+    const PendingSend& pending = conn.sendQueue.front();
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        // The queue stays as it is; the loop retries once completions free the ring
+        LOG_WARN("io_uring SQ full, deferring send on fd " + std::to_string(fd));
+        stalledSends.push_back(fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(pending.data->data() + pending.offset);
+    sqe->len = (uint32_t)(pending.data->size() - pending.offset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = encodeUserData(OP_SEND, fd, conn.generation);
+    conn.sending = true;
+}
+
+void IoUringBackend::retryStalledSends() {
+    // Caller holds sqMutex
+    std::vector<int> stalled;
+    stalled.swap(stalledSends);
+    for (int fd : stalled) {
+        auto it = connections.find(fd);
+        if (it != connections.end() && !it->second.sending && !it->second.closing &&
+            !it->second.sendQueue.empty() && !sendingPaused) {
+            startSend(fd, it->second);
+        }
+    }
+}
+
+void IoUringBackend::queueSend(int fd, const std::shared_ptr<const std::string>& data) {
+    // Caller holds sqMutex
+    auto it = connections.find(fd);
+    if (it == connections.end() || it->second.closing || data->empty()) {
+        return;
+    }
+    Connection& conn = it->second;
+    conn.sendQueue.push_back(PendingSend{data, 0});
+    sendQueueDepth().add(1);
+    if (!conn.sending && !sendingPaused) {
+        startSend(fd, conn);
+    }
+}
+
+void IoUringBackend::send(int fd, const char* data, size_t len) {
+    auto message = std::make_shared<const std::string>(data, len);
+    std::lock_guard<std::mutex> lock(sqMutex);
+    queueSend(fd, message);
+    // The loop thread submits its whole batch once per iteration
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::broadcast(const std::shared_ptr<const std::string>& message) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    for (auto& pair : connections) {
+        queueSend(pair.first, message);
+    }
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+void IoUringBackend::multicast(const std::vector<int>& fds, const std::shared_ptr<const std::string>& message) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    for (int fd : fds) {
+        queueSend(fd, message);
+    }
+    if (!inLoopThread()) {
+        submitPending(0);
+    }
+}
+
+size_t IoUringBackend::getConnectionCount() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    return connections.size();
+}
+
+size_t IoUringBackend::getPendingSendCount() {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    size_t pending = 0;
+    for (const auto& pair : connections) {
+        pending += pair.second.sendQueue.size();
+    }
+    return pending;
+}
+
+size_t IoUringBackend::getQueuedBytes(int fd) {
+    std::lock_guard<std::mutex> lock(sqMutex);
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (const auto& pending : it->second.sendQueue) {
+        bytes += pending.data->size() - pending.offset;
+    }
+    return bytes;
+}
+
+void IoUringBackend::recycleBuffer(uint16_t bid) {
+    // Only the loop thread touches the buffer ring
+    io_uring_buf& buf = ringBuffers(bufRing)[bufTail & (bufCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(bufPool + (size_t)bid * bufSize);
+    buf.len = bufSize;
+    buf.bid = bid;
+    ++bufTail;
+    storeRelease(&bufRing->tail, bufTail);
+}
+
+void IoUringBackend::run() {
+    loopThread = std::this_thread::get_id();
+    running = true;
+    {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        if (!acceptStopped) {
+            armAccept();
+        }
+        if (wakeFd >= 0) {
+            armWakeRead();
+        }
+        if (onTimer && !timerArmed) {
+            armTimer();
+        }
+    }
+
+    while (running) {
+        unsigned toSubmit;
+        {
+            std::lock_guard<std::mutex> lock(sqMutex);
+            retryStalledSends();
+            storeRelease(sqTail, sqLocalTail);
+            toSubmit = sqLocalTail - loadAcquire(sqHead);
+        }
+
+        // One syscall both submits the batch and waits for completions
+        if (sys_io_uring_enter(ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS) < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                LOG_ERR("io_uring_enter failed: " + std::string(strerror(errno)));
+                break;
+            }
+        }
+
+        TRACE_SCOPE("IoUringBackend::completions");
+        unsigned head = *cqHead;
+        unsigned tail = loadAcquire(cqTail);
+        while (head != tail) {
+            io_uring_cqe cqe = cqes[head & *cqMask];
+            ++head;
+            storeRelease(cqHead, head);
+            handleCompletion(cqe);
+            tail = loadAcquire(cqTail);
+        }
+    }
+    running = false;
+}
+
+void IoUringBackend::stop() {
+    running = false;
+    std::lock_guard<std::mutex> lock(sqMutex);
+    io_uring_sqe* sqe = getSqe();
+    if (sqe) {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = encodeUserData(OP_WAKE, -1, 0);
+    }
+    submitPending(0);
+}
+
+void IoUringBackend::handleCompletion(const io_uring_cqe& cqe) {
+    OpType type = (OpType)(cqe.user_data & 0xFF);
+    int fd = (int)(uint32_t)((cqe.user_data >> 8) & 0xFFFFFFFF);
+    uint32_t generation = (uint32_t)(cqe.user_data >> 40);
+
+    switch (type) {
+        case OP_ACCEPT:
+            handleAccept(cqe.res, cqe.flags);
+            break;
+        case OP_RECV:
+            handleRecv(fd, generation, cqe.res, cqe.flags);
+            break;
+        case OP_SEND:
+            handleSend(fd, generation, cqe.res);
+            break;
+        case OP_EVENTFD:
+            if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN) {
+                LOG_ERR("Wake fd read failed: " + std::string(strerror(-cqe.res)));
+                break;
+            }
+            if (running) {
+                std::lock_guard<std::mutex> lock(sqMutex);
+                armWakeRead();
+            }
+            if (cqe.res > 0 && onWake) {
+                onWake();
+            }
+            break;
+        case OP_TIMER: {
+            EventHandler handler;
+            {
+                std::lock_guard<std::mutex> lock(sqMutex);
+                timerArmed = false;
+                handler = onTimer;
+                if (onTimer && running) {
+                    armTimer();
+                }
+            }
+            if (handler) {
+                handler();
+            }
+            break;
+        }
+        case OP_WAKE:
+        case OP_CANCEL:
+        default:
+            break;
+    }
+}
+
+void IoUringBackend::handleAccept(int res, uint32_t flags) {
+    if (res >= 0) {
+        if (onAccept && !onAccept(res)) {
+            close(res);
+        } else {
+            registerConnection(res);
+        }
+    } else if (res != -ECANCELED) {
+        LOG_ERR("Accept failed: " + std::string(strerror(-res)));
+    }
+
+    if (!(flags & IORING_CQE_F_MORE) && running) {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        if (!acceptStopped) {
+            armAccept();
+        }
+    }
+}
+
+void IoUringBackend::handleRecv(int fd, uint32_t generation, int res, uint32_t flags) {
+    bool more = (flags & IORING_CQE_F_MORE) != 0;
+
+    if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+        uint16_t bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (onData) {
+            onData(fd, bufPool + (size_t)bid * bufSize, (size_t)res);
+        }
+        recycleBuffer(bid);
+    }
+
+    if (more) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        auto it = connections.find(fd);
+        if (it == connections.end() || it->second.generation != generation) {
+            return;
+        }
+        Connection& conn = it->second;
+        conn.recvArmed = false;
+        // Cancelled by pause() or pauseReading(): the connection stays open,
+        // unread data stays in the socket
+        if (!conn.closing && (readingPaused || conn.readPaused) && (res > 0 || res == -ECANCELED || res == -ENOBUFS)) {
+            return;
+        }
+        // Multishot recv ends on buffer exhaustion or when the CQ overflows;
+        // re-arm in both cases unless the peer is gone.
+        if (!conn.closing && (res > 0 || res == -ENOBUFS)) {
+            armRecv(fd, conn);
+            return;
+        }
+    }
+    closeConnection(fd, res < 0 ? -res : 0);
+}
+
+void IoUringBackend::handleSend(int fd, uint32_t generation, int res) {
+    bool failed = false;
+    {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        auto it = connections.find(fd);
+        if (it == connections.end() || it->second.generation != generation) {
+            return;
+        }
+        Connection& conn = it->second;
+        conn.sending = false;
+
+        // Cancelled by pauseSends(): nothing of it was sent, the queue stays
+        if (res == -ECANCELED && sendingPaused && !conn.closing) {
+            return;
+        }
+        if (res < 0) {
+            sendQueueDepth().sub((int64_t)conn.sendQueue.size());
+            conn.sendQueue.clear();
+            failed = true;
+        } else if (!conn.sendQueue.empty()) {
+            PendingSend& pending = conn.sendQueue.front();
+            pending.offset += (size_t)res;
+            if (pending.offset >= pending.data->size()) {
+                conn.sendQueue.pop_front();
+                sendQueueDepth().sub(1);
+            }
+        }
+
+        if (!failed && !conn.closing && !conn.sendQueue.empty() && !sendingPaused) {
+            startSend(fd, conn);
+        }
+    }
+    if (failed) {
+        closeConnection(fd, -res);
+    } else {
+        // Finishes a close that was waiting for the in-flight send
+        std::lock_guard<std::mutex> lock(sqMutex);
+        auto it = connections.find(fd);
+        if (it != connections.end() && it->second.closing &&
+            !it->second.sending && !it->second.recvArmed) {
+            connections.erase(it);
+            close(fd);
+        }
+    }
+}
+
+void IoUringBackend::closeConnection(int fd, int error) {
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        auto it = connections.find(fd);
+        if (it == connections.end()) {
+            return;
+        }
+        Connection& conn = it->second;
+        if (!conn.closing) {
+            conn.closing = true;
+            sendQueueDepth().sub((int64_t)conn.sendQueue.size());
+            conn.sendQueue.clear();
+            notify = true;
+        }
+        if (conn.recvArmed) {
+            // Ends the multishot recv; its final completion releases the fd
+            shutdown(fd, SHUT_RDWR);
+        } else if (!conn.sending) {
+            connections.erase(it);
+            close(fd);
+        }
+    }
+    if (notify && onClose) {
+        onClose(fd, error);
+    }
+}
@@ -0,0 +1,311 @@
+#include "core/RateLimiter.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Tokens are kept in thousandths, so a rate of N per second adds exactly N per millisecond
+const uint64_t TOKEN_SCALE = 1000;
+// Slots checked from the hashed position before giving up
+const size_t PROBE_WINDOW = 16;
+// Longer gaps refill a bucket anyway; keeps the refill product in 64 bits
+const uint32_t MAX_REFILL_MS = 3600 * 1000;
+
+struct RateLimitMetrics {
+    Counter& connectionsRejected;
+    Counter& readsThrottled;
+    Counter& disconnects;
+    Counter& untracked;
+    Counter& evictions;
+
+    RateLimitMetrics()
+        : connectionsRejected(MetricsRegistry::getInstance().counter(
+              "gameserver_ratelimit_connections_rejected_total", "Connections closed at accept by a per-IP limit"))
+        , readsThrottled(MetricsRegistry::getInstance().counter(
+              "gameserver_ratelimit_reads_throttled_total", "Client reads refused by a rate limit and held for a retry"))
+        , disconnects(MetricsRegistry::getInstance().counter(
+              "gameserver_ratelimit_disconnects_total", "Connections closed for exceeding rate limits repeatedly"))
+        , untracked(MetricsRegistry::getInstance().counter(
+              "gameserver_ratelimit_untracked_total", "Addresses or connections admitted without a limiter slot"))
+        , evictions(MetricsRegistry::getInstance().counter(
+              "gameserver_ratelimit_evictions_total", "Idle address slots reused for another address")) {}
+};
+
+RateLimitMetrics& rateLimitMetrics() {
+    static RateLimitMetrics metrics;
+    return metrics;
+}
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+void clampBurst(RateLimit& limit, const char* name) {
+    if (limit.burst > RateLimiter::MAX_BURST) {
+        LOG_WARN(std::string("Rate limit ") + name + ": burst capped at " + std::to_string(RateLimiter::MAX_BURST));
+        limit.burst = RateLimiter::MAX_BURST;
+    }
+}
+
+uint32_t refillTimeMs(const RateLimit& limit) {
+    if (limit.perSecond == 0) {
+        return 0;
+    }
+    return (uint32_t)std::min<uint64_t>(MAX_REFILL_MS, (uint64_t)limit.burst * 1000 / limit.perSecond + 1);
+}
+
+} // namespace
+
+RateLimiter::RateLimiter(const RateLimitConfig& settings)
+    : config(settings)
+    , evictAfterMs(0)
+    , trackedAddresses(0)
+    , trackedConnections(0) {
+    clampBurst(config.acceptsPerIp, "accepts per IP");
+    clampBurst(config.messagesPerIp, "messages per IP");
+    clampBurst(config.bytesPerIp, "bytes per IP");
+    clampBurst(config.messagesPerConnection, "messages per connection");
+    clampBurst(config.bytesPerConnection, "bytes per connection");
+    for (const RateLimit* limit : {&config.acceptsPerIp, &config.messagesPerIp, &config.bytesPerIp}) {
+        evictAfterMs = std::max(evictAfterMs, refillTimeMs(*limit));
+    }
+
+    size_t addressCount = roundUpToPowerOfTwo(std::max<size_t>(config.addressSlots, PROBE_WINDOW));
+    size_t connectionCount = roundUpToPowerOfTwo(std::max<size_t>(config.connectionSlots, PROBE_WINDOW));
+    addresses.reset(new Slot[addressCount]);
+    connections.reset(new Slot[connectionCount]);
+    addressMask = addressCount - 1;
+    connectionMask = connectionCount - 1;
+    for (size_t i = 0; i < addressCount; ++i) {
+        clearSlot(addresses[i]);
+    }
+    for (size_t i = 0; i < connectionCount; ++i) {
+        clearSlot(connections[i]);
+    }
+}
+
+void RateLimiter::clearSlot(Slot& slot) {
+    slot.key.store(0, std::memory_order_relaxed);
+    slot.lastSeenMs.store(0, std::memory_order_relaxed);
+    slot.connections.store(0, std::memory_order_relaxed);
+    slot.strikes.store(0, std::memory_order_relaxed);
+    slot.parent.store(0, std::memory_order_relaxed);
+    slot.accepts.store(0, std::memory_order_relaxed);
+    slot.messages.store(0, std::memory_order_relaxed);
+    slot.bytes.store(0, std::memory_order_relaxed);
+}
+
+uint32_t RateLimiter::clockMs() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t RateLimiter::hash(uint64_t key) {
+    // splitmix64 finalizer: neighbouring addresses and fds spread over the table
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+void RateLimiter::fill(std::atomic<uint64_t>& bucket, const RateLimit& limit, uint32_t nowMs) {
+    bucket.store(((uint64_t)nowMs << 32) | ((uint64_t)limit.burst * TOKEN_SCALE), std::memory_order_relaxed);
+}
+
+bool RateLimiter::take(std::atomic<uint64_t>& bucket, const RateLimit& limit, uint32_t nowMs, uint64_t cost) {
+    if (limit.perSecond == 0) {
+        return true;
+    }
+    const uint64_t capacity = (uint64_t)limit.burst * TOKEN_SCALE;
+    cost *= TOKEN_SCALE;
+    uint64_t state = bucket.load(std::memory_order_relaxed);
+    while (true) {
+        uint32_t elapsed = std::min(nowMs - (uint32_t)(state >> 32), MAX_REFILL_MS);
+        uint64_t tokens = std::min<uint64_t>(capacity, (state & 0xffffffffULL) + (uint64_t)limit.perSecond * elapsed);
+        bool allowed = tokens >= cost;
+        if (allowed) {
+            tokens -= cost;
+        }
+        uint64_t next = ((uint64_t)nowMs << 32) | tokens;
+        if (bucket.compare_exchange_weak(state, next, std::memory_order_relaxed)) {
+            return allowed;
+        }
+    }
+}
+
+bool RateLimiter::isExempt(uint32_t ipv4) const {
+    return !config.limitLoopback && (ipv4 >> 24) == 127;
+}
+
+long RateLimiter::findAddress(uint32_t ipv4, uint32_t nowMs) {
+    const uint64_t key = (uint64_t)ipv4 + 1;
+    const size_t start = (size_t)hash(key);
+    for (size_t i = 0; i < PROBE_WINDOW; ++i) {
+        size_t index = (start + i) & addressMask;
+        if (addresses[index].key.load(std::memory_order_acquire) == key) {
+            return (long)index;
+        }
+    }
+
+    // Not tracked yet: take a free slot, or the longest idle one that has refilled
+    long victim = -1;
+    uint32_t victimIdle = 0;
+    for (size_t i = 0; i < PROBE_WINDOW; ++i) {
+        size_t index = (start + i) & addressMask;
+        Slot& slot = addresses[index];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                victim = (long)index;
+                ++trackedAddresses;
+                break;
+            }
+            if (current == key) {
+                return (long)index;
+            }
+        }
+        uint32_t idle = nowMs - slot.lastSeenMs.load(std::memory_order_relaxed);
+        if (slot.connections.load(std::memory_order_relaxed) == 0 && idle >= evictAfterMs && idle >= victimIdle) {
+            victim = (long)index;
+            victimIdle = idle;
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+    Slot& slot = addresses[victim];
+    uint64_t current = slot.key.load(std::memory_order_acquire);
+    if (current != key) {
+        if (!slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+            return -1;
+        }
+        rateLimitMetrics().evictions.inc();
+    }
+    slot.lastSeenMs.store(nowMs, std::memory_order_relaxed);
+    slot.connections.store(0, std::memory_order_relaxed);
+    fill(slot.accepts, config.acceptsPerIp, nowMs);
+    fill(slot.messages, config.messagesPerIp, nowMs);
+    fill(slot.bytes, config.bytesPerIp, nowMs);
+    return victim;
+}
+
+RateLimiter::Slot* RateLimiter::findConnection(int fd) {
+    const uint64_t key = (uint64_t)fd + 1;
+    const size_t start = (size_t)hash(key);
+    for (size_t i = 0; i < PROBE_WINDOW; ++i) {
+        Slot& slot = connections[(start + i) & connectionMask];
+        if (slot.key.load(std::memory_order_acquire) == key) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void RateLimiter::registerConnection(int fd, long address, uint32_t nowMs) {
+    // A socket number can come back before its close was seen
+    connectionClosed(fd);
+
+    const uint64_t key = (uint64_t)fd + 1;
+    const size_t start = (size_t)hash(key);
+    Slot* claimed = nullptr;
+    for (size_t i = 0; i < PROBE_WINDOW && !claimed; ++i) {
+        Slot& slot = connections[(start + i) & connectionMask];
+        uint64_t expected = 0;
+        if (slot.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+            claimed = &slot;
+        }
+    }
+    if (!claimed) {
+        // Per-IP limits cannot be charged without a slot, so give the address its count back
+        if (address >= 0) {
+            addresses[address].connections.fetch_sub(1, std::memory_order_relaxed);
+        }
+        rateLimitMetrics().untracked.inc();
+        return;
+    }
+    ++trackedConnections;
+    claimed->lastSeenMs.store(nowMs, std::memory_order_relaxed);
+    claimed->strikes.store(0, std::memory_order_relaxed);
+    claimed->parent.store(address >= 0 ? (uint32_t)address + 1 : 0, std::memory_order_relaxed);
+    fill(claimed->messages, config.messagesPerConnection, nowMs);
+    fill(claimed->bytes, config.bytesPerConnection, nowMs);
+}
+
+bool RateLimiter::admitConnection(int fd, uint32_t ipv4, uint32_t nowMs) {
+    if (isExempt(ipv4)) {
+        return true;
+    }
+    long address = findAddress(ipv4, nowMs);
+    if (address >= 0) {
+        Slot& slot = addresses[address];
+        slot.lastSeenMs.store(nowMs, std::memory_order_relaxed);
+        if (slot.connections.load(std::memory_order_relaxed) >= config.maxConnectionsPerIp ||
+            !take(slot.accepts, config.acceptsPerIp, nowMs, 1)) {
+            rateLimitMetrics().connectionsRejected.inc();
+            return false;
+        }
+        slot.connections.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        rateLimitMetrics().untracked.inc();
+    }
+    registerConnection(fd, address, nowMs);
+    return true;
+}
+
+void RateLimiter::trackConnection(int fd, uint32_t ipv4, uint32_t nowMs) {
+    if (isExempt(ipv4)) {
+        return;
+    }
+    long address = findAddress(ipv4, nowMs);
+    if (address >= 0) {
+        addresses[address].lastSeenMs.store(nowMs, std::memory_order_relaxed);
+        addresses[address].connections.fetch_add(1, std::memory_order_relaxed);
+    }
+    registerConnection(fd, address, nowMs);
+}
+
+RateLimiter::Verdict RateLimiter::admitRead(int fd, size_t bytes, uint32_t nowMs) {
+    Slot* slot = findConnection(fd);
+    if (!slot) {
+        return Verdict::Allow;
+    }
+    bool allowed = take(slot->messages, config.messagesPerConnection, nowMs, 1) &&
+                   take(slot->bytes, config.bytesPerConnection, nowMs, bytes);
+    uint32_t parent = slot->parent.load(std::memory_order_relaxed);
+    if (allowed && parent != 0) {
+        Slot& address = addresses[parent - 1];
+        address.lastSeenMs.store(nowMs, std::memory_order_relaxed);
+        allowed = take(address.messages, config.messagesPerIp, nowMs, 1) &&
+                  take(address.bytes, config.bytesPerIp, nowMs, bytes);
+    }
+    if (allowed) {
+        slot->strikes.store(0, std::memory_order_relaxed);
+        return Verdict::Allow;
+    }
+    if (slot->strikes.fetch_add(1, std::memory_order_relaxed) + 1 >= config.maxStrikes) {
+        rateLimitMetrics().disconnects.inc();
+        return Verdict::Disconnect;
+    }
+    rateLimitMetrics().readsThrottled.inc();
+    return Verdict::Throttle;
+}
+
+void RateLimiter::connectionClosed(int fd) {
+    Slot* slot = findConnection(fd);
+    if (!slot) {
+        return;
+    }
+    uint32_t parent = slot->parent.load(std::memory_order_relaxed);
+    if (parent != 0) {
+        addresses[parent - 1].connections.fetch_sub(1, std::memory_order_relaxed);
+    }
+    slot->key.store(0, std::memory_order_release);
+    --trackedConnections;
+}
@@ -0,0 +1,285 @@
+#include "core/TlsContext.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+
+#ifdef GAMESERVER_HAS_TLS
+    #include <openssl/err.h>
+    #include <openssl/evp.h>
+    #include <openssl/ssl.h>
+    #include <openssl/x509.h>
+    #include <errno.h>
+#endif
+
+#ifdef GAMESERVER_HAS_TLS
+
+namespace {
+
+// Validity of the ephemeral certificate used when no files are configured
+const long SELF_SIGNED_DAYS = 30;
+
+struct TlsMetrics {
+    Counter& handshakes;
+    Counter& resumed;
+    Counter& failures;
+    Counter& kernelOffloaded;
+    Histogram& handshakeDuration;
+
+    TlsMetrics()
+        : handshakes(MetricsRegistry::getInstance().counter(
+              "gameserver_tls_handshakes_total", "TLS handshakes completed"))
+        , resumed(MetricsRegistry::getInstance().counter(
+              "gameserver_tls_resumed_total", "TLS handshakes that resumed a session from a ticket"))
+        , failures(MetricsRegistry::getInstance().counter(
+              "gameserver_tls_handshake_failures_total", "TLS handshakes that failed"))
+        , kernelOffloaded(MetricsRegistry::getInstance().counter(
+              "gameserver_tls_ktls_total", "TLS connections with kernel record encryption on the send side"))
+        , handshakeDuration(MetricsRegistry::getInstance().histogram(
+              "gameserver_tls_handshake_duration_us", "Accept to finished TLS handshake in microseconds")) {}
+};
+
+TlsMetrics& tlsMetrics() {
+    static TlsMetrics metrics;
+    return metrics;
+}
+
+// Oldest error on this thread's OpenSSL queue; clears the queue
+std::string lastError() {
+    unsigned long code = ERR_get_error();
+    ERR_clear_error();
+    if (code == 0) {
+        return "unknown error";
+    }
+    char text[256];
+    ERR_error_string_n(code, text, sizeof(text));
+    return text;
+}
+
+bool useSelfSigned(SSL_CTX* ctx) {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* cert = X509_new();
+    bool ok = key && cert;
+    if (ok) {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), SELF_SIGNED_DAYS * 24 * 3600);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"gameserver", -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        ok = X509_set_pubkey(cert, key) == 1 && X509_sign(cert, key, EVP_sha256()) > 0 &&
+             SSL_CTX_use_certificate(ctx, cert) == 1 && SSL_CTX_use_PrivateKey(ctx, key) == 1;
+    }
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+} // namespace
+
+TlsContext::TlsContext() : ctx(nullptr) {}
+
+TlsContext::~TlsContext() {
+    SSL_CTX_free(ctx);
+}
+
+bool TlsContext::isAvailable() {
+    return true;
+}
+
+bool TlsContext::initialize(const TlsConfig& config) {
+    ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        LOG_ERR("TLS: cannot create context: " + lastError());
+        return false;
+    }
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    // Partial writes fit the per-client output queues; idle connections give
+    // their record buffers back
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER |
+                          SSL_MODE_RELEASE_BUFFERS);
+    // Stateless tickets only: nothing per session is kept on the server
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_timeout(ctx, (long)config.ticketLifetime.count());
+    // One ticket per handshake covers a reconnect; OpenSSL sends two by default
+    SSL_CTX_set_num_tickets(ctx, 1);
+    // A peer that just closes the socket is a disconnect, not a protocol error
+    SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF | SSL_OP_NO_RENEGOTIATION);
+    if (config.kernelOffload) {
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+
+    if (config.certFile.empty() && config.keyFile.empty()) {
+        LOG_WARN("TLS: no certificate configured, using an ephemeral self-signed one");
+        if (!useSelfSigned(ctx)) {
+            LOG_ERR("TLS: cannot create a self-signed certificate: " + lastError());
+            return false;
+        }
+    } else if (SSL_CTX_use_certificate_chain_file(ctx, config.certFile.c_str()) != 1 ||
+               SSL_CTX_use_PrivateKey_file(ctx, config.keyFile.c_str(), SSL_FILETYPE_PEM) != 1) {
+        LOG_ERR("TLS: cannot load " + config.certFile + " / " + config.keyFile + ": " + lastError());
+        return false;
+    }
+    if (SSL_CTX_check_private_key(ctx) != 1) {
+        LOG_ERR("TLS: private key does not match the certificate");
+        return false;
+    }
+    // Registered up front so they show up before the first client
+    tlsMetrics();
+    return true;
+}
+
+std::unique_ptr<TlsConnection> TlsContext::accept(int fd) {
+    SSL* ssl = SSL_new(ctx);
+    if (!ssl || SSL_set_fd(ssl, fd) != 1) {
+        LOG_ERR("TLS: cannot set up connection: " + lastError());
+        SSL_free(ssl);
+        return nullptr;
+    }
+    SSL_set_accept_state(ssl);
+    return std::unique_ptr<TlsConnection>(new TlsConnection(ssl));
+}
+
+TlsConnection::TlsConnection(SSL* session)
+    : ssl(session)
+    , established(false)
+    , wantsWrite(false)
+    , startTime(std::chrono::steady_clock::now()) {}
+
+TlsConnection::~TlsConnection() {
+    SSL_free(ssl);
+}
+
+TlsConnection::Result TlsConnection::translate(int ret) {
+    switch (SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+            return Result::WantRead;
+        case SSL_ERROR_WANT_WRITE:
+            return Result::WantWrite;
+        case SSL_ERROR_ZERO_RETURN:
+            return Result::Closed;
+        case SSL_ERROR_SYSCALL:
+            // EOF without close_notify, or a reset: the peer is gone either way
+            ERR_clear_error();
+            return errno == 0 || errno == ECONNRESET || errno == EPIPE ? Result::Closed : Result::Failed;
+        default:
+            return Result::Failed;
+    }
+}
+
+TlsConnection::Result TlsConnection::handshake() {
+    if (established) {
+        return Result::Done;
+    }
+    ERR_clear_error();
+    errno = 0;
+    int ret = SSL_do_handshake(ssl);
+    if (ret != 1) {
+        Result result = translate(ret);
+        wantsWrite = result == Result::WantWrite;
+        if (result == Result::Failed) {
+            tlsMetrics().failures.inc();
+            // Scanners and plaintext clients end up here; not worth a warning each
+            LOG_DEBUG("TLS handshake failed: " + lastError());
+        } else if (result == Result::Closed) {
+            tlsMetrics().failures.inc();
+        }
+        return result;
+    }
+    established = true;
+    wantsWrite = false;
+
+    TlsMetrics& metrics = tlsMetrics();
+    metrics.handshakes.inc();
+    if (wasResumed()) {
+        metrics.resumed.inc();
+    }
+    if (isKernelOffloaded()) {
+        metrics.kernelOffloaded.inc();
+    }
+    metrics.handshakeDuration.record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count());
+    return Result::Done;
+}
+
+bool TlsConnection::wasResumed() const {
+    return SSL_session_reused(ssl) == 1;
+}
+
+bool TlsConnection::isKernelOffloaded() const {
+    return BIO_get_ktls_send(SSL_get_wbio(ssl));
+}
+
+size_t TlsConnection::read(char* buffer, size_t len, Result& result) {
+    ERR_clear_error();
+    errno = 0;
+    size_t transferred = 0;
+    int ret = SSL_read_ex(ssl, buffer, len, &transferred);
+    result = ret == 1 ? Result::Done : translate(ret);
+    return ret == 1 ? transferred : 0;
+}
+
+size_t TlsConnection::write(const char* data, size_t len, Result& result) {
+    ERR_clear_error();
+    errno = 0;
+    size_t transferred = 0;
+    int ret = SSL_write_ex(ssl, data, len, &transferred);
+    result = ret == 1 ? Result::Done : translate(ret);
+    return ret == 1 ? transferred : 0;
+}
+
+void TlsConnection::shutdown() {
+    if (established) {
+        ERR_clear_error();
+        SSL_shutdown(ssl);
+        ERR_clear_error();
+    }
+}
+
+#else // !GAMESERVER_HAS_TLS
+
+TlsContext::TlsContext() : ctx(nullptr) {}
+
+TlsContext::~TlsContext() {}
+
+bool TlsContext::isAvailable() {
+    return false;
+}
+
+bool TlsContext::initialize(const TlsConfig&) {
+    LOG_ERR("Built without TLS support (OpenSSL not found)");
+    return false;
+}
+
+std::unique_ptr<TlsConnection> TlsContext::accept(int) {
+    return nullptr;
+}
+
+TlsConnection::TlsConnection(ssl_st* session) : ssl(session), established(false), wantsWrite(false) {}
+
+TlsConnection::~TlsConnection() {}
+
+TlsConnection::Result TlsConnection::handshake() {
+    return Result::Failed;
+}
+
+bool TlsConnection::wasResumed() const {
+    return false;
+}
+
+bool TlsConnection::isKernelOffloaded() const {
+    return false;
+}
+
+size_t TlsConnection::read(char*, size_t, Result& result) {
+    result = Result::Failed;
+    return 0;
+}
+
+size_t TlsConnection::write(const char*, size_t, Result& result) {
+    result = Result::Failed;
+    return 0;
+}
+
+void TlsConnection::shutdown() {}
+
+#endif // GAMESERVER_HAS_TLS
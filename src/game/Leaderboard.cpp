@@ -0,0 +1,382 @@
+#include "game/Leaderboard.h"
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = {'G', 'S', 'L', 'B'};
+const uint64_t SNAPSHOT_VERSION = 1;
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+bool getVarint(const std::string& in, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && offset < in.size(); shift += 7) {
+        uint8_t byte = (uint8_t)in[offset++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+} // namespace
+
+Leaderboard::Leaderboard()
+    : head(createNode(MAX_LEVEL, 0, 0))
+    , level(1)
+    , length(0)
+    , version(0)
+    , rng((uint64_t)std::chrono::steady_clock::now().time_since_epoch().count() | 1) {}
+
+Leaderboard::~Leaderboard() {
+    clearLocked();
+    destroyNode(head);
+}
+
+Leaderboard::Node* Leaderboard::createNode(int level, int64_t score, int playerId) {
+    void* memory = ::operator new(sizeof(Node) + (level - 1) * sizeof(Link));
+    Node* node = new (memory) Node;
+    node->score = score;
+    node->playerId = playerId;
+    node->level = level;
+    for (int i = 0; i < level; ++i) {
+        node->links[i].next = nullptr;
+        node->links[i].span = 0;
+    }
+    return node;
+}
+
+void Leaderboard::destroyNode(Node* node) {
+    ::operator delete(node);
+}
+
+bool Leaderboard::precedes(const Node* node, int64_t score, int playerId) {
+    return node->score > score || (node->score == score && node->playerId < playerId);
+}
+
+int Leaderboard::randomLevel() {
+    // xorshift64; each extra level with probability 1/4
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    uint64_t bits = rng;
+    int result = 1;
+    while ((bits & 3) == 0 && result < MAX_LEVEL) {
+        ++result;
+        bits >>= 2;
+    }
+    return result;
+}
+
+size_t Leaderboard::insertLocked(int64_t score, int playerId) {
+    Node* update[MAX_LEVEL];
+    size_t rank[MAX_LEVEL];
+
+    Node* x = head;
+    for (int i = level - 1; i >= 0; --i) {
+        rank[i] = (i == level - 1) ? 0 : rank[i + 1];
+        while (x->links[i].next && precedes(x->links[i].next, score, playerId)) {
+            rank[i] += x->links[i].span;
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+
+    int nodeLevel = randomLevel();
+    if (nodeLevel > level) {
+        for (int i = level; i < nodeLevel; ++i) {
+            rank[i] = 0;
+            update[i] = head;
+            head->links[i].span = length;
+        }
+        level = nodeLevel;
+    }
+
+    Node* node = createNode(nodeLevel, score, playerId);
+    for (int i = 0; i < nodeLevel; ++i) {
+        node->links[i].next = update[i]->links[i].next;
+        update[i]->links[i].next = node;
+        node->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+        update[i]->links[i].span = (rank[0] - rank[i]) + 1;
+    }
+    // Links passing over the new node now skip one more entry
+    for (int i = nodeLevel; i < level; ++i) {
+        update[i]->links[i].span++;
+    }
+    ++length;
+    return rank[0] + 1;
+}
+
+void Leaderboard::eraseLocked(int64_t score, int playerId) {
+    Node* update[MAX_LEVEL];
+    Node* x = head;
+    for (int i = level - 1; i >= 0; --i) {
+        while (x->links[i].next && precedes(x->links[i].next, score, playerId)) {
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+
+    x = x->links[0].next;
+    if (!x || x->score != score || x->playerId != playerId) {
+        return;
+    }
+    for (int i = 0; i < level; ++i) {
+        if (update[i]->links[i].next == x) {
+            update[i]->links[i].span += x->links[i].span - 1;
+            update[i]->links[i].next = x->links[i].next;
+        } else {
+            update[i]->links[i].span--;
+        }
+    }
+    while (level > 1 && !head->links[level - 1].next) {
+        head->links[level - 1].span = 0;
+        --level;
+    }
+    --length;
+    destroyNode(x);
+}
+
+size_t Leaderboard::rankLocked(int64_t score, int playerId) {
+    size_t rank = 0;
+    Node* x = head;
+    for (int i = level - 1; i >= 0; --i) {
+        while (x->links[i].next && (precedes(x->links[i].next, score, playerId) ||
+                                    (x->links[i].next->score == score &&
+                                     x->links[i].next->playerId == playerId))) {
+            rank += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (x != head && x->playerId == playerId) {
+            return rank;
+        }
+    }
+    return 0;
+}
+
+Leaderboard::Node* Leaderboard::nodeAtLocked(size_t rank) {
+    size_t traversed = 0;
+    Node* x = head;
+    for (int i = level - 1; i >= 0; --i) {
+        while (x->links[i].next && traversed + x->links[i].span <= rank) {
+            traversed += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (traversed == rank) {
+            return x == head ? nullptr : x;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<LeaderboardEntry> Leaderboard::rangeLocked(size_t first, size_t count) {
+    std::vector<LeaderboardEntry> entries;
+    if (first == 0) {
+        first = 1;
+    }
+    if (first > length || count == 0) {
+        return entries;
+    }
+    entries.reserve(std::min(count, length - first + 1));
+    size_t rank = first;
+    for (Node* x = nodeAtLocked(first); x && entries.size() < count; x = x->links[0].next) {
+        entries.push_back(LeaderboardEntry{x->playerId, x->score, rank++});
+    }
+    return entries;
+}
+
+void Leaderboard::clearLocked() {
+    Node* x = head->links[0].next;
+    while (x) {
+        Node* next = x->links[0].next;
+        destroyNode(x);
+        x = next;
+    }
+    for (int i = 0; i < MAX_LEVEL; ++i) {
+        head->links[i].next = nullptr;
+        head->links[i].span = 0;
+    }
+    level = 1;
+    length = 0;
+    scores.clear();
+}
+
+size_t Leaderboard::setScore(int playerId, int64_t score) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = scores.find(playerId);
+    if (it != scores.end()) {
+        if (it->second == score) {
+            return rankLocked(score, playerId);
+        }
+        eraseLocked(it->second, playerId);
+        it->second = score;
+    } else {
+        scores.emplace(playerId, score);
+    }
+    ++version;
+    return insertLocked(score, playerId);
+}
+
+int64_t Leaderboard::addScore(int playerId, int64_t delta) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = scores.find(playerId);
+    if (it == scores.end()) {
+        scores.emplace(playerId, delta);
+        insertLocked(delta, playerId);
+        ++version;
+        return delta;
+    }
+    if (delta != 0) {
+        eraseLocked(it->second, playerId);
+        it->second += delta;
+        insertLocked(it->second, playerId);
+        ++version;
+    }
+    return it->second;
+}
+
+bool Leaderboard::remove(int playerId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = scores.find(playerId);
+    if (it == scores.end()) {
+        return false;
+    }
+    eraseLocked(it->second, playerId);
+    scores.erase(it);
+    ++version;
+    return true;
+}
+
+void Leaderboard::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    clearLocked();
+    ++version;
+}
+
+bool Leaderboard::getScore(int playerId, int64_t& score) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = scores.find(playerId);
+    if (it == scores.end()) {
+        return false;
+    }
+    score = it->second;
+    return true;
+}
+
+size_t Leaderboard::getRank(int playerId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = scores.find(playerId);
+    if (it == scores.end()) {
+        return 0;
+    }
+    return rankLocked(it->second, playerId);
+}
+
+std::vector<LeaderboardEntry> Leaderboard::getTop(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rangeLocked(1, count);
+}
+
+std::vector<LeaderboardEntry> Leaderboard::getRange(size_t first, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rangeLocked(first, count);
+}
+
+std::vector<LeaderboardEntry> Leaderboard::getAround(int playerId, size_t radius) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = scores.find(playerId);
+    if (it == scores.end()) {
+        return std::vector<LeaderboardEntry>();
+    }
+    size_t rank = rankLocked(it->second, playerId);
+    size_t first = rank > radius ? rank - radius : 1;
+    return rangeLocked(first, rank - first + 1 + radius);
+}
+
+size_t Leaderboard::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return length;
+}
+
+uint64_t Leaderboard::getVersion() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return version;
+}
+
+std::string Leaderboard::serialize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string out(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out.reserve(16 + length * 6);
+    putVarint(out, SNAPSHOT_VERSION);
+    putVarint(out, length);
+    // The index is walked instead of the list: its nodes sit close together
+    // in memory, list order is scattered, and this runs under the lock
+    for (const auto& pair : scores) {
+        putVarint(out, zigzag(pair.first));
+        putVarint(out, zigzag(pair.second));
+    }
+    return out;
+}
+
+bool Leaderboard::load(const std::string& data) {
+    if (data.size() < sizeof(SNAPSHOT_MAGIC) ||
+        data.compare(0, sizeof(SNAPSHOT_MAGIC), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        return false;
+    }
+    size_t offset = sizeof(SNAPSHOT_MAGIC);
+    uint64_t snapshotVersion = 0;
+    uint64_t count = 0;
+    if (!getVarint(data, offset, snapshotVersion) || snapshotVersion != SNAPSHOT_VERSION ||
+        !getVarint(data, offset, count) || count > data.size()) {
+        return false;
+    }
+
+    // Decode everything first so a bad snapshot leaves the board untouched
+    std::vector<std::pair<int, int64_t>> entries;
+    entries.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t id;
+        uint64_t score;
+        if (!getVarint(data, offset, id) || !getVarint(data, offset, score)) {
+            return false;
+        }
+        entries.emplace_back((int)unzigzag(id), unzigzag(score));
+    }
+    if (offset != data.size()) {
+        return false;
+    }
+
+    // Inserting in rank order appends at the tail, the cheapest position
+    std::sort(entries.begin(), entries.end(), [](const std::pair<int, int64_t>& a,
+                                                 const std::pair<int, int64_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+
+    std::lock_guard<std::mutex> lock(mutex);
+    clearLocked();
+    scores.reserve(entries.size());
+    for (const auto& entry : entries) {
+        if (scores.emplace(entry.first, entry.second).second) {
+            insertLocked(entry.second, entry.first);
+        }
+    }
+    ++version;
+    return true;
+}
@@ -0,0 +1,235 @@
+#include "game/LeaderboardService.h"
+#include "persistence/StorageBackend.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include "utils/Trace.h"
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+const char SNAPSHOT_EXTENSION[] = ".lb";
+const size_t MAX_NAME_LENGTH = 32;
+
+struct LeaderboardMetrics {
+    Gauge& boards;
+    Gauge& entries;
+    Counter& snapshots;
+    Histogram& snapshotDuration;
+
+    LeaderboardMetrics()
+        : boards(MetricsRegistry::getInstance().gauge(
+              "gameserver_leaderboard_boards", "Leaderboards in memory"))
+        , entries(MetricsRegistry::getInstance().gauge(
+              "gameserver_leaderboard_entries", "Entries across all leaderboards at the last snapshot pass"))
+        , snapshots(MetricsRegistry::getInstance().counter(
+              "gameserver_leaderboard_snapshots_total", "Leaderboard snapshots written"))
+        , snapshotDuration(MetricsRegistry::getInstance().histogram(
+              "gameserver_leaderboard_snapshot_us", "Time to serialize and write one leaderboard in microseconds")) {}
+};
+
+LeaderboardMetrics& leaderboardMetrics() {
+    static LeaderboardMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+LeaderboardService::LeaderboardService()
+    : snapshotInterval(std::chrono::seconds(60))
+    , stopping(false)
+    , running(false) {}
+
+LeaderboardService::~LeaderboardService() {
+    stop();
+}
+
+bool LeaderboardService::isValidName(const std::string& name) {
+    if (name.empty() || name.size() > MAX_NAME_LENGTH) {
+        return false;
+    }
+    for (char c : name) {
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+Leaderboard* LeaderboardService::getBoard(const std::string& mode, const std::string& season) {
+    if (!isValidName(mode) || !isValidName(season)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Board& entry = boards[mode + "." + season];
+    if (!entry.board) {
+        entry.board.reset(new Leaderboard());
+        entry.savedVersion = 0;
+        leaderboardMetrics().boards.set((int64_t)boards.size());
+    }
+    return entry.board.get();
+}
+
+Leaderboard* LeaderboardService::findBoard(const std::string& mode, const std::string& season) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = boards.find(mode + "." + season);
+    return it == boards.end() ? nullptr : it->second.board.get();
+}
+
+std::vector<std::string> LeaderboardService::getBoardNames() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> names;
+    for (const auto& pair : boards) {
+        names.push_back(pair.first);
+    }
+    return names;
+}
+
+bool LeaderboardService::loadSnapshots() {
+    std::error_code error;
+    std::filesystem::create_directories(snapshotDirectory, error);
+    if (error) {
+        LOG_ERR("Leaderboards: cannot create " + snapshotDirectory);
+        return false;
+    }
+
+    size_t loaded = 0;
+    for (const auto& file : std::filesystem::directory_iterator(snapshotDirectory, error)) {
+        std::string fileName = file.path().filename().string();
+        if (file.path().extension() != SNAPSHOT_EXTENSION) {
+            continue;
+        }
+        std::string name = fileName.substr(0, fileName.size() - sizeof(SNAPSHOT_EXTENSION) + 1);
+        size_t dot = name.find('.');
+        if (dot == std::string::npos) {
+            continue;
+        }
+        Leaderboard* board = getBoard(name.substr(0, dot), name.substr(dot + 1));
+        std::string data;
+        if (!board || !readWholeFile(file.path().string(), data) || !board->load(data)) {
+            LOG_WARN("Leaderboards: ignoring unreadable snapshot " + file.path().string());
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        boards[name].savedVersion = board->getVersion();
+        ++loaded;
+    }
+    if (loaded > 0) {
+        LOG_INFO("Leaderboards: loaded " + std::to_string(loaded) + " boards from " + snapshotDirectory);
+    }
+    return true;
+}
+
+bool LeaderboardService::writeSnapshot(const std::string& name, Leaderboard& board) {
+    TRACE_SCOPE("LeaderboardService::writeSnapshot");
+    auto start = std::chrono::steady_clock::now();
+    std::string data = board.serialize();
+
+    // Write then rename, so a crash leaves either the old or the new snapshot
+    std::string path = snapshotDirectory + "/" + name + SNAPSHOT_EXTENSION;
+    std::string tempPath = path + ".tmp";
+    std::FILE* out = std::fopen(tempPath.c_str(), "wb");
+    if (!out) {
+        LOG_ERR("Leaderboards: cannot create " + tempPath);
+        return false;
+    }
+    bool written = std::fwrite(data.data(), 1, data.size(), out) == data.size() && syncFile(out);
+    std::fclose(out);
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(tempPath, path, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(tempPath, error);
+        LOG_ERR("Leaderboards: snapshot of " + name + " failed");
+        return false;
+    }
+    leaderboardMetrics().snapshots.inc();
+    leaderboardMetrics().snapshotDuration.record((uint64_t)std::chrono::duration_cast<
+        std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+size_t LeaderboardService::snapshotNow() {
+    if (snapshotDirectory.empty()) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+
+    std::vector<std::pair<std::string, Leaderboard*>> changed;
+    int64_t entries = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& pair : boards) {
+            entries += (int64_t)pair.second.board->size();
+            if (pair.second.board->getVersion() != pair.second.savedVersion) {
+                changed.emplace_back(pair.first, pair.second.board.get());
+            }
+        }
+    }
+    leaderboardMetrics().entries.set(entries);
+
+    size_t written = 0;
+    for (const auto& pair : changed) {
+        // Updates racing with the write bump the version again and are
+        // picked up by the next pass
+        uint64_t version = pair.second->getVersion();
+        if (!writeSnapshot(pair.first, *pair.second)) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        boards[pair.first].savedVersion = version;
+        ++written;
+    }
+    return written;
+}
+
+bool LeaderboardService::start() {
+    if (running) {
+        return true;
+    }
+    if (snapshotDirectory.empty()) {
+        return true;
+    }
+    if (!loadSnapshots()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(threadMutex);
+        stopping = false;
+    }
+    running = true;
+    snapshotThread = std::thread(&LeaderboardService::snapshotLoop, this);
+    return true;
+}
+
+void LeaderboardService::stop() {
+    if (!running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(threadMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (snapshotThread.joinable()) {
+        snapshotThread.join();
+    }
+    running = false;
+    snapshotNow();
+}
+
+void LeaderboardService::snapshotLoop() {
+    Tracer::getInstance().setThreadName("leaderboards");
+    std::unique_lock<std::mutex> lock(threadMutex);
+    while (!stopping) {
+        wake.wait_for(lock, snapshotInterval, [this]() { return stopping; });
+        if (stopping) {
+            break;
+        }
+        lock.unlock();
+        snapshotNow();
+        lock.lock();
+    }
+}
@@ -0,0 +1,61 @@
+#include "game/MatchResult.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+// Both records are tab separated text so the store stays readable with
+// standard tools; names go last since they may contain spaces.
+
+std::string PlayerStats::key(int playerId) {
+    return "player/" + std::to_string(playerId);
+}
+
+std::string PlayerStats::serialize() const {
+    return std::to_string(gamesPlayed) + "\t" + std::to_string(wins) + "\t" + name;
+}
+
+bool PlayerStats::parse(const std::string& data, PlayerStats& stats) {
+    std::istringstream fields(data);
+    if (!(fields >> stats.gamesPlayed >> stats.wins) || fields.get() != '\t') {
+        return false;
+    }
+    std::getline(fields, stats.name);
+    return true;
+}
+
+std::string MatchResult::key() const {
+    // Zero padded so a prefix scan returns matches in time order
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "match/%015lld-%d", (long long)endedAt, roomId);
+    return buffer;
+}
+
+std::string MatchResult::serialize() const {
+    std::string players;
+    for (size_t i = 0; i < playerIds.size(); ++i) {
+        players += (i ? "," : "") + std::to_string(playerIds[i]);
+    }
+    return std::to_string(roomId) + "\t" + std::to_string(winnerId) + "\t" +
+           std::to_string(endedAt) + "\t" + (players.empty() ? "-" : players) + "\t" + roomName;
+}
+
+bool MatchResult::parse(const std::string& data, MatchResult& result) {
+    std::istringstream fields(data);
+    long long endedAt = 0;
+    std::string players;
+    if (!(fields >> result.roomId >> result.winnerId >> endedAt >> players) || fields.get() != '\t') {
+        return false;
+    }
+    result.endedAt = endedAt;
+    std::getline(fields, result.roomName);
+
+    result.playerIds.clear();
+    if (players != "-") {
+        std::istringstream ids(players);
+        std::string id;
+        while (std::getline(ids, id, ',')) {
+            result.playerIds.push_back(std::atoi(id.c_str()));
+        }
+    }
+    return true;
+}
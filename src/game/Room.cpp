@@ -42,9 +42,24 @@ std::shared_ptr<Player> Room::getPlayer(int playerId) {
     return nullptr;
 }
 
+bool Room::addSpectator(int spectatorId) {
+    return spectatorStream.addSpectator(spectatorId);
+}
+
+bool Room::removeSpectator(int spectatorId) {
+    if (!spectatorStream.removeSpectator(spectatorId)) {
+        return false;
+    }
+    if (spectatorStream.getSpectatorCount() == 0) {
+        spectatorStream.clear();
+    }
+    return true;
+}
+
 void Room::startGame() {
     if (players.size() >= 2 && !isStarted) {
         isStarted = true;
+        lineup = players;
         // Game logic would go here
         LOG_INFO("Game started in room " + std::to_string(roomId));
     }
@@ -52,6 +67,7 @@ void Room::startGame() {
 
 void Room::resetRoom() {
     isStarted = false;
+    lineup.clear();
     for (auto& player : players) {
         player->isReady = false;
     }
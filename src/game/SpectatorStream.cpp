@@ -0,0 +1,136 @@
+#include "game/SpectatorStream.h"
+#include "utils/Metrics.h"
+
+namespace {
+
+struct SpectatorMetrics {
+    Counter& frames;
+    Counter& skips;
+
+    SpectatorMetrics()
+        : frames(MetricsRegistry::getInstance().counter(
+              "gameserver_spectator_frames_total", "Updates appended to spectator streams, once per room and tick"))
+        , skips(MetricsRegistry::getInstance().counter(
+              "gameserver_spectator_skips_total", "Spectators moved ahead to a keyframe after falling behind")) {}
+};
+
+SpectatorMetrics& spectatorMetrics() {
+    static SpectatorMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+SpectatorStream::SpectatorStream(size_t capacity)
+    : ring(capacity > 0 ? capacity : 1)
+    , delay(0)
+    , firstSequence(0)
+    , nextSequence(0)
+    , releasedSequence(0)
+    , keyframeSequence(0)
+    , hasKeyframe(false)
+    , skips(0) {}
+
+bool SpectatorStream::addSpectator(int id) {
+    return cursors.emplace(id, Cursor{0, false}).second;
+}
+
+bool SpectatorStream::removeSpectator(int id) {
+    return cursors.erase(id) != 0;
+}
+
+std::vector<int> SpectatorStream::getSpectators() const {
+    std::vector<int> ids;
+    ids.reserve(cursors.size());
+    for (const auto& pair : cursors) {
+        ids.push_back(pair.first);
+    }
+    return ids;
+}
+
+void SpectatorStream::append(Frame frame, bool keyframe, Clock::time_point now) {
+    if (getFrameCount() == ring.size()) {
+        // Overwrites the oldest frame; cursors still on it skip when they next read
+        ++firstSequence;
+    }
+    Entry& slot = entry(nextSequence);
+    slot.data = std::move(frame);
+    slot.appended = now;
+    slot.keyframe = keyframe;
+    ++nextSequence;
+    spectatorMetrics().frames.inc();
+}
+
+void SpectatorStream::release(Clock::time_point now) {
+    // With a delay longer than the ring holds, frames leave before they are readable
+    if (releasedSequence < firstSequence) {
+        releasedSequence = firstSequence;
+    }
+    while (releasedSequence < nextSequence) {
+        Entry& next = entry(releasedSequence);
+        if (next.appended + delay > now) {
+            break;
+        }
+        if (next.keyframe) {
+            keyframeSequence = releasedSequence;
+            hasKeyframe = true;
+        }
+        ++releasedSequence;
+    }
+    if (hasKeyframe && keyframeSequence < firstSequence) {
+        hasKeyframe = false;
+    }
+}
+
+size_t SpectatorStream::read(int id, Clock::time_point now, std::vector<Frame>& frames) {
+    auto it = cursors.find(id);
+    if (it == cursors.end()) {
+        return 0;
+    }
+    release(now);
+
+    Cursor& cursor = it->second;
+    if (cursor.synced && cursor.next < firstSequence) {
+        cursor.synced = false;
+        ++skips;
+        spectatorMetrics().skips.inc();
+    }
+    if (!cursor.synced) {
+        // Only a keyframe at or past the cursor: going back would repeat frames
+        if (!hasKeyframe || keyframeSequence < cursor.next) {
+            return 0;
+        }
+        cursor.next = keyframeSequence;
+        cursor.synced = true;
+    }
+
+    size_t count = 0;
+    for (; cursor.next < releasedSequence; ++cursor.next) {
+        frames.push_back(entry(cursor.next).data);
+        ++count;
+    }
+    return count;
+}
+
+void SpectatorStream::skip(int id) {
+    auto it = cursors.find(id);
+    if (it == cursors.end() || !it->second.synced) {
+        return;
+    }
+    it->second.synced = false;
+    ++skips;
+    spectatorMetrics().skips.inc();
+}
+
+void SpectatorStream::clear() {
+    for (Entry& slot : ring) {
+        slot.data.reset();
+    }
+    firstSequence = nextSequence;
+    releasedSequence = nextSequence;
+    hasKeyframe = false;
+    for (auto& pair : cursors) {
+        pair.second.next = nextSequence;
+        pair.second.synced = false;
+    }
+}
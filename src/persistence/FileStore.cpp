@@ -0,0 +1,389 @@
+#include "persistence/FileStore.h"
+#include "utils/Logger.h"
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <sys/file.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace {
+
+const size_t RECORD_HEADER_SIZE = 13;
+const uint8_t RECORD_ERASED = 1;
+
+// Compaction only pays off once the file is reasonably large
+const size_t COMPACT_MIN_BYTES = 1024 * 1024;
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+uint32_t crc32(const char* data, size_t len) {
+    static const Crc32Table table;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; ++i) {
+        crc = table.entries[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void putU32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (char)(value >> (8 * i));
+    }
+}
+
+uint32_t getU32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= (uint32_t)(uint8_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+size_t encodedSize(const std::string& key, const std::string& value) {
+    return RECORD_HEADER_SIZE + key.size() + value.size();
+}
+
+} // namespace
+
+void encodeStorageRecord(std::string& out, const StorageRecord& record) {
+    size_t start = out.size();
+    out.resize(start + RECORD_HEADER_SIZE);
+    putU32(&out[start + 4], (uint32_t)record.key.size());
+    putU32(&out[start + 8], (uint32_t)record.value.size());
+    out[start + 12] = (char)(record.erased ? RECORD_ERASED : 0);
+    out.append(record.key);
+    out.append(record.value);
+    putU32(&out[start], crc32(out.data() + start + 4, out.size() - start - 4));
+}
+
+size_t decodeStorageRecords(const std::string& data, const std::function<void(StorageRecord&)>& visit) {
+    size_t offset = 0;
+    StorageRecord record;
+    while (data.size() - offset >= RECORD_HEADER_SIZE) {
+        const char* header = data.data() + offset;
+        size_t keyLen = getU32(header + 4);
+        size_t valueLen = getU32(header + 8);
+        size_t total = RECORD_HEADER_SIZE + keyLen + valueLen;
+        if (keyLen > data.size() || valueLen > data.size() || total > data.size() - offset) {
+            break;
+        }
+        if (crc32(header + 4, total - 4) != getU32(header)) {
+            break;
+        }
+        record.key.assign(header + RECORD_HEADER_SIZE, keyLen);
+        record.value.assign(header + RECORD_HEADER_SIZE + keyLen, valueLen);
+        record.erased = (header[12] & RECORD_ERASED) != 0;
+        visit(record);
+        offset += total;
+    }
+    return offset;
+}
+
+bool readWholeFile(const std::string& path, std::string& data) {
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) {
+        return false;
+    }
+    data.clear();
+    char buffer[65536];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        data.append(buffer, n);
+    }
+    bool ok = !std::ferror(in);
+    std::fclose(in);
+    return ok;
+}
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+std::unique_ptr<StorageBackend> createStorageBackend(const std::string& type,
+                                                     const std::string& directory) {
+    if (type == "file") {
+        return std::unique_ptr<StorageBackend>(new FileStore(directory + "/store.db"));
+    }
+    if (type == "memory") {
+        return std::unique_ptr<StorageBackend>(new MemoryStore());
+    }
+    return nullptr;
+}
+
+FileStore::FileStore(const std::string& path)
+    : path(path)
+    , file(nullptr)
+    , lockFd(-1)
+    , fileBytes(0)
+    , liveBytes(0) {}
+
+FileStore::~FileStore() {
+    close();
+}
+
+bool FileStore::lockFile() {
+#ifdef _WIN32
+    return true;
+#else
+    // One process per store. A hot restart waits for the previous process to
+    // release it; the retries only cover that wait timing out.
+    lockFd = ::open((path + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd < 0) {
+        LOG_ERR("FileStore: cannot create lock file for " + path);
+        return false;
+    }
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        if (flock(lockFd, LOCK_EX | LOCK_NB) == 0) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    LOG_ERR("FileStore: " + path + " is in use by another process");
+    ::close(lockFd);
+    lockFd = -1;
+    return false;
+#endif
+}
+
+bool FileStore::open() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::lock_guard<std::mutex> indexLock(indexMutex);
+    if (file) {
+        return true;
+    }
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, error);
+    }
+    if (!lockFile()) {
+        return false;
+    }
+
+    std::string data;
+    index.clear();
+    liveBytes = 0;
+    if (readWholeFile(path, data)) {
+        size_t valid = decodeStorageRecords(data, [this](StorageRecord& record) {
+            auto it = index.find(record.key);
+            if (it != index.end()) {
+                liveBytes -= encodedSize(it->first, it->second);
+                index.erase(it);
+            }
+            if (!record.erased) {
+                liveBytes += encodedSize(record.key, record.value);
+                index.emplace(std::move(record.key), std::move(record.value));
+            }
+        });
+        if (valid < data.size()) {
+            // A batch torn by a crash was never acknowledged; drop it
+            LOG_WARN("FileStore: discarding " + std::to_string(data.size() - valid) +
+                     " bytes of incomplete writes in " + path);
+            std::filesystem::resize_file(path, valid, error);
+        }
+        fileBytes = valid;
+    }
+
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        LOG_ERR("FileStore: cannot open " + path);
+        return false;
+    }
+    LOG_INFO("FileStore: loaded " + std::to_string(index.size()) + " keys from " + path);
+    return true;
+}
+
+void FileStore::close() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (file) {
+        syncFile(file);
+        std::fclose(file);
+        file = nullptr;
+    }
+#ifndef _WIN32
+    if (lockFd >= 0) {
+        ::close(lockFd);
+        lockFd = -1;
+    }
+#endif
+}
+
+bool FileStore::writeBatch(const std::vector<StorageRecord>& records) {
+    std::string buffer;
+    for (const auto& record : records) {
+        encodeStorageRecord(buffer, record);
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (!file) {
+        return false;
+    }
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size() || !syncFile(file)) {
+        LOG_ERR("FileStore: write to " + path + " failed");
+        // Cut the partial batch off, later appends must not land behind it
+        std::fclose(file);
+        std::error_code error;
+        std::filesystem::resize_file(path, fileBytes, error);
+        file = std::fopen(path.c_str(), "ab");
+        return false;
+    }
+    fileBytes += buffer.size();
+
+    size_t live;
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex);
+        for (const auto& record : records) {
+            auto it = index.find(record.key);
+            if (it != index.end()) {
+                liveBytes -= encodedSize(it->first, it->second);
+            }
+            if (record.erased) {
+                if (it != index.end()) {
+                    index.erase(it);
+                }
+            } else {
+                liveBytes += encodedSize(record.key, record.value);
+                index[record.key] = record.value;
+            }
+        }
+        live = liveBytes;
+    }
+
+    if (fileBytes > COMPACT_MIN_BYTES && fileBytes > 2 * live) {
+        compactLocked();
+    }
+    return true;
+}
+
+bool FileStore::read(const std::string& key, std::string& value) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+void FileStore::scan(const std::string& prefix, const Visitor& visit) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    for (auto it = index.lower_bound(prefix);
+         it != index.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        visit(it->first, it->second);
+    }
+}
+
+bool FileStore::compact() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return compactLocked();
+}
+
+bool FileStore::compactLocked() {
+    if (!file) {
+        return false;
+    }
+    // Only writeBatch() changes the index, and it waits for fileMutex
+    std::string buffer;
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex);
+        buffer.reserve(liveBytes);
+        for (const auto& pair : index) {
+            encodeStorageRecord(buffer, StorageRecord{pair.first, pair.second, false});
+        }
+    }
+
+    // Write then rename, so a crash leaves either the old or the new file
+    std::string tempPath = path + ".compact";
+    std::FILE* out = std::fopen(tempPath.c_str(), "wb");
+    if (!out) {
+        LOG_ERR("FileStore: cannot create " + tempPath);
+        return false;
+    }
+    bool written = std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size() && syncFile(out);
+    std::fclose(out);
+    std::error_code error;
+    if (!written) {
+        std::filesystem::remove(tempPath, error);
+        LOG_ERR("FileStore: compaction of " + path + " failed");
+        return false;
+    }
+
+    std::fclose(file);
+    std::filesystem::rename(tempPath, path, error);
+    file = std::fopen(path.c_str(), "ab");
+    if (error || !file) {
+        LOG_ERR("FileStore: cannot replace " + path + " after compaction");
+        return false;
+    }
+    LOG_INFO("FileStore: compacted " + path + " from " + std::to_string(fileBytes) +
+             " to " + std::to_string(buffer.size()) + " bytes");
+    fileBytes = buffer.size();
+    return true;
+}
+
+size_t FileStore::getFileSize() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return fileBytes;
+}
+
+size_t FileStore::getKeyCount() {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return index.size();
+}
+
+bool MemoryStore::writeBatch(const std::vector<StorageRecord>& records) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& record : records) {
+        if (record.erased) {
+            data.erase(record.key);
+        } else {
+            data[record.key] = record.value;
+        }
+    }
+    return true;
+}
+
+bool MemoryStore::read(const std::string& key, std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = data.find(key);
+    if (it == data.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+void MemoryStore::scan(const std::string& prefix, const Visitor& visit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = data.lower_bound(prefix);
+         it != data.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        visit(it->first, it->second);
+    }
+}
@@ -0,0 +1,348 @@
+#include "persistence/WriteBehindStore.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+
+struct PersistenceMetrics {
+    Gauge& pending;
+    Counter& updates;
+    Counter& coalesced;
+    Counter& recordsWritten;
+    Counter& batches;
+    Counter& failures;
+    Histogram& batchDuration;
+
+    PersistenceMetrics()
+        : pending(MetricsRegistry::getInstance().gauge(
+              "gameserver_persistence_pending", "Keys waiting for the write-behind thread"))
+        , updates(MetricsRegistry::getInstance().counter(
+              "gameserver_persistence_updates_total", "Updates acknowledged by the persistence layer"))
+        , coalesced(MetricsRegistry::getInstance().counter(
+              "gameserver_persistence_coalesced_total", "Updates merged into a queued update for the same key"))
+        , recordsWritten(MetricsRegistry::getInstance().counter(
+              "gameserver_persistence_records_written_total", "Records written to the storage backend"))
+        , batches(MetricsRegistry::getInstance().counter(
+              "gameserver_persistence_batches_total", "Batches written to the storage backend"))
+        , failures(MetricsRegistry::getInstance().counter(
+              "gameserver_persistence_write_failures_total", "Backend batch writes that failed and were retried"))
+        , batchDuration(MetricsRegistry::getInstance().histogram(
+              "gameserver_persistence_batch_us", "Backend batch write duration in microseconds")) {}
+};
+
+PersistenceMetrics& persistenceMetrics() {
+    static PersistenceMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+WriteBehindStore::WriteBehindStore(std::unique_ptr<StorageBackend> backend, const std::string& journalPrefix)
+    : backend(std::move(backend))
+    , journalPrefix(journalPrefix)
+    , flushInterval(std::chrono::milliseconds(100))
+    , maxBatchSize(1024)
+    , journalSync(false)
+    , acknowledged(0)
+    , persisted(0)
+    , flushRequested(false)
+    , stopping(false)
+    , running(false)
+    , journal(nullptr)
+    , journalSequence(0) {}
+
+WriteBehindStore::~WriteBehindStore() {
+    stop();
+}
+
+std::string WriteBehindStore::segmentPath(uint64_t sequence) const {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%08llu", (unsigned long long)sequence);
+    return journalPrefix + suffix;
+}
+
+std::vector<std::pair<uint64_t, std::string>> WriteBehindStore::listSegments() {
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::filesystem::path prefix(journalPrefix);
+    std::filesystem::path directory = prefix.parent_path().empty() ? "." : prefix.parent_path();
+    std::string stem = prefix.filename().string() + ".";
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, stem.size(), stem) != 0) {
+            continue;
+        }
+        std::string number = name.substr(stem.size());
+        if (number.empty() || number.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        segments.emplace_back(std::strtoull(number.c_str(), nullptr, 10), entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+bool WriteBehindStore::recoverJournal() {
+    auto segments = listSegments();
+    if (segments.empty()) {
+        return true;
+    }
+
+    // Later segments win, same as the order the updates were acknowledged in
+    std::map<std::string, Pending> recovered;
+    size_t updates = 0;
+    for (const auto& segment : segments) {
+        std::string data;
+        if (!readWholeFile(segment.second, data)) {
+            LOG_ERR("Persistence: cannot read journal " + segment.second);
+            return false;
+        }
+        size_t valid = decodeStorageRecords(data, [&recovered, &updates](StorageRecord& record) {
+            recovered[record.key] = Pending{std::move(record.value), record.erased};
+            ++updates;
+        });
+        if (valid < data.size()) {
+            // Only the update being appended when we crashed; never acknowledged
+            LOG_WARN("Persistence: ignoring torn tail of " + segment.second);
+        }
+        journalSequence = std::max(journalSequence, segment.first);
+    }
+
+    std::vector<StorageRecord> records;
+    records.reserve(recovered.size());
+    for (auto& pair : recovered) {
+        records.push_back(StorageRecord{pair.first, std::move(pair.second.value), pair.second.erased});
+    }
+    if (!backend->writeBatch(records)) {
+        LOG_ERR("Persistence: replaying the journal into the " + backend->name() + " store failed");
+        return false;
+    }
+    std::error_code error;
+    for (const auto& segment : segments) {
+        std::filesystem::remove(segment.second, error);
+    }
+    LOG_INFO("Persistence: recovered " + std::to_string(updates) + " journaled updates (" +
+             std::to_string(records.size()) + " keys)");
+    return true;
+}
+
+bool WriteBehindStore::openSegment() {
+    std::string path = segmentPath(++journalSequence);
+    journal = std::fopen(path.c_str(), "wb");
+    if (!journal) {
+        LOG_ERR("Persistence: cannot create journal " + path);
+        return false;
+    }
+    return true;
+}
+
+bool WriteBehindStore::start() {
+    if (running) {
+        return true;
+    }
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(journalPrefix).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, error);
+    }
+    if (!backend->open()) {
+        return false;
+    }
+    if (!recoverJournal() || !openSegment()) {
+        backend->close();
+        return false;
+    }
+
+    stopping = false;
+    running = true;
+    writer = std::thread(&WriteBehindStore::writerLoop, this);
+    LOG_INFO("Persistence: write-behind to the " + backend->name() + " store, journal " + journalPrefix);
+    return true;
+}
+
+void WriteBehindStore::stop() {
+    if (!running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    writerWake.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string current = segmentPath(journalSequence);
+    if (journal) {
+        std::fclose(journal);
+        journal = nullptr;
+    }
+    // Anything still pending stays journaled for the next start()
+    if (pending.empty()) {
+        std::error_code error;
+        std::filesystem::remove(current, error);
+    } else {
+        LOG_ERR("Persistence: " + std::to_string(pending.size()) +
+                " keys could not be stored, they stay in the journal");
+    }
+    running = false;
+    backend->close();
+}
+
+bool WriteBehindStore::put(const std::string& key, const std::string& value) {
+    return enqueue(key, value, false);
+}
+
+bool WriteBehindStore::erase(const std::string& key) {
+    return enqueue(key, std::string(), true);
+}
+
+bool WriteBehindStore::enqueue(const std::string& key, const std::string& value, bool erased) {
+    TRACE_SCOPE("WriteBehindStore::enqueue");
+    StorageRecord record{key, value, erased};
+    std::string encoded;
+    encodeStorageRecord(encoded, record);
+
+    bool wakeWriter = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!journal) {
+            return false;
+        }
+        if (std::fwrite(encoded.data(), 1, encoded.size(), journal) != encoded.size() ||
+            (journalSync ? !syncFile(journal) : std::fflush(journal) != 0)) {
+            LOG_ERR("Persistence: journal append failed, update for " + key + " rejected");
+            return false;
+        }
+
+        auto it = pending.find(key);
+        if (it != pending.end()) {
+            it->second = Pending{value, erased};
+            persistenceMetrics().coalesced.inc();
+        } else {
+            pending.emplace(key, Pending{value, erased});
+            persistenceMetrics().pending.set((int64_t)pending.size());
+            wakeWriter = pending.size() >= maxBatchSize;
+        }
+        ++acknowledged;
+    }
+    persistenceMetrics().updates.inc();
+    if (wakeWriter) {
+        writerWake.notify_one();
+    }
+    return true;
+}
+
+bool WriteBehindStore::get(const std::string& key, std::string& value) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto* queue : {&pending, &inflight}) {
+            auto it = queue->find(key);
+            if (it != queue->end()) {
+                if (it->second.erased) {
+                    return false;
+                }
+                value = it->second.value;
+                return true;
+            }
+        }
+    }
+    return backend->read(key, value);
+}
+
+bool WriteBehindStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running) {
+        return pending.empty();
+    }
+    uint64_t target = acknowledged;
+    flushRequested = true;
+    writerWake.notify_one();
+    batchDone.wait(lock, [this, target]() { return persisted >= target || stopping; });
+    return persisted >= target;
+}
+
+size_t WriteBehindStore::getPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size() + inflight.size();
+}
+
+void WriteBehindStore::writerLoop() {
+    Tracer::getInstance().setThreadName("persistence");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        writerWake.wait_for(lock, flushInterval, [this]() {
+            return stopping || flushRequested || pending.size() >= maxBatchSize;
+        });
+        flushRequested = false;
+        if (pending.empty()) {
+            persisted = acknowledged;
+            batchDone.notify_all();
+            if (stopping) {
+                break;
+            }
+            continue;
+        }
+
+        // Everything journaled so far is in this batch, so the current
+        // segment can be retired once the batch is stored
+        inflight.swap(pending);
+        uint64_t batchEnd = acknowledged;
+        persistenceMetrics().pending.set(0);
+        if (journal) {
+            std::fclose(journal);
+            journal = nullptr;
+        }
+        sealedSegments.push_back(segmentPath(journalSequence));
+        openSegment();
+
+        std::vector<StorageRecord> records;
+        records.reserve(inflight.size());
+        for (const auto& pair : inflight) {
+            records.push_back(StorageRecord{pair.first, pair.second.value, pair.second.erased});
+        }
+
+        lock.unlock();
+        bool stored;
+        {
+            TRACE_SCOPE("WriteBehindStore::writeBatch");
+            auto start = std::chrono::steady_clock::now();
+            stored = backend->writeBatch(records);
+            persistenceMetrics().batchDuration.record((uint64_t)std::chrono::duration_cast<
+                std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+        lock.lock();
+
+        if (stored) {
+            std::error_code error;
+            for (const auto& segment : sealedSegments) {
+                std::filesystem::remove(segment, error);
+            }
+            sealedSegments.clear();
+            persisted = batchEnd;
+            persistenceMetrics().batches.inc();
+            persistenceMetrics().recordsWritten.inc(records.size());
+        } else {
+            // Newer updates queued meanwhile win; the sealed segments stay
+            // until a later batch covering them succeeds
+            persistenceMetrics().failures.inc();
+            for (auto& pair : inflight) {
+                pending.emplace(pair.first, std::move(pair.second));
+            }
+            persistenceMetrics().pending.set((int64_t)pending.size());
+        }
+        inflight.clear();
+        batchDone.notify_all();
+
+        if (!stored && stopping) {
+            break;
+        }
+    }
+}
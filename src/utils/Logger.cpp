@@ -1,4 +1,5 @@
 #include "utils/Logger.h"
+#include "utils/Trace.h"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
@@ -110,6 +111,7 @@ void Logger::log(Level level, const std::string& message) {
         return;
     }
     
+    TRACE_SCOPE("Logger::log");
     std::lock_guard<std::mutex> lock(logMutex);
     
     std::string formattedMessage = formatMessage(level, message);
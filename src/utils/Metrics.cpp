@@ -0,0 +1,222 @@
+#include "utils/Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+Counter::Counter(const std::string& name, const std::string& help)
+    : name(name), help(help) {}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Gauge::Gauge(const std::string& name, const std::string& help)
+    : name(name), help(help), current(0) {}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * (double)count);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen > rank) {
+            // The top bucket is unbounded, the tracked max is more useful there
+            return std::min(Histogram::bucketUpperBound(i), max);
+        }
+    }
+    return max;
+}
+
+Histogram::Shard::Shard() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Histogram(const std::string& name, const std::string& help)
+    : name(name), help(help) {
+    for (auto& shard : shards) {
+        shard.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+Histogram::~Histogram() {
+    for (auto& shard : shards) {
+        delete shard.load(std::memory_order_relaxed);
+    }
+}
+
+size_t Histogram::bucketIndex(uint64_t v) {
+    if (v < LINEAR_BUCKETS) {
+        return (size_t)v;
+    }
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - SUB_BUCKET_BITS;
+    size_t sub = (size_t)(v >> shift) - (1u << SUB_BUCKET_BITS);
+    size_t index = LINEAR_BUCKETS + (size_t)(shift - 1) * (1u << SUB_BUCKET_BITS) + sub;
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    if (index < LINEAR_BUCKETS) {
+        return index;
+    }
+    size_t offset = index - LINEAR_BUCKETS;
+    int shift = (int)(offset >> SUB_BUCKET_BITS) + 1;
+    uint64_t sub = (offset & ((1u << SUB_BUCKET_BITS) - 1)) + (1u << SUB_BUCKET_BITS);
+    return ((sub + 1) << shift) - 1;
+}
+
+Histogram::Shard* Histogram::getShard() {
+    std::atomic<Shard*>& slot = shards[metricsThreadSlot()];
+    Shard* shard = slot.load(std::memory_order_acquire);
+    if (shard) {
+        return shard;
+    }
+    Shard* fresh = new Shard();
+    if (slot.compare_exchange_strong(shard, fresh, std::memory_order_acq_rel)) {
+        return fresh;
+    }
+    // Another thread mapped to the same slot won the race
+    delete fresh;
+    return shard;
+}
+
+void Histogram::record(uint64_t v) {
+    Shard* shard = getShard();
+    shard->buckets[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    shard->count.fetch_add(1, std::memory_order_relaxed);
+    shard->sum.fetch_add(v, std::memory_order_relaxed);
+
+    uint64_t currentMax = shard->max.load(std::memory_order_relaxed);
+    while (v > currentMax &&
+           !shard->max.compare_exchange_weak(currentMax, v, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot snap;
+    snap.buckets.assign(BUCKET_COUNT, 0);
+    for (const auto& slot : shards) {
+        const Shard* shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            snap.buckets[i] += shard->buckets[i].load(std::memory_order_relaxed);
+        }
+        snap.count += shard->count.load(std::memory_order_relaxed);
+        snap.sum += shard->sum.load(std::memory_order_relaxed);
+        snap.max = std::max(snap.max, shard->max.load(std::memory_order_relaxed));
+    }
+    return snap;
+}
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto& slot = counters[name];
+    if (!slot) {
+        slot.reset(new Counter(name, help));
+    }
+    return *slot;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto& slot = gauges[name];
+    if (!slot) {
+        slot.reset(new Gauge(name, help));
+    }
+    return *slot;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto& slot = histograms[name];
+    if (!slot) {
+        slot.reset(new Histogram(name, help));
+    }
+    return *slot;
+}
+
+std::vector<std::pair<std::string, uint64_t>> MetricsRegistry::counterValues() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<std::pair<std::string, uint64_t>> values;
+    for (const auto& pair : counters) {
+        values.emplace_back(pair.first, pair.second->value());
+    }
+    return values;
+}
+
+std::vector<std::pair<std::string, int64_t>> MetricsRegistry::gaugeValues() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<std::pair<std::string, int64_t>> values;
+    for (const auto& pair : gauges) {
+        values.emplace_back(pair.first, pair.second->value());
+    }
+    return values;
+}
+
+std::vector<std::pair<std::string, HistogramSnapshot>> MetricsRegistry::histogramSnapshots() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<std::pair<std::string, HistogramSnapshot>> values;
+    for (const auto& pair : histograms) {
+        values.emplace_back(pair.first, pair.second->snapshot());
+    }
+    return values;
+}
+
+std::string MetricsRegistry::renderPrometheus() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::ostringstream out;
+
+    for (const auto& pair : counters) {
+        const Counter& c = *pair.second;
+        if (!c.getHelp().empty()) {
+            out << "# HELP " << c.getName() << " " << c.getHelp() << "\n";
+        }
+        out << "# TYPE " << c.getName() << " counter\n";
+        out << c.getName() << " " << c.value() << "\n";
+    }
+
+    for (const auto& pair : gauges) {
+        const Gauge& g = *pair.second;
+        if (!g.getHelp().empty()) {
+            out << "# HELP " << g.getName() << " " << g.getHelp() << "\n";
+        }
+        out << "# TYPE " << g.getName() << " gauge\n";
+        out << g.getName() << " " << g.value() << "\n";
+    }
+
+    // Histograms are exposed as summaries: a few quantiles instead of ~600 buckets
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+    for (const auto& pair : histograms) {
+        const Histogram& h = *pair.second;
+        HistogramSnapshot snap = h.snapshot();
+        if (!h.getHelp().empty()) {
+            out << "# HELP " << h.getName() << " " << h.getHelp() << "\n";
+        }
+        out << "# TYPE " << h.getName() << " summary\n";
+        for (double q : QUANTILES) {
+            out << h.getName() << "{quantile=\"" << q << "\"} " << snap.percentile(q) << "\n";
+        }
+        out << h.getName() << "_sum " << snap.sum << "\n";
+        out << h.getName() << "_count " << snap.count << "\n";
+    }
+
+    return out.str();
+}
@@ -0,0 +1,169 @@
+#include "utils/MetricsExporter.h"
+#include "utils/Metrics.h"
+#include "utils/Logger.h"
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+#include <cstring>
+
+MetricsExporter::MetricsExporter()
+    : listenFd(-1)
+    , boundPort(0)
+    , running(false) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+void MetricsExporter::addHandler(const std::string& path, Handler handler,
+                                 const std::string& contentType) {
+    std::lock_guard<std::mutex> lock(pagesMutex);
+    pages[path] = Page{std::move(handler), contentType};
+}
+
+#ifdef _WIN32
+
+bool MetricsExporter::start(int port) {
+    LOG_WARN("Metrics endpoint is not supported on Windows");
+    return false;
+}
+
+void MetricsExporter::stop() {}
+void MetricsExporter::serve() {}
+void MetricsExporter::handleRequest(int client) {}
+
+#else
+
+bool MetricsExporter::start(int port) {
+    if (running) {
+        return true;
+    }
+
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        LOG_ERR("Metrics endpoint: failed to create socket");
+        return false;
+    }
+    int opt = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Loopback only: the endpoint is unauthenticated
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        LOG_ERR("Metrics endpoint: bind/listen on port " + std::to_string(port) +
+                " failed: " + std::string(strerror(errno)));
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, (struct sockaddr*)&addr, &len);
+    boundPort = ntohs(addr.sin_port);
+
+    running = true;
+    worker = std::thread(&MetricsExporter::serve, this);
+    LOG_INFO("Metrics endpoint on http://127.0.0.1:" + std::to_string(boundPort) + "/metrics");
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    close(listenFd);
+    listenFd = -1;
+}
+
+void MetricsExporter::serve() {
+    while (running) {
+        // Short poll timeout so stop() does not need to wake us up
+        struct pollfd pfd;
+        pfd.fd = listenFd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        handleRequest(client);
+        close(client);
+    }
+}
+
+void MetricsExporter::handleRequest(int client) {
+    struct timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char buffer[2048];
+    ssize_t n = recv(client, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0) {
+        return;
+    }
+    buffer[n] = '\0';
+
+    std::string request(buffer);
+    std::string path;
+    if (request.compare(0, 4, "GET ") == 0) {
+        path = request.substr(4, request.find(' ', 4) - 4);
+    }
+
+    std::string status = "200 OK";
+    std::string contentType = "text/plain; version=0.0.4";
+    std::string body;
+    Handler handler;
+    if (path != "/metrics" && path != "/") {
+        std::lock_guard<std::mutex> lock(pagesMutex);
+        auto it = pages.find(path);
+        if (it != pages.end()) {
+            handler = it->second.handler;
+            contentType = it->second.contentType;
+        }
+    }
+
+    if (path == "/metrics" || path == "/") {
+        body = MetricsRegistry::getInstance().renderPrometheus();
+    } else if (handler) {
+        body = handler();
+    } else {
+        status = "404 Not Found";
+        contentType = "text/plain";
+        body = "not found\n";
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+        "Content-Type: " + contentType + "\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    const char* data = response.data();
+    size_t remaining = response.size();
+    while (remaining > 0) {
+        ssize_t sent = send(client, data, remaining, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            break;
+        }
+        data += sent;
+        remaining -= (size_t)sent;
+    }
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "utils/Trace.h"
+#include "utils/Logger.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+uint64_t steadyNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t baseSteadyNanos = 0;
+
+void writeJsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer()
+    : enabled(false)
+    , dumpRequested(false)
+    , baseTimestamp(traceTimestamp())
+    , ticksPerMicrosecond(1000.0) {
+    baseSteadyNanos = steadyNanos();
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    TraceBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer.threadName = name;
+}
+
+TraceBuffer* Tracer::registerThread() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffers.emplace_back(new TraceBuffer((uint32_t)buffers.size() + 1));
+    return buffers.back().get();
+}
+
+double Tracer::toMicroseconds(uint64_t timestamp) const {
+    return (double)(timestamp - baseTimestamp) / ticksPerMicrosecond;
+}
+
+void Tracer::writeChromeJson(std::ostream& out) {
+#if defined(__x86_64__) || defined(__i386__)
+    // Calibrate the TSC against steady_clock over the whole tracer lifetime
+    uint64_t elapsedNanos = steadyNanos() - baseSteadyNanos;
+    uint64_t elapsedTicks = traceTimestamp() - baseTimestamp;
+    if (elapsedNanos > 0) {
+        ticksPerMicrosecond = (double)elapsedTicks * 1000.0 / (double)elapsedNanos;
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    out.setf(std::ios::fixed);
+    out.precision(3);
+
+    for (const auto& buffer : buffers) {
+        if (!buffer->threadName.empty()) {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(out, buffer->threadName);
+            out << "}}";
+            first = false;
+        }
+
+        // Rings are read while their owners keep writing; events being
+        // overwritten right now may be torn and are dropped below.
+        uint64_t end = buffer->position.load(std::memory_order_acquire);
+        uint64_t begin = end > TraceBuffer::CAPACITY ? end - TraceBuffer::CAPACITY : 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            TraceEvent event = buffer->events[i & (TraceBuffer::CAPACITY - 1)];
+            if (!event.name || event.end < event.start || event.start < baseTimestamp) {
+                continue;
+            }
+            out << (first ? "" : ",") << "\n{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << toMicroseconds(event.start)
+                << ",\"dur\":" << (double)(event.end - event.start) / ticksPerMicrosecond << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+std::string Tracer::renderChromeJson() {
+    std::ostringstream out;
+    writeChromeJson(out);
+    return out.str();
+}
+
+bool Tracer::dumpToFile(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        LOG_ERR("Failed to open trace file " + filename);
+        return false;
+    }
+    writeChromeJson(file);
+    LOG_INFO("Trace written to " + filename);
+    return true;
+}
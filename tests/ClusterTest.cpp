@@ -0,0 +1,388 @@
+#include "cluster/ClusterNode.h"
+#include "cluster/ClusterRouter.h"
+#include "cluster/HashRing.h"
+#include "core/GameServer.h"
+#include "protocol/GameProtocol.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+static const int ROOM_COUNT = 24;
+
+// Cluster member: a GameServer on its own thread plus its control channel
+struct TestNode {
+    GameServer server;
+    ClusterNode control;
+    std::thread thread;
+    ClusterNodeInfo info;
+
+    TestNode() : control(server) {}
+
+    bool start(const std::string& name) {
+        if (!server.initialize(0) || !control.start(0)) {
+            return false;
+        }
+        thread = std::thread([this]() { server.run(); });
+        info.name = name;
+        info.host = "127.0.0.1";
+        info.gamePort = server.getPort();
+        info.controlPort = control.getControlPort();
+        return true;
+    }
+
+    ~TestNode() {
+        control.stop();
+        server.requestShutdown();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
+// Cluster member run the way operators run it: the GameServer binary next to this test
+struct ProcessNode {
+    pid_t pid;
+    ClusterNodeInfo info;
+
+    ProcessNode() : pid(-1) {}
+
+    bool start(const std::string& name) {
+        info.name = name;
+        info.host = "127.0.0.1";
+        info.gamePort = freePort();
+        info.controlPort = freePort();
+        if (info.gamePort <= 0 || info.controlPort <= 0) {
+            return false;
+        }
+        pid = fork();
+        if (pid == 0) {
+            int devNull = open("/dev/null", O_WRONLY);
+            dup2(devNull, STDOUT_FILENO);
+            std::string port = "--port=" + std::to_string(info.gamePort);
+            std::string clusterPort = "--cluster-port=" + std::to_string(info.controlPort);
+            execl("./GameServer", "GameServer", port.c_str(), clusterPort.c_str(), "--metrics-port=0",
+                  "--storage=none", "--handoff-socket=", (char*)nullptr);
+            _exit(127);
+        }
+        if (pid < 0) {
+            return false;
+        }
+        ControlClient client;
+        client.setAddress(info.host, info.controlPort);
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            std::string reply;
+            if (client.request("PING", "", reply)) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    ~ProcessNode() {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+
+    // Ephemeral port picked by the kernel, free again once this returns
+    static int freePort() {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        int port = -1;
+        if (fd >= 0 && bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+            getsockname(fd, (struct sockaddr*)&addr, &len) == 0) {
+            port = ntohs(addr.sin_port);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        return port;
+    }
+};
+
+static ClusterNodeInfo makeNode(const std::string& name) {
+    ClusterNodeInfo node;
+    node.name = name;
+    node.host = "127.0.0.1";
+    return node;
+}
+
+// Room ids a node reports over its control channel
+static std::vector<int> roomsOn(const ClusterNodeInfo& node) {
+    ControlClient client;
+    client.setAddress(node.host, node.controlPort);
+    std::string reply;
+    std::vector<int> roomIds;
+    if (client.request("ROOMS", "", reply)) {
+        std::istringstream ids(reply);
+        int roomId;
+        while (ids >> roomId) {
+            roomIds.push_back(roomId);
+        }
+    }
+    return roomIds;
+}
+
+// Every room is on its ring owner, and only there
+static bool roomsOnOwners(const std::vector<ClusterNodeInfo>& members, size_t expected) {
+    HashRing ring;
+    for (const auto& member : members) {
+        ring.addNode(member);
+    }
+    size_t total = 0;
+    for (const auto& member : members) {
+        for (int roomId : roomsOn(member)) {
+            if (ring.ownerOfRoom(roomId)->name != member.name) {
+                return false;
+            }
+            ++total;
+        }
+    }
+    return total == expected;
+}
+
+// True once a whole Snapshot frame arrives on a spectator's stream
+static bool receiveSnapshot(int fd) {
+    std::string data;
+    while (true) {
+        size_t size = 0;
+        protocol::FrameStatus status = protocol::findFrame((const uint8_t*)data.data(), data.size(),
+                                                           protocol::MAX_FRAME_SIZE, size);
+        if (status == protocol::FrameStatus::Complete) {
+            protocol::Snapshot snapshot;
+            return protocol::decodeMessage((const uint8_t*)data.data(), size, snapshot);
+        }
+        std::string more;
+        if (status == protocol::FrameStatus::Invalid || (more = receive(fd)).empty()) {
+            return false;
+        }
+        data += more;
+    }
+}
+
+// Round trip of one Ping frame on a connection switched to binary
+static bool pingPong(int fd, uint32_t sequence) {
+    protocol::Ping ping;
+    ping.sequence = sequence;
+    uint8_t frame[protocol::Ping::MAX_FRAME_SIZE];
+    size_t size = protocol::encodeMessage(ping, frame, sizeof(frame));
+    if (send(fd, frame, size, MSG_NOSIGNAL) != (ssize_t)size) {
+        return false;
+    }
+    std::string answer = receive(fd);
+    protocol::Pong pong;
+    return protocol::decodeMessage((const uint8_t*)answer.data(), answer.size(), pong) && pong.sequence == sequence;
+}
+
+int main() {
+    std::cout << "Running Cluster Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        // Node spec parsing
+        ClusterNodeInfo parsed;
+        CHECK(parseClusterNode("a@127.0.0.1:8001:9201", parsed), "parse node spec");
+        CHECK(parsed.name == "a" && parsed.host == "127.0.0.1" && parsed.gamePort == 8001 &&
+              parsed.controlPort == 9201, "parsed fields");
+        CHECK(formatClusterNode(parsed) == "a@127.0.0.1:8001:9201", "format node spec");
+        CHECK(!parseClusterNode("a@127.0.0.1:8001", parsed), "missing control port rejected");
+        CHECK(!parseClusterNode("@host:1:2", parsed), "empty name rejected");
+
+        // Ring balance and minimal movement
+        HashRing ring;
+        CHECK(ring.ownerOfRoom(1) == nullptr, "empty ring owns nothing");
+        for (const char* name : {"a", "b", "c"}) {
+            CHECK(ring.addNode(makeNode(name)), "add ring node");
+        }
+        CHECK(!ring.addNode(makeNode("a")), "duplicate node rejected");
+        const int keys = 30000;
+        std::map<int, std::string> before;
+        std::map<std::string, int> load;
+        for (int roomId = 1; roomId <= keys; ++roomId) {
+            before[roomId] = ring.ownerOfRoom(roomId)->name;
+            load[before[roomId]]++;
+        }
+        for (const auto& pair : load) {
+            CHECK(pair.second > keys / 3 * 0.7 && pair.second < keys / 3 * 1.3, "ring roughly balanced");
+        }
+        ring.addNode(makeNode("d"));
+        int moved = 0;
+        for (int roomId = 1; roomId <= keys; ++roomId) {
+            std::string owner = ring.ownerOfRoom(roomId)->name;
+            if (owner != before[roomId]) {
+                CHECK(owner == "d", "rooms only move to the new node");
+                ++moved;
+            }
+        }
+        CHECK(moved > keys / 4 * 0.6 && moved < keys / 4 * 1.4, "about 1/N of the rooms move");
+        CHECK(ring.removeNode("d") && !ring.removeNode("d"), "remove ring node");
+        for (int roomId = 1; roomId <= keys; ++roomId) {
+            CHECK(ring.ownerOfRoom(roomId)->name == before[roomId], "removal restores ownership");
+        }
+
+        // Three live nodes behind a router, and a GameServer process to add later
+        std::map<std::string, std::unique_ptr<TestNode>> nodes;
+        for (const char* name : {"a", "b", "c"}) {
+            nodes[name].reset(new TestNode());
+            CHECK(nodes[name]->start(name), "start node " + std::string(name));
+        }
+        ProcessNode spare;
+        CHECK(spare.start("d"), "start GameServer process");
+        ClusterRouter router;
+        std::string error;
+        std::vector<ClusterNodeInfo> members;
+        for (const auto& pair : nodes) {
+            CHECK(router.addNode(pair.second->info, error), "seed node");
+            members.push_back(pair.second->info);
+        }
+        CHECK(router.start(0, -1), "router start");
+        CHECK(router.getNodes().size() == 3, "router ring size");
+
+        // Rooms are created on their owners
+        std::vector<int> roomIds;
+        for (int i = 0; i < ROOM_COUNT; ++i) {
+            int roomId = router.createRoom("Room " + std::to_string(i), 4);
+            CHECK(roomId > 0, "create room");
+            roomIds.push_back(roomId);
+        }
+        CHECK(roomsOnOwners(members, ROOM_COUNT), "rooms placed on their owners");
+
+        // Clients join through the router
+        std::vector<int> clients;
+        for (int roomId : roomIds) {
+            int fd = connectClient(router.getClientPort());
+            CHECK(fd >= 0, "client connects to router");
+            CHECK(request(fd, "JOIN " + std::to_string(roomId)) == "JOINED " + std::to_string(roomId) + "\n",
+                  "client joins through router");
+            CHECK(request(fd, "ping") == "ping", "echo through router");
+            clients.push_back(fd);
+        }
+        // Players that switched to binary frames
+        std::vector<int> binaryPlayers;
+        for (int roomId : roomIds) {
+            int fd = connectClient(router.getClientPort());
+            const std::string id = std::to_string(roomId);
+            CHECK(fd >= 0 && request(fd, "JOIN " + id) == "JOINED " + id + "\n", "binary player joins");
+            CHECK(request(fd, "BINARY") == "BINARY\n", "switch to binary through router");
+            CHECK(pingPong(fd, 1), "frame through router");
+            binaryPlayers.push_back(fd);
+        }
+        int lobby = connectClient(router.getClientPort());
+        CHECK(lobby >= 0 && request(lobby, "hello") == "hello", "lobby session forwarded");
+        CHECK(request(lobby, "JOIN abc") == "JOIN_FAILED 0\n", "router refuses a non-numeric room");
+        CHECK(request(lobby, "JOIN 0") == "JOIN_FAILED 0\n", "router refuses room 0");
+        CHECK(request(lobby, "SPECTATE x1") == "SPECTATE_FAILED 0\n", "router refuses a bad spectate");
+        // Spectators are routed to the room's owner like players
+        std::vector<int> spectators;
+        for (int roomId : roomIds) {
+            int fd = connectClient(router.getClientPort());
+            const std::string id = std::to_string(roomId);
+            CHECK(fd >= 0 && request(fd, "SPECTATE " + id) == "SPECTATING " + id + "\n",
+                  "spectator watches through router");
+            spectators.push_back(fd);
+        }
+        CHECK(router.getSessionCount() == clients.size() + binaryPlayers.size() + spectators.size() + 1,
+              "router counts sessions");
+
+        // The process node takes over its share; sessions follow their rooms
+        CHECK(router.addNode(spare.info, error), "add node to running cluster");
+        members.push_back(spare.info);
+        CHECK(roomsOnOwners(members, ROOM_COUNT), "rooms moved to new owners");
+        CHECK(!roomsOn(spare.info).empty(), "new node received rooms");
+        for (size_t i = 0; i < clients.size(); ++i) {
+            const std::string id = std::to_string(roomIds[i]);
+            CHECK(request(clients[i], "ping") == "ping", "echo after rebalance");
+            // Only a player seated in the room is refused as its spectator
+            CHECK(request(clients[i], "SPECTATE " + id) == "SPECTATE_FAILED " + id + "\n",
+                  "player rejoined its moved room");
+        }
+        CHECK(request(lobby, "hello") == "hello", "lobby session survives rebalance");
+        // Binary players are switched again on their room's new node
+        for (int fd : binaryPlayers) {
+            CHECK(pingPong(fd, 2), "binary player after rebalance");
+        }
+        // The process node ticks on its own, so moved spectators get its frames
+        std::vector<int> movedRooms = roomsOn(spare.info);
+        for (size_t i = 0; i < roomIds.size(); ++i) {
+            if (std::find(movedRooms.begin(), movedRooms.end(), roomIds[i]) != movedRooms.end()) {
+                CHECK(receiveSnapshot(spectators[i]), "spectator follows its moved room");
+            }
+        }
+
+        // Moving is copy, import, drop: the copy alone leaves the room in place
+        ControlClient control;
+        control.setAddress("127.0.0.1", nodes["a"]->info.controlPort);
+        std::vector<int> onA = roomsOn(nodes["a"]->info);
+        CHECK(!onA.empty(), "node a holds rooms");
+        std::string reply;
+        std::string copy;
+        CHECK(control.request("EXPORT " + std::to_string(onA[0]), "", copy) && !copy.empty(), "export a room");
+        CHECK(roomsOn(nodes["a"]->info).size() == onA.size(), "export keeps the room");
+        CHECK(!control.request("DROP 999999", "", reply), "drop of an unknown room fails");
+
+        // A copy left behind by a failed DROP is removed by the next rebalance
+        ControlClient spareControl;
+        spareControl.setAddress("127.0.0.1", spare.info.controlPort);
+        CHECK(spareControl.request("IMPORT", copy, reply) && reply == "1", "stale copy on the process node");
+        CHECK(router.rebalance(), "rebalance");
+        CHECK(roomsOnOwners(members, ROOM_COUNT), "stale copy dropped");
+
+        // Removing a node drains it
+        CHECK(!router.removeNode("nope", error), "unknown node rejected");
+        CHECK(router.removeNode("b", error), "remove node");
+        CHECK(nodes["b"]->server.getRoomIds().empty(), "removed node holds no rooms");
+        std::unique_ptr<TestNode> removed = std::move(nodes["b"]);
+        nodes.erase("b");
+        members.erase(std::remove_if(members.begin(), members.end(),
+                                     [](const ClusterNodeInfo& member) { return member.name == "b"; }),
+                      members.end());
+        CHECK(roomsOnOwners(members, ROOM_COUNT), "rooms preserved after removal");
+        for (int fd : clients) {
+            CHECK(request(fd, "ping") == "ping", "echo after removal");
+        }
+
+        for (int fd : clients) {
+            close(fd);
+        }
+        for (int fd : binaryPlayers) {
+            close(fd);
+        }
+        for (int fd : spectators) {
+            close(fd);
+        }
+        close(lobby);
+        router.stop();
+
+        std::cout << "All Cluster tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,278 @@
+#include "core/GameServer.h"
+#include "core/HotRestart.h"
+#include "protocol/GameProtocol.h"
+#include "utils/Logger.h"
+#include "utils/Metrics.h"
+#include "TestUtil.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+static const int CLIENT_COUNT = 300;
+
+// Old and new "process" are two GameServer instances in this process; the
+// handoff still goes through a real Unix socket and SCM_RIGHTS.
+static int testHandoff(IoBackend backend, int port) {
+    const std::string path = "hotrestart_test.sock";
+    std::string name = GameServer::ioBackendToString(backend);
+
+    GameServer oldServer;
+    oldServer.setIoBackend(backend);
+    oldServer.createRoom("Lobby", CLIENT_COUNT + 1);
+    auto arena = oldServer.createRoom("Arena", 2);
+    arena->addPlayer(std::make_shared<Player>(1000, "Alice"));
+    arena->addPlayer(std::make_shared<Player>(1001, "Bob"));
+    arena->startGame();
+    CHECK(oldServer.initialize(port), name + ": old server initialize");
+    CHECK(oldServer.enableHandoff(path), name + ": handoff socket");
+    std::thread oldThread([&oldServer]() { oldServer.run(); });
+
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENT_COUNT; ++i) {
+        int fd = connectClient(port);
+        CHECK(fd >= 0, name + ": client connect");
+        clients.push_back(fd);
+        CHECK(request(fd, "JOIN 1") == "JOINED 1\n", name + ": client joins lobby");
+    }
+    // One client speaks binary frames and has half of one sent when the sockets move
+    int binaryClient = clients.back();
+    CHECK(request(binaryClient, "BINARY\n") == "BINARY\n", name + ": client switches to binary");
+    protocol::Ping ping;
+    ping.sequence = 7;
+    uint8_t frame[protocol::Ping::MAX_FRAME_SIZE];
+    size_t frameSize = protocol::encodeMessage(ping, frame, sizeof(frame));
+    CHECK(send(binaryClient, frame, 3, 0) == 3, name + ": send start of a frame");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // New server takes everything over; the old loop returns
+    GameServer newServer;
+    newServer.setIoBackend(backend);
+    auto start = std::chrono::steady_clock::now();
+    CHECK(newServer.takeOver(path), name + ": takeover");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    oldThread.join();
+    CHECK(oldServer.hasHandedOff(), name + ": old server reports handoff");
+    std::cout << "  " << name << ": handed off " << CLIENT_COUNT << " connections in "
+              << elapsed << " ms" << std::endl;
+
+    // Rooms, started flags and sessions survive
+    CHECK(newServer.getAllRooms().size() == 2, name + ": rooms restored");
+    CHECK(newServer.getRoom(1)->getPlayerCount() == CLIENT_COUNT, name + ": lobby players restored");
+    CHECK(newServer.getRoom(2)->getIsStarted(), name + ": started flag restored");
+    CHECK(newServer.getRoom(2)->getPlayer(1001)->name == "Bob", name + ": player names restored");
+
+    std::thread newThread([&newServer]() { newServer.run(); });
+
+    // Existing connections keep working without reconnecting
+    for (int fd : clients) {
+        if (fd != binaryClient) {
+            CHECK(request(fd, "ping") == "ping", name + ": echo after handoff");
+        }
+    }
+    // The binary client is still in binary mode and its frame is completed
+    CHECK(send(binaryClient, frame + 3, frameSize - 3, 0) == (ssize_t)(frameSize - 3), name + ": send rest of the frame");
+    std::string answer = receive(binaryClient);
+    protocol::Pong pong;
+    CHECK(protocol::decodeMessage((const uint8_t*)answer.data(), answer.size(), pong) && pong.sequence == 7,
+          name + ": frame split over the handoff answered");
+    // Sessions came along: rejoining the same room is a no-op, not a second seat
+    CHECK(request(clients[0], "JOIN 1") == "JOINED 1\n", name + ": session kept its room");
+    CHECK(newServer.getRoom(1)->getPlayerCount() == CLIENT_COUNT, name + ": no duplicate seat");
+    // And the inherited listener accepts new clients
+    int late = connectClient(port);
+    CHECK(late >= 0 && request(late, "hello") == "hello", name + ": new connection after handoff");
+    clients.push_back(late);
+
+    for (int fd : clients) {
+        close(fd);
+    }
+    newServer.requestShutdown();
+    newThread.join();
+    unlink(path.c_str());
+    return 0;
+}
+
+// A client that stops reading still has output queued when the sockets
+// change owner; the snapshot carries it and the new process sends it
+static int testPendingOutput(IoBackend backend, int port) {
+    const std::string path = "hotrestart_pending.sock";
+    std::string name = GameServer::ioBackendToString(backend);
+    Counter& carried = MetricsRegistry::getInstance().counter("gameserver_handoff_output_bytes_total");
+    uint64_t carriedBefore = carried.value();
+
+    GameServer oldServer;
+    oldServer.setIoBackend(backend);
+    CHECK(oldServer.initialize(port), name + ": pending: old server initialize");
+    CHECK(oldServer.enableHandoff(path), name + ": pending: handoff socket");
+    std::thread oldThread([&oldServer]() { oldServer.run(); });
+
+    // A small receive window before connecting keeps the kernel from
+    // buffering the echo on the client's behalf
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    int window = 4096;
+    setsockopt(client, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(connect(client, (struct sockaddr*)&addr, sizeof(addr)) == 0, name + ": pending: client connect");
+    struct timeval timeout = {2, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Echoed back; more than the server's socket buffer takes while the
+    // client does not read, which is up to tcp_wmem's 4 MB by default
+    std::string sent(16 * 1024 * 1024, 0);
+    for (size_t i = 0; i < sent.size(); ++i) {
+        sent[i] = (char)('a' + i % 26);
+    }
+    for (size_t offset = 0; offset < sent.size(); offset += 4096) {
+        CHECK(send(client, sent.data() + offset, 4096, MSG_NOSIGNAL) == 4096, name + ": pending: send");
+    }
+    // Until the server has read it all, or it would be handed over unread
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    GameServer newServer;
+    newServer.setIoBackend(backend);
+    CHECK(newServer.takeOver(path), name + ": pending: takeover");
+    oldThread.join();
+    CHECK(oldServer.hasHandedOff(), name + ": pending: old server handed off");
+    CHECK(carried.value() > carriedBefore, name + ": pending: output was still queued at the handoff");
+    oldServer.releaseHandoff();
+    CHECK(newServer.waitForHandoffRelease(), name + ": pending: release seen");
+    std::thread newThread([&newServer]() { newServer.run(); });
+
+    window = 1024 * 1024;
+    setsockopt(client, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    std::string echoed;
+    while (echoed.size() < sent.size()) {
+        std::string chunk = receive(client);
+        if (chunk.empty()) {
+            break;
+        }
+        echoed += chunk;
+    }
+    CHECK(echoed.size() == sent.size(), name + ": pending: every byte arrives, got " << echoed.size());
+    CHECK(echoed == sent, name + ": pending: in order, none twice");
+
+    close(client);
+    newServer.requestShutdown();
+    newThread.join();
+    unlink(path.c_str());
+    return 0;
+}
+
+// A drain saves the rooms without the seats of connected clients, and a
+// restart from that state hands out ids past the restored players
+static int testDrainState(int port) {
+    const std::string stateFile = "drain_test.state";
+    std::remove(stateFile.c_str());
+    {
+        GameServer server;
+        server.setStateFile(stateFile);
+        auto lobby = server.createRoom("Lobby", 4);
+        lobby->addPlayer(std::make_shared<Player>(50, "bot"));
+        CHECK(server.initialize(port), "drain: initialize");
+        std::thread serverThread([&server]() { server.run(); });
+        int client = connectClient(port);
+        CHECK(client >= 0 && request(client, "JOIN 1") == "JOINED 1\n", "drain: client joins");
+        CHECK(lobby->getPlayerCount() == 2, "drain: two seats taken");
+        server.requestShutdown();
+        serverThread.join();
+        close(client);
+    }
+
+    std::ifstream file(stateFile);
+    std::stringstream saved;
+    saved << file.rdbuf();
+    CHECK(saved.str().find("player\t1\t50\t") != std::string::npos, "drain: server-side player saved");
+    CHECK(saved.str().find("player\t1\t1\t") == std::string::npos, "drain: client seat not saved");
+
+    GameServer restarted;
+    CHECK(restarted.loadRoomState(stateFile), "drain: state restored");
+    auto lobby = restarted.getRoom(1);
+    CHECK(lobby && lobby->getPlayerCount() == 1 && lobby->getPlayer(50), "drain: no ghost seat");
+    CHECK(restarted.initialize(port), "drain: restarted server initialize");
+    std::thread serverThread([&restarted]() { restarted.run(); });
+    int client = connectClient(port);
+    CHECK(client >= 0 && request(client, "JOIN 1") == "JOINED 1\n", "drain: client joins after restart");
+    CHECK(lobby->getPlayerCount() == 2 && lobby->getPlayer(51), "drain: new session id after the restored ones");
+    close(client);
+    CHECK(waitUntil([&lobby]() { return lobby->getPlayerCount() == 1; }), "drain: disconnect frees the seat");
+    CHECK(lobby->getPlayer(50) != nullptr, "drain: restored player kept");
+    restarted.requestShutdown();
+    serverThread.join();
+    std::remove(stateFile.c_str());
+    return 0;
+}
+
+int main() {
+    std::cout << "Running Hot Restart Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        // Snapshot encoding round trip
+        SnapshotWriter writer;
+        writer.putVarint(0);
+        writer.putVarint(127);
+        writer.putVarint(128);
+        writer.putVarint(~0ULL);
+        writer.putString("room\tname");
+        writer.putString("");
+        CHECK(writer.data().size() == 1 + 1 + 2 + 10 + 10 + 1, "varint sizes");
+
+        SnapshotReader reader(writer.data());
+        uint64_t value;
+        std::string text;
+        CHECK(reader.getVarint(value) && value == 0, "varint 0");
+        CHECK(reader.getVarint(value) && value == 127, "varint 127");
+        CHECK(reader.getVarint(value) && value == 128, "varint 128");
+        CHECK(reader.getVarint(value) && value == ~0ULL, "varint max");
+        CHECK(reader.getString(text) && text == "room\tname", "string");
+        CHECK(reader.getString(text) && text.empty(), "empty string");
+        CHECK(reader.atEnd() && !reader.getVarint(value), "reader stops at the end");
+
+        std::string truncated = writer.data().substr(0, 3);
+        SnapshotReader shortReader(truncated);
+        CHECK(shortReader.getVarint(value) && shortReader.getVarint(value), "prefix readable");
+        CHECK(!shortReader.getVarint(value), "truncated varint rejected");
+
+        // Without a running server there is nothing to take over
+        GameServer orphan;
+        CHECK(!orphan.takeOver("no_such_server.sock"), "takeover without a server fails");
+
+        if (testDrainState(19612) != 0) {
+            return 1;
+        }
+        if (testHandoff(IoBackend::Select, 19610) != 0) {
+            return 1;
+        }
+        if (GameServer::isIoBackendAvailable(IoBackend::IoUring)) {
+            if (testHandoff(IoBackend::IoUring, 19611) != 0 ||
+                testPendingOutput(IoBackend::IoUring, 19613) != 0) {
+                return 1;
+            }
+        }
+
+        std::cout << "All Hot Restart tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,154 @@
+#include "game/LeaderboardService.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reference ranking: sort everything, highest score first, ties by id
+static std::vector<std::pair<int, int64_t>> sortedReference(const std::map<int, int64_t>& scores) {
+    std::vector<std::pair<int, int64_t>> sorted(scores.begin(), scores.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<int, int64_t>& a, const std::pair<int, int64_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return sorted;
+}
+
+int main() {
+    std::cout << "Running Leaderboard Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    const std::string dir = "leaderboard_test";
+    std::filesystem::remove_all(dir);
+
+    try {
+        // Basic ordering, ties and removal
+        Leaderboard board;
+        CHECK(board.setScore(1, 10) == 1, "first entry is rank 1");
+        CHECK(board.setScore(2, 30) == 1, "higher score goes first");
+        CHECK(board.setScore(3, 10) == 3, "tie ranks after the lower id");
+        CHECK(board.getRank(1) == 2 && board.getRank(3) == 3, "ranks after inserts");
+        CHECK(board.addScore(3, 25) == 35 && board.getRank(3) == 1, "addScore moves the player up");
+        CHECK(board.addScore(4, 5) == 5 && board.getRank(4) == 4, "addScore inserts new players");
+        CHECK(board.getRank(99) == 0, "unknown player has no rank");
+        auto top = board.getTop(2);
+        CHECK(top.size() == 2 && top[0].playerId == 3 && top[1].playerId == 2 && top[1].rank == 2, "top 2");
+        CHECK(board.remove(2) && !board.remove(2), "remove once");
+        CHECK(board.size() == 3 && board.getRank(1) == 2, "rank after removal");
+        CHECK(board.getRange(3, 10).size() == 1 && board.getRange(4, 1).empty(), "range past the end");
+
+        // Randomized comparison against a full sort
+        Leaderboard randomBoard;
+        std::map<int, int64_t> reference;
+        std::mt19937 rng(12345);
+        for (int step = 0; step < 20000; ++step) {
+            int playerId = (int)(rng() % 2000) + 1;
+            int op = (int)(rng() % 10);
+            if (op == 0) {
+                randomBoard.remove(playerId);
+                reference.erase(playerId);
+            } else if (op < 5) {
+                int64_t score = (int64_t)(rng() % 200) - 50;
+                randomBoard.setScore(playerId, score);
+                reference[playerId] = score;
+            } else {
+                int64_t delta = (int64_t)(rng() % 21) - 10;
+                randomBoard.addScore(playerId, delta);
+                reference[playerId] += delta;
+            }
+        }
+        auto sorted = sortedReference(reference);
+        CHECK(randomBoard.size() == sorted.size(), "size matches reference");
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            CHECK(randomBoard.getRank(sorted[i].first) == i + 1, "rank matches reference");
+        }
+        auto all = randomBoard.getRange(1, sorted.size());
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            CHECK(all[i].playerId == sorted[i].first && all[i].score == sorted[i].second && all[i].rank == i + 1,
+                  "range matches reference");
+        }
+        auto middle = randomBoard.getRange(500, 25);
+        CHECK(middle.size() == 25 && middle[0].playerId == sorted[499].first, "range from the middle");
+        auto around = randomBoard.getAround(sorted[1].first, 3);
+        CHECK(around.size() == 5 && around[0].rank == 1 && around[1].playerId == sorted[1].first,
+              "around clamps at the top");
+
+        // Snapshot round trip
+        std::string snapshot = randomBoard.serialize();
+        Leaderboard restored;
+        CHECK(restored.load(snapshot), "snapshot loads");
+        CHECK(restored.size() == sorted.size(), "restored size");
+        CHECK(restored.getRank(sorted[100].first) == 101, "restored rank");
+        CHECK(!restored.load(snapshot.substr(0, snapshot.size() - 1)), "truncated snapshot rejected");
+        CHECK(restored.size() == sorted.size(), "rejected snapshot leaves board untouched");
+
+        // Boards per mode and season, snapshotted and reloaded
+        {
+            LeaderboardService service;
+            service.setSnapshotDirectory(dir);
+            CHECK(service.start(), "service start");
+            CHECK(service.getBoard("ranked", "../x") == nullptr, "invalid season rejected");
+            Leaderboard* ranked = service.getBoard("ranked", "s1");
+            Leaderboard* casual = service.getBoard("casual", "s1");
+            CHECK(ranked && casual && ranked != casual, "separate boards");
+            CHECK(service.getBoard("ranked", "s1") == ranked, "board reused");
+            CHECK(service.findBoard("ranked", "s2") == nullptr, "find does not create");
+            for (int i = 1; i <= 1000; ++i) {
+                ranked->setScore(i, i * 7 % 113);
+            }
+            casual->addScore(5, 1);
+            CHECK(service.snapshotNow() == 2, "both boards written");
+            CHECK(service.snapshotNow() == 0, "unchanged boards skipped");
+            casual->addScore(5, 1);
+            CHECK(service.snapshotNow() == 1, "changed board written");
+            ranked->setScore(1, 500);
+            service.stop();
+        }
+        {
+            LeaderboardService service;
+            service.setSnapshotDirectory(dir);
+            CHECK(service.start(), "service restart");
+            CHECK(service.getBoardNames().size() == 2, "boards reloaded");
+            Leaderboard* ranked = service.findBoard("ranked", "s1");
+            int64_t score = 0;
+            CHECK(ranked && ranked->size() == 1000 && ranked->getRank(1) == 1, "final snapshot written on stop");
+            CHECK(service.findBoard("casual", "s1")->getScore(5, score) && score == 2, "casual board reloaded");
+            CHECK(service.snapshotNow() == 0, "reloaded boards are clean");
+            service.stop();
+        }
+
+        // Concurrent updates and queries
+        Leaderboard shared;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&shared, t]() {
+                for (int i = 0; i < 5000; ++i) {
+                    shared.addScore(t * 10000 + i % 500, 1);
+                    shared.getTop(10);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        int64_t score = 0;
+        CHECK(shared.size() == 2000 && shared.getScore(0, score) && score == 10, "concurrent updates");
+
+        std::filesystem::remove_all(dir);
+        std::cout << "All Leaderboard tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,161 @@
+#include "core/GameServer.h"
+#include "game/LeaderboardService.h"
+#include "game/MatchResult.h"
+#include "game/Room.h"
+#include "persistence/WriteBehindStore.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static const int PORT = 19660;
+static const std::string DIR = "match_test";
+
+static std::unique_ptr<WriteBehindStore> openStore() {
+    std::unique_ptr<WriteBehindStore> store(
+        new WriteBehindStore(createStorageBackend("file", DIR), DIR + "/journal"));
+    if (!store->start()) {
+        return nullptr;
+    }
+    return store;
+}
+
+static bool readStats(WriteBehindStore& store, int playerId, PlayerStats& stats) {
+    std::string stored;
+    return store.getBackend().read(PlayerStats::key(playerId), stored) && PlayerStats::parse(stored, stats);
+}
+
+// Two clients play a game until one of them leaves; the main loop ends it and
+// the result reaches the store and the leaderboard the clients query
+static int testGameEnd(WriteBehindStore& store, LeaderboardService& leaderboards) {
+    GameServer server;
+    server.setPersistence(&store);
+    server.setLeaderboards(&leaderboards, "1");
+    auto arena = server.createRoom("Arena", 2);
+    CHECK(server.initialize(PORT), "initialize");
+    std::thread serverThread([&server]() { server.run(); });
+
+    int winner = connectClient(PORT);
+    int loser = connectClient(PORT);
+    CHECK(winner >= 0 && loser >= 0, "connect");
+    CHECK(request(winner, "JOIN 1") == "JOINED 1\n", "first player joins");
+    CHECK(request(loser, "JOIN 1") == "JOINED 1\n", "second player joins");
+    auto players = arena->getPlayers();
+    CHECK(players.size() == 2, "both seated");
+    int winnerId = players[0]->id;
+    int loserId = players[1]->id;
+    arena->startGame();
+    CHECK(arena->getIsStarted(), "game started");
+
+    // Nothing ends a game with two players in it
+    server.HandleGameLogic();
+    CHECK(arena->getIsStarted(), "game keeps running");
+
+    close(loser);
+    CHECK(waitUntil([&arena]() { return arena->getPlayerCount() == 1; }), "leaver removed");
+    server.HandleGameLogic();
+    CHECK(!arena->getIsStarted(), "game over once one player is left");
+    CHECK(arena->getPlayerCount() == 1, "the winner keeps the seat");
+
+    CHECK(store.flush(), "flush");
+    PlayerStats stats;
+    CHECK(readStats(store, winnerId, stats), "winner stats stored");
+    CHECK(stats.gamesPlayed == 1 && stats.wins == 1, "winner: one game, one win");
+    CHECK(stats.name == "player" + std::to_string(winnerId), "winner name");
+    CHECK(readStats(store, loserId, stats), "leaver stats stored");
+    CHECK(stats.gamesPlayed == 1 && stats.wins == 0, "leaver: one game, no win");
+
+    std::vector<MatchResult> matches;
+    store.getBackend().scan("match/", [&matches](const std::string&, const std::string& value) {
+        MatchResult match;
+        if (MatchResult::parse(value, match)) {
+            matches.push_back(match);
+        }
+    });
+    CHECK(matches.size() == 1, "one match recorded");
+    CHECK(matches[0].roomId == 1 && matches[0].winnerId == winnerId && matches[0].playerIds.size() == 2,
+          "match lists the room, the winner and both players");
+
+    Leaderboard* board = leaderboards.findBoard("standard", "1");
+    int64_t score = -1;
+    CHECK(board && board->getScore(winnerId, score) && score == 1, "winner on the board");
+    CHECK(board->getScore(loserId, score) && score == 0, "leaver on the board");
+
+    // Clients query the same board
+    std::string expectedTop = "TOP " + std::to_string(winnerId) + ":1 " + std::to_string(loserId) + ":0\n";
+    CHECK(request(winner, "TOP 10") == expectedTop, "TOP lists both players, winner first");
+    CHECK(request(winner, "TOP 1") == "TOP " + std::to_string(winnerId) + ":1\n", "TOP 1 lists the winner");
+    CHECK(request(winner, "RANK") == "RANK 1 1\n", "winner ranks first with one win");
+    CHECK(request(winner, "RANK\n") == "RANK 1 1\n", "RANK with a line ending");
+    CHECK(request(winner, "RANKING") == "RANKING", "other words starting with RANK are not the command");
+
+    close(winner);
+    server.requestShutdown();
+    serverThread.join();
+    return 0;
+}
+
+// Ids are not handed out again by a server restarted on the same store
+static int testIdsSurviveRestart(WriteBehindStore& store) {
+    GameServer server;
+    server.setPersistence(&store);
+    auto lobby = server.createRoom("Lobby", 4);
+    CHECK(server.initialize(PORT), "restart: initialize");
+    std::thread serverThread([&server]() { server.run(); });
+
+    int client = connectClient(PORT);
+    CHECK(client >= 0 && request(client, "JOIN 1") == "JOINED 1\n", "restart: client joins");
+    CHECK(lobby->getPlayerCount() == 1 && lobby->getPlayers()[0]->id > 2, "restart: new id, not 1 or 2");
+    PlayerStats stats;
+    CHECK(!readStats(store, lobby->getPlayers()[0]->id, stats), "restart: no stats inherited");
+
+    close(client);
+    server.requestShutdown();
+    serverThread.join();
+    return 0;
+}
+
+int main() {
+    std::cout << "Running Match Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+    std::filesystem::remove_all(DIR);
+
+    try {
+        {
+            auto store = openStore();
+            CHECK(store, "store opens");
+            LeaderboardService leaderboards;
+            CHECK(leaderboards.start(), "leaderboards start");
+            if (testGameEnd(*store, leaderboards) != 0) {
+                return 1;
+            }
+            leaderboards.stop();
+            store->stop();
+        }
+        {
+            auto store = openStore();
+            CHECK(store, "store reopens");
+            if (testIdsSurviveRestart(*store) != 0) {
+                return 1;
+            }
+            store->stop();
+        }
+        std::filesystem::remove_all(DIR);
+
+        std::cout << "All Match tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,117 @@
+#include "utils/Metrics.h"
+#include "utils/MetricsExporter.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+static std::string httpGet(int port, const std::string& path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return "";
+    }
+    std::string request = "GET " + path + " HTTP/1.0\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, n);
+    }
+    close(fd);
+    return response;
+}
+
+int main() {
+    std::cout << "Running Metrics Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        auto& registry = MetricsRegistry::getInstance();
+
+        // Counters merge per-thread shards on read
+        Counter& counter = registry.counter("test_events_total", "Events seen by the test");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&counter]() {
+                for (int i = 0; i < 10000; ++i) {
+                    counter.inc();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CHECK(counter.value() == 80000, "counter total across threads");
+        CHECK(&registry.counter("test_events_total") == &counter, "registry returns the same counter");
+
+        // Gauges
+        Gauge& gauge = registry.gauge("test_queue_depth");
+        gauge.set(10);
+        gauge.add(5);
+        gauge.sub(3);
+        CHECK(gauge.value() == 12, "gauge set/add/sub");
+
+        // Histogram buckets are contiguous and bounded
+        for (uint64_t v = 0; v < 100000; v += 7) {
+            size_t index = Histogram::bucketIndex(v);
+            CHECK(Histogram::bucketUpperBound(index) >= v, "bucket upper bound covers value");
+            CHECK(index == 0 || Histogram::bucketUpperBound(index - 1) < v, "value lands in first fitting bucket");
+        }
+        CHECK(Histogram::bucketIndex(~0ULL) == Histogram::BUCKET_COUNT - 1, "huge values clamp to last bucket");
+
+        // Percentiles stay within the bucket error
+        Histogram& histogram = registry.histogram("test_latency_us", "Test latency");
+        for (uint64_t v = 1; v <= 10000; ++v) {
+            histogram.record(v);
+        }
+        HistogramSnapshot snap = histogram.snapshot();
+        CHECK(snap.count == 10000, "histogram count");
+        CHECK(snap.max == 10000, "histogram max");
+        uint64_t p50 = snap.percentile(0.50);
+        uint64_t p99 = snap.percentile(0.99);
+        CHECK(p50 >= 5000 && p50 <= 5000 * 107 / 100, "p50 within bucket error");
+        CHECK(p99 >= 9900 && p99 <= 10000, "p99 within bucket error");
+
+        // Prometheus text output
+        std::string text = registry.renderPrometheus();
+        CHECK(text.find("# TYPE test_events_total counter") != std::string::npos, "counter TYPE line");
+        CHECK(text.find("test_events_total 80000") != std::string::npos, "counter sample");
+        CHECK(text.find("test_queue_depth 12") != std::string::npos, "gauge sample");
+        CHECK(text.find("test_latency_us_count 10000") != std::string::npos, "summary count");
+        CHECK(text.find("test_latency_us{quantile=\"0.99\"}") != std::string::npos, "summary quantile");
+
+        // HTTP endpoint on an ephemeral loopback port
+        MetricsExporter exporter;
+        CHECK(exporter.start(0), "exporter start");
+        std::string response = httpGet(exporter.getPort(), "/metrics");
+        CHECK(response.find("200 OK") != std::string::npos, "endpoint status");
+        CHECK(response.find("test_events_total 80000") != std::string::npos, "endpoint body");
+        CHECK(httpGet(exporter.getPort(), "/nope").find("404") != std::string::npos, "unknown path 404");
+        exporter.stop();
+
+        std::cout << "All Metrics tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
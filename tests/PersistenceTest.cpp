@@ -0,0 +1,226 @@
+#include "persistence/FileStore.h"
+#include "persistence/WriteBehindStore.h"
+#include "game/MatchResult.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counts batches; can be told to fail to simulate a crash before storage
+class CountingStore : public MemoryStore {
+public:
+    CountingStore() : batches(0), records(0), failing(false) {}
+
+    bool writeBatch(const std::vector<StorageRecord>& batch) override {
+        if (failing) {
+            return false;
+        }
+        batches++;
+        records += batch.size();
+        return MemoryStore::writeBatch(batch);
+    }
+
+    std::atomic<int> batches;
+    std::atomic<size_t> records;
+    std::atomic<bool> failing;
+};
+
+static void appendRaw(const std::string& path, const std::string& bytes) {
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+}
+
+int main() {
+    std::cout << "Running Persistence Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    const std::string dir = "persistence_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    try {
+        // Record framing stops at a torn or corrupt tail
+        std::string encoded;
+        encodeStorageRecord(encoded, StorageRecord{"a", "1", false});
+        encodeStorageRecord(encoded, StorageRecord{"b", "", true});
+        size_t whole = encoded.size();
+        encodeStorageRecord(encoded, StorageRecord{"c", "333", false});
+        std::string torn = encoded.substr(0, encoded.size() - 2);
+        std::vector<StorageRecord> decoded;
+        auto collect = [&decoded](StorageRecord& record) { decoded.push_back(record); };
+        CHECK(decodeStorageRecords(encoded, collect) == encoded.size() && decoded.size() == 3, "decode all");
+        CHECK(decoded[1].key == "b" && decoded[1].erased, "erase flag");
+        decoded.clear();
+        CHECK(decodeStorageRecords(torn, collect) == whole && decoded.size() == 2, "torn tail dropped");
+        std::string corrupt = encoded;
+        corrupt[whole + 14] ^= 0x40;
+        decoded.clear();
+        CHECK(decodeStorageRecords(corrupt, collect) == whole, "checksum mismatch stops decoding");
+
+        // File store survives reopen, drops torn tails and compacts
+        const std::string storePath = dir + "/store.db";
+        {
+            FileStore store(storePath);
+            CHECK(store.open(), "file store open");
+            CHECK(store.writeBatch({{"player/1", "alice", false}, {"player/2", "bob", false}}), "batch write");
+            CHECK(store.writeBatch({{"player/2", "", true}, {"player/3", "carol", false}}), "second batch");
+            store.close();
+        }
+        appendRaw(storePath, torn.substr(whole));
+        {
+            FileStore store(storePath);
+            CHECK(store.open(), "file store reopen");
+            std::string value;
+            CHECK(store.read("player/1", value) && value == "alice", "value survives reopen");
+            CHECK(!store.read("player/2", value), "erase survives reopen");
+            CHECK(store.getKeyCount() == 2, "key count after reopen");
+            std::vector<std::string> keys;
+            store.scan("player/", [&keys](const std::string& key, const std::string&) { keys.push_back(key); });
+            CHECK(keys.size() == 2 && keys[0] == "player/1" && keys[1] == "player/3", "prefix scan in order");
+
+            // Overwrite one key many times, then compact, while another
+            // thread keeps reading through the syncs and compactions
+            std::string big(1000, 'x');
+            std::atomic<bool> writing(true);
+            std::atomic<int> reads(0);
+            std::atomic<bool> readsValid(true);
+            std::thread reader([&]() {
+                std::string seen;
+                while (writing) {
+                    if (!store.read("player/1", seen) || seen != "alice") {
+                        readsValid = false;
+                    }
+                    reads++;
+                }
+            });
+            for (int i = 0; i < 1500; ++i) {
+                CHECK(store.writeBatch({{"hot", big + std::to_string(i), false}}), "overwrite");
+            }
+            writing = false;
+            reader.join();
+            CHECK(readsValid && reads > 0, "reads during writes and compaction");
+            CHECK(store.getFileSize() < 1024 * 1024 + 2048, "automatic compaction bounds the file");
+            CHECK(store.compact(), "explicit compaction");
+            CHECK(store.read("hot", value) && value == big + "1499", "latest value after compaction");
+            store.close();
+        }
+        CHECK(std::filesystem::file_size(storePath) < 2000, "compacted file holds live records only");
+
+        // Write-behind coalesces repeated updates to one key
+        {
+            CountingStore* backend = new CountingStore();
+            WriteBehindStore store(std::unique_ptr<StorageBackend>(backend), dir + "/coalesce/journal");
+            store.setFlushInterval(std::chrono::milliseconds(1000));
+            CHECK(store.start(), "write-behind start");
+            for (int i = 0; i < 1000; ++i) {
+                CHECK(store.put("player/7", std::to_string(i)), "put acknowledged");
+            }
+            CHECK(store.put("player/8", "x") && store.erase("player/8"), "erase queued");
+            std::string value;
+            CHECK(store.get("player/7", value) && value == "999", "read sees queued update");
+            CHECK(!store.get("player/8", value), "read sees queued erase");
+            CHECK(backend->records == 0, "nothing written before the flush");
+            CHECK(store.flush(), "flush");
+            CHECK(backend->batches == 1 && backend->records == 2, "1001 updates coalesced into 2 records");
+            CHECK(backend->read("player/7", value) && value == "999", "latest value stored");
+            store.stop();
+            CHECK(std::filesystem::is_empty(dir + "/coalesce"), "journal segments removed once stored");
+        }
+
+        // Many writers, batches bounded by size
+        {
+            CountingStore* backend = new CountingStore();
+            WriteBehindStore store(std::unique_ptr<StorageBackend>(backend), dir + "/threads/journal");
+            store.setMaxBatchSize(64);
+            CHECK(store.start(), "threaded store start");
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&store, t]() {
+                    for (int i = 0; i < 500; ++i) {
+                        store.put("k/" + std::to_string(t) + "/" + std::to_string(i), "v");
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            store.stop();
+            std::vector<std::string> keys;
+            backend->scan("k/", [&keys](const std::string& key, const std::string&) { keys.push_back(key); });
+            CHECK(keys.size() == 2000, "every key stored on stop");
+        }
+
+        // Crash recovery: acknowledged updates the backend never got are
+        // replayed from the journal by the next process
+        const std::string journal = dir + "/crash/journal";
+        {
+            CountingStore* backend = new CountingStore();
+            backend->failing = true;
+            WriteBehindStore store(std::unique_ptr<StorageBackend>(backend), journal);
+            store.setFlushInterval(std::chrono::milliseconds(10));
+            CHECK(store.start(), "crashing store start");
+            CHECK(store.put("player/1", "before crash"), "update acknowledged");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            CHECK(store.put("player/2", "also acknowledged"), "second update acknowledged");
+            store.stop();
+            CHECK(backend->records == 0, "backend never received the updates");
+        }
+        // Half-written update from the moment of the crash
+        auto segments = std::filesystem::directory_iterator(dir + "/crash");
+        std::string lastSegment;
+        for (const auto& entry : segments) {
+            lastSegment = std::max(lastSegment, entry.path().string());
+        }
+        CHECK(!lastSegment.empty(), "journal left behind");
+        appendRaw(lastSegment, torn.substr(whole));
+        {
+            WriteBehindStore store(std::unique_ptr<StorageBackend>(new FileStore(dir + "/crash/store.db")),
+                                   journal);
+            CHECK(store.start(), "recovering store start");
+            std::string value;
+            CHECK(store.getBackend().read("player/1", value) && value == "before crash", "first update recovered");
+            CHECK(store.getBackend().read("player/2", value) && value == "also acknowledged",
+                  "second update recovered");
+            CHECK(!store.getBackend().read("c", value), "torn update ignored");
+            store.stop();
+        }
+
+        // Game records
+        PlayerStats stats;
+        stats.name = "Alice Smith";
+        stats.gamesPlayed = 12;
+        stats.wins = 5;
+        PlayerStats parsedStats;
+        CHECK(PlayerStats::parse(stats.serialize(), parsedStats), "player stats parse");
+        CHECK(parsedStats.name == "Alice Smith" && parsedStats.gamesPlayed == 12 && parsedStats.wins == 5,
+              "player stats round trip");
+        MatchResult match;
+        match.roomId = 3;
+        match.roomName = "Battle Room";
+        match.winnerId = 2;
+        match.endedAt = 1700000000123LL;
+        match.playerIds = {1, 2, 5};
+        MatchResult parsedMatch;
+        CHECK(MatchResult::parse(match.serialize(), parsedMatch), "match parse");
+        CHECK(parsedMatch.roomName == "Battle Room" && parsedMatch.playerIds.size() == 3 &&
+              parsedMatch.playerIds[2] == 5 && parsedMatch.endedAt == match.endedAt, "match round trip");
+        CHECK(match.key() == "match/001700000000123-3", "match key sorts by time");
+
+        std::filesystem::remove_all(dir);
+        std::cout << "All Persistence tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
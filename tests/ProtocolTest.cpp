@@ -0,0 +1,350 @@
+#include "core/GameServer.h"
+#include "core/RateLimiter.h"
+#include "protocol/GameProtocol.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace protocol;
+
+#ifndef _WIN32
+
+static const int SELECT_PORT = 19670;
+static const int URING_PORT = 19671;
+static const int THROTTLED_SELECT_PORT = 19672;
+static const int THROTTLED_URING_PORT = 19673;
+
+// Reads until data holds count whole frames, then splits them off
+static bool receiveFrames(int fd, size_t count, std::vector<std::string>& frames, std::string& data) {
+    while (frames.size() < count) {
+        size_t size = 0;
+        FrameStatus status = findFrame((const uint8_t*)data.data(), data.size(), MAX_FRAME_SIZE, size);
+        if (status == FrameStatus::Complete) {
+            frames.push_back(data.substr(0, size));
+            data.erase(0, size);
+            continue;
+        }
+        std::string more;
+        if (status == FrameStatus::Invalid || (more = receive(fd)).empty()) {
+            return false;
+        }
+        data += more;
+    }
+    return true;
+}
+
+static std::string pingFrame(uint32_t sequence) {
+    Ping ping;
+    ping.sequence = sequence;
+    ping.clientTimeMs = 1000 + sequence;
+    uint8_t frame[Ping::MAX_FRAME_SIZE];
+    return std::string((const char*)frame, encodeMessage(ping, frame, sizeof(frame)));
+}
+
+static bool isPong(const std::string& frame, uint32_t sequence) {
+    Pong pong;
+    return decodeMessage((const uint8_t*)frame.data(), frame.size(), pong) && pong.sequence == sequence &&
+           pong.clientTimeMs == 1000 + sequence;
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    return send(fd, data.data(), data.size(), MSG_NOSIGNAL) == (ssize_t)data.size();
+}
+
+// Reads bytes until data starts with expected, then splits it off
+static bool receiveText(int fd, const std::string& expected, std::string& data) {
+    while (data.size() < expected.size()) {
+        std::string more = receive(fd);
+        if (more.empty()) {
+            return false;
+        }
+        data += more;
+    }
+    bool match = data.compare(0, expected.size(), expected) == 0;
+    data.erase(0, expected.size());
+    return match;
+}
+
+static bool isError(const std::string& frame, uint8_t messageId, uint32_t code) {
+    ProtocolError error;
+    return decodeMessage((const uint8_t*)frame.data(), frame.size(), error) && error.messageId == messageId &&
+           error.code == code;
+}
+
+// Frames are cut from the stream, not from single reads
+static int testServer(IoBackend backend, int port) {
+    const std::string name = GameServer::ioBackendToString(backend);
+    GameServer server;
+    server.setIoBackend(backend);
+    CHECK(server.initialize(port), name << ": initialize");
+    std::thread serverThread([&server]() { server.run(); });
+
+    int client = connectClient(port);
+    CHECK(client >= 0, name << ": connect");
+    std::vector<std::string> frames;
+    std::string data;
+
+    // Before the switch a read is text, whatever its first byte
+    std::string magicText = std::string(1, (char)FRAME_MAGIC) + "text";
+    CHECK(request(client, magicText) == magicText, name << ": text starting with the magic byte echoed");
+
+    // The switch, then one frame over several reads, down to a lone magic byte
+    std::string ping = pingFrame(1);
+    CHECK(sendAll(client, "BINARY\n" + ping.substr(0, 1)), name << ": switch with a magic byte");
+    CHECK(receiveText(client, "BINARY\n", data), name << ": switch acknowledged");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(sendAll(client, ping.substr(1, 2)), name << ": send id and length");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(sendAll(client, ping.substr(3)), name << ": send fields");
+    CHECK(receiveFrames(client, 1, frames, data) && isPong(frames[0], 1), name << ": split frame answered");
+
+    // Several frames and the start of another in one read
+    std::string third = pingFrame(4);
+    CHECK(sendAll(client, pingFrame(2) + pingFrame(3) + third.substr(0, 3)), name << ": send batch");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(sendAll(client, third.substr(3)), name << ": send the rest");
+    CHECK(receiveFrames(client, 4, frames, data) && isPong(frames[1], 2) && isPong(frames[2], 3) &&
+          isPong(frames[3], 4) && data.empty(), name << ": every frame answered in order");
+
+    // Text is not a frame any more
+    CHECK(sendAll(client, "hello"), name << ": send text in binary mode");
+    CHECK(receiveFrames(client, 5, frames, data) && isError(frames[4], 0, 1), name << ": text reported");
+
+    // A corrupt length is a protocol error; what was buffered goes, the next frame is served
+    std::string corrupt = {(char)FRAME_MAGIC, (char)Ping::MESSAGE_ID};
+    corrupt.append(11, (char)0xff);
+    CHECK(sendAll(client, corrupt), name << ": send corrupt length");
+    CHECK(receiveFrames(client, 6, frames, data) && isError(frames[5], Ping::MESSAGE_ID, 2),
+          name << ": malformed frame reported");
+    CHECK(sendAll(client, pingFrame(5)), name << ": send after the error");
+    CHECK(receiveFrames(client, 7, frames, data) && isPong(frames[6], 5), name << ": frame after the error");
+
+    close(client);
+    server.requestShutdown();
+    serverThread.join();
+    return 0;
+}
+
+// Reads over a rate limit are held back, not dropped: every frame is answered
+static int testThrottledServer(IoBackend backend, int port) {
+    const std::string name = GameServer::ioBackendToString(backend) + " throttled";
+    RateLimitConfig config;
+    config.messagesPerConnection = {50, 2};
+    config.maxStrikes = 1000;
+    config.limitLoopback = true;
+    GameServer server;
+    server.setIoBackend(backend);
+    server.setRateLimits(config);
+    CHECK(server.initialize(port), name << ": initialize");
+    std::thread serverThread([&server]() { server.run(); });
+
+    int client = connectClient(port);
+    CHECK(client >= 0, name << ": connect");
+    CHECK(request(client, "BINARY") == "BINARY\n", name << ": switch to binary");
+    const uint32_t count = 12;
+    for (uint32_t i = 1; i <= count; ++i) {
+        // Half frames, so a lost read would break the stream
+        std::string ping = pingFrame(i);
+        CHECK(sendAll(client, ping.substr(0, 4)), name << ": send frame start");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        CHECK(sendAll(client, ping.substr(4)), name << ": send frame end");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::vector<std::string> frames;
+    std::string data;
+    CHECK(receiveFrames(client, count, frames, data), name << ": every frame answered");
+    for (uint32_t i = 1; i <= count; ++i) {
+        CHECK(isPong(frames[i - 1], i), name << ": answered in order");
+    }
+
+    close(client);
+    server.requestShutdown();
+    serverThread.join();
+    return 0;
+}
+
+#endif // _WIN32
+
+int main() {
+    std::cout << "Running Protocol Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        uint8_t buffer[MAX_FRAME_SIZE];
+
+        // Varints and zigzag at the edges
+        {
+            WireWriter writer(buffer, sizeof(buffer));
+            writer.putVarint(0);
+            writer.putVarint(127);
+            writer.putVarint(128);
+            writer.putVarint(std::numeric_limits<uint64_t>::max());
+            writer.putZigZag(-1);
+            writer.putZigZag(std::numeric_limits<int32_t>::min());
+            writer.putZigZag(std::numeric_limits<int64_t>::max());
+            CHECK(writer.ok() && writer.size() == 1 + 1 + 2 + 10 + 1 + 5 + 10, "varint sizes");
+
+            WireReader reader(buffer, writer.size());
+            uint32_t small;
+            uint64_t large;
+            int32_t signed32;
+            int64_t signed64;
+            CHECK(reader.getVarint(small) && small == 0, "varint 0");
+            CHECK(reader.getVarint(small) && small == 127, "varint 127");
+            CHECK(reader.getVarint(small) && small == 128, "varint 128");
+            CHECK(reader.getVarint(large) && large == std::numeric_limits<uint64_t>::max(), "varint max");
+            CHECK(reader.getZigZag(signed32) && signed32 == -1, "zigzag -1");
+            CHECK(reader.getZigZag(signed32) && signed32 == std::numeric_limits<int32_t>::min(), "zigzag int32 min");
+            CHECK(reader.getZigZag(signed64) && signed64 == std::numeric_limits<int64_t>::max(), "zigzag int64 max");
+            CHECK(reader.atEnd(), "reader at end");
+
+            WireReader overflow(buffer + 4, 10);
+            CHECK(!overflow.getVarint(small), "64-bit value rejected as uint32");
+        }
+
+        // Round trip with bit-packed fields
+        PlayerInput input;
+        input.tick = 123456;
+        input.moveUp = true;
+        input.moveRight = true;
+        input.jump = true;
+        input.aim = 1023;
+        input.weapon = 9;
+        size_t size = encodeMessage(input, buffer, sizeof(buffer));
+        // magic + id + length, 3-byte varint tick, 6 bools + 10 + 4 bits in 3 bytes
+        CHECK(size == 3 + 3 + 3, "player input is 9 bytes");
+        CHECK(buffer[2] == 6, "length prefix counts the fields");
+        CHECK(peekMessageId(buffer, size) == PlayerInput::MESSAGE_ID, "frame id");
+        PlayerInput decoded;
+        CHECK(decodeMessage(buffer, size, decoded), "decode player input");
+        CHECK(decoded.tick == 123456 && decoded.moveUp && !decoded.moveDown && !decoded.moveLeft &&
+              decoded.moveRight && !decoded.fire && decoded.jump && decoded.aim == 1023 && decoded.weapon == 9,
+              "player input fields");
+        CHECK(!decodeMessage(buffer, size - 1, decoded), "truncated frame rejected");
+        buffer[2] = 5;
+        CHECK(!decodeMessage(buffer, size, decoded), "length prefix must match the fields");
+        buffer[2] = 6;
+        Ping wrongType;
+        CHECK(!decodeMessage(buffer, size, wrongType), "wrong message id rejected");
+
+        // Nested structs in a fixed-capacity array
+        Snapshot snapshot;
+        snapshot.tick = 77;
+        snapshot.lastInputTick = 76;
+        for (uint32_t i = 0; i < 20; ++i) {
+            EntityState entity;
+            entity.entityId = i + 1;
+            entity.position.x = -(int32_t)i * 150;
+            entity.position.y = (int32_t)i * 300;
+            entity.velocity.x = 12;
+            entity.health = 100 - i;
+            entity.animation = i % 8;
+            entity.alive = i % 3 != 0;
+            CHECK(snapshot.entities.push_back(entity), "entity fits");
+        }
+        size = encodeMessage(snapshot, buffer, sizeof(buffer));
+        CHECK(size > 0 && size <= Snapshot::MAX_FRAME_SIZE, "snapshot encodes");
+        Snapshot decodedSnapshot;
+        CHECK(decodeMessage(buffer, size, decodedSnapshot), "decode snapshot");
+        CHECK(decodedSnapshot.tick == 77 && decodedSnapshot.entities.size() == 20, "snapshot header");
+        for (uint32_t i = 0; i < 20; ++i) {
+            const EntityState& entity = decodedSnapshot.entities[i];
+            CHECK(entity.entityId == i + 1 && entity.position.x == -(int32_t)i * 150 &&
+                  entity.position.y == (int32_t)i * 300 && entity.velocity.x == 12 && entity.velocity.y == 0 &&
+                  entity.health == 100 - i && entity.animation == i % 8 && entity.alive == (i % 3 != 0),
+                  "snapshot entity fields");
+        }
+        CHECK(isValidFrame(buffer, size), "snapshot frame is valid");
+
+        // A full snapshot fits MAX_FRAME_SIZE; one byte less does not
+        Snapshot full;
+        EntityState extreme;
+        extreme.entityId = std::numeric_limits<uint32_t>::max();
+        extreme.position.x = std::numeric_limits<int32_t>::min();
+        extreme.position.y = std::numeric_limits<int32_t>::min();
+        extreme.velocity = extreme.position;
+        while (full.entities.push_back(extreme)) {
+        }
+        full.tick = full.lastInputTick = std::numeric_limits<uint32_t>::max();
+        CHECK(encodeMessage(full, buffer, sizeof(buffer)) == Snapshot::MAX_FRAME_SIZE, "max frame size is exact");
+        CHECK(encodeMessage(full, buffer, Snapshot::MAX_FRAME_SIZE - 1) == 0, "short buffer reported");
+
+        // Strings and hostile counts
+        Chat chat;
+        CHECK(chat.text.assign("gg wp"), "string fits");
+        CHECK(!chat.text.assign(std::string(141, 'x').c_str()), "string over capacity rejected");
+        chat.playerId = 42;
+        size = encodeMessage(chat, buffer, sizeof(buffer));
+        Chat decodedChat;
+        CHECK(decodeMessage(buffer, size, decodedChat) && decodedChat.text == chat.text &&
+              decodedChat.playerId == 42, "chat round trip");
+
+        uint8_t hostile[] = {FRAME_MAGIC, Chat::MESSAGE_ID, 4, 1, 200, 1, 'x'};
+        CHECK(!decodeMessage(hostile, sizeof(hostile), decodedChat), "string length over capacity rejected");
+        uint8_t tooMany[] = {FRAME_MAGIC, Snapshot::MESSAGE_ID, 4, 1, 1, 65, 0};
+        CHECK(!decodeMessage(tooMany, sizeof(tooMany), decodedSnapshot), "array count over capacity rejected");
+        uint8_t trailing[] = {FRAME_MAGIC, Ping::MESSAGE_ID, 2, 1, 2, 0};
+        Ping ping;
+        CHECK(!decodeMessage(trailing, sizeof(trailing), ping), "trailing bytes rejected");
+        CHECK(decodeMessage(trailing, sizeof(trailing) - 1, ping) && ping.sequence == 1 && ping.clientTimeMs == 2,
+              "ping decodes");
+
+        // Frames cut from a stream
+        size = encodeMessage(chat, buffer, sizeof(buffer));
+        size_t second = encodeMessage(input, buffer + size, sizeof(buffer) - size);
+        size_t found = 0;
+        CHECK(findFrame(buffer, 0, MAX_FRAME_SIZE, found) == FrameStatus::Incomplete, "empty stream");
+        CHECK(findFrame(buffer, 2, MAX_FRAME_SIZE, found) == FrameStatus::Incomplete, "header without length");
+        CHECK(findFrame(buffer, size - 1, MAX_FRAME_SIZE, found) == FrameStatus::Incomplete, "partial frame");
+        CHECK(findFrame(buffer, size + second, MAX_FRAME_SIZE, found) == FrameStatus::Complete && found == size,
+              "first of two frames");
+        CHECK(findFrame(buffer + size, second, MAX_FRAME_SIZE, found) == FrameStatus::Complete && found == second,
+              "second frame");
+        CHECK(findFrame((const uint8_t*)"JOIN 1", 6, MAX_FRAME_SIZE, found) == FrameStatus::Invalid,
+              "text is not a frame");
+        uint8_t huge[] = {FRAME_MAGIC, Chat::MESSAGE_ID, 0xff, 0xff, 0x7f};
+        CHECK(findFrame(huge, sizeof(huge), MAX_FRAME_SIZE, found) == FrameStatus::Invalid, "length over the maximum");
+        uint8_t endless[] = {FRAME_MAGIC, Chat::MESSAGE_ID, 0xff, 0xff, 0xff, 0xff};
+        CHECK(findFrame(endless, 3, MAX_FRAME_SIZE, found) == FrameStatus::Incomplete, "length still arriving");
+        CHECK(findFrame(endless, sizeof(endless), MAX_FRAME_SIZE, found) == FrameStatus::Invalid,
+              "unterminated length");
+
+        // Unknown ids and text
+        uint8_t unknown[] = {FRAME_MAGIC, 100, 0};
+        CHECK(!isValidFrame(unknown, sizeof(unknown)) && messageName(100) == nullptr, "unknown id");
+        CHECK(std::string(messageName(Pong::MESSAGE_ID)) == "Pong", "message names");
+        CHECK(peekMessageId((const uint8_t*)"JOIN 1", 6) == 0, "text is not a frame");
+
+#ifndef _WIN32
+        if (testServer(IoBackend::Select, SELECT_PORT) != 0) {
+            return 1;
+        }
+        if (GameServer::isIoBackendAvailable(IoBackend::IoUring) && testServer(IoBackend::IoUring, URING_PORT) != 0) {
+            return 1;
+        }
+        if (testThrottledServer(IoBackend::Select, THROTTLED_SELECT_PORT) != 0) {
+            return 1;
+        }
+        if (GameServer::isIoBackendAvailable(IoBackend::IoUring) &&
+            testThrottledServer(IoBackend::IoUring, THROTTLED_URING_PORT) != 0) {
+            return 1;
+        }
+#endif
+
+        std::cout << "All Protocol tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
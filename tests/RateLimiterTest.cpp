@@ -0,0 +1,197 @@
+#include "core/RateLimiter.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 10.0.0.0/8 test addresses in host byte order
+static uint32_t ip(uint32_t n) {
+    return (10u << 24) | n;
+}
+
+// Small tables and everything off except what a case turns on
+static RateLimitConfig quietConfig() {
+    RateLimitConfig config;
+    config.acceptsPerIp = {0, 0};
+    config.messagesPerIp = {0, 0};
+    config.bytesPerIp = {0, 0};
+    config.messagesPerConnection = {0, 0};
+    config.bytesPerConnection = {0, 0};
+    config.maxConnectionsPerIp = 1000;
+    config.maxStrikes = 1000000;
+    config.addressSlots = 256;
+    config.connectionSlots = 256;
+    return config;
+}
+
+int main() {
+    std::cout << "Running RateLimiter Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        // Accept burst, then refill at the configured rate
+        {
+            RateLimitConfig config = quietConfig();
+            config.acceptsPerIp = {2, 5};
+            RateLimiter limiter(config);
+            for (int fd = 100; fd < 105; ++fd) {
+                CHECK(limiter.admitConnection(fd, ip(1), 1000), "accept within burst");
+            }
+            CHECK(!limiter.admitConnection(105, ip(1), 1000), "accept over burst rejected");
+            CHECK(limiter.admitConnection(105, ip(2), 1000), "other addresses unaffected");
+            CHECK(limiter.admitConnection(106, ip(1), 1500), "one token after 500 ms at 2/s");
+            CHECK(!limiter.admitConnection(107, ip(1), 1500), "and only one");
+            CHECK(limiter.getTrackedAddresses() == 2 && limiter.getTrackedConnections() == 7, "tracked counts");
+        }
+
+        // Connections per address, released on close
+        {
+            RateLimitConfig config = quietConfig();
+            config.maxConnectionsPerIp = 3;
+            RateLimiter limiter(config);
+            for (int fd = 10; fd < 13; ++fd) {
+                CHECK(limiter.admitConnection(fd, ip(1), 0), "connection under the cap");
+            }
+            CHECK(!limiter.admitConnection(13, ip(1), 0), "connection over the cap rejected");
+            limiter.connectionClosed(11);
+            CHECK(limiter.getTrackedConnections() == 2, "close releases the connection slot");
+            CHECK(limiter.admitConnection(13, ip(1), 0), "close frees room for another");
+            CHECK(!limiter.admitConnection(14, ip(1), 0), "cap holds again");
+        }
+
+        // Per-connection messages: throttled, then a disconnect after maxStrikes
+        {
+            RateLimitConfig config = quietConfig();
+            config.messagesPerConnection = {10, 5};
+            config.maxStrikes = 3;
+            RateLimiter limiter(config);
+            CHECK(limiter.admitConnection(5, ip(1), 0), "admit");
+            for (int i = 0; i < 5; ++i) {
+                CHECK(limiter.admitRead(5, 10, 0) == RateLimiter::Verdict::Allow, "messages within burst");
+            }
+            CHECK(limiter.admitRead(5, 10, 0) == RateLimiter::Verdict::Throttle, "first excess message throttled");
+            CHECK(limiter.admitRead(5, 10, 0) == RateLimiter::Verdict::Throttle, "second excess message throttled");
+            CHECK(limiter.admitRead(5, 10, 100) == RateLimiter::Verdict::Allow, "refilled after 100 ms");
+            CHECK(limiter.admitRead(5, 10, 100) == RateLimiter::Verdict::Throttle, "strikes start over");
+            CHECK(limiter.admitRead(5, 10, 100) == RateLimiter::Verdict::Throttle, "second strike");
+            CHECK(limiter.admitRead(5, 10, 100) == RateLimiter::Verdict::Disconnect, "third strike disconnects");
+            CHECK(limiter.admitRead(99, 10, 100) == RateLimiter::Verdict::Allow, "unknown sockets pass");
+        }
+
+        // Bytes per connection, and per-address budgets shared by its connections
+        {
+            RateLimitConfig config = quietConfig();
+            config.bytesPerConnection = {1000, 2000};
+            config.messagesPerIp = {10, 6};
+            RateLimiter limiter(config);
+            CHECK(limiter.admitConnection(1, ip(1), 0) && limiter.admitConnection(2, ip(1), 0), "admit two");
+            CHECK(limiter.admitRead(1, 1500, 0) == RateLimiter::Verdict::Allow, "bytes within burst");
+            CHECK(limiter.admitRead(1, 1000, 0) == RateLimiter::Verdict::Throttle, "bytes over burst throttled");
+            CHECK(limiter.admitRead(2, 1000, 0) == RateLimiter::Verdict::Allow, "byte budget is per connection");
+            for (int i = 0; i < 3; ++i) {
+                CHECK(limiter.admitRead(2, 1, 0) == RateLimiter::Verdict::Allow, "address messages left");
+            }
+            // 1 + 1 + 3 allowed so far; the throttled read was refused before the address was charged
+            CHECK(limiter.admitRead(1, 1, 0) == RateLimiter::Verdict::Allow, "sixth message for the address");
+            CHECK(limiter.admitRead(1, 1, 0) == RateLimiter::Verdict::Throttle, "address budget used up");
+            CHECK(limiter.admitRead(2, 1, 0) == RateLimiter::Verdict::Throttle, "for every connection");
+        }
+
+        // Loopback is exempt unless asked for
+        {
+            RateLimitConfig config = quietConfig();
+            config.acceptsPerIp = {1, 1};
+            config.messagesPerConnection = {1, 1};
+            RateLimiter exempt(config);
+            uint32_t loopback = (127u << 24) | 1;
+            for (int fd = 0; fd < 100; ++fd) {
+                CHECK(exempt.admitConnection(fd, loopback, 0), "loopback accepts unlimited");
+                CHECK(exempt.admitRead(fd, 100, 0) == RateLimiter::Verdict::Allow, "loopback reads unlimited");
+            }
+            CHECK(exempt.getTrackedAddresses() == 0 && exempt.getTrackedConnections() == 0, "loopback not tracked");
+
+            config.limitLoopback = true;
+            RateLimiter limited(config);
+            CHECK(limited.admitConnection(1, loopback, 0), "loopback within limit");
+            CHECK(!limited.admitConnection(2, loopback, 0), "limitLoopback applies limits");
+        }
+
+        // Many addresses: the table stays at its size, idle slots are reused
+        {
+            RateLimitConfig config = quietConfig();
+            config.acceptsPerIp = {2, 5};
+            config.addressSlots = 64;
+            config.connectionSlots = 64;
+            RateLimiter limiter(config);
+            for (uint32_t n = 1; n <= 10000; ++n) {
+                CHECK(limiter.admitConnection((int)n, ip(n), 1000), "a flood of addresses is still admitted");
+                limiter.connectionClosed((int)n);
+                CHECK(limiter.getTrackedAddresses() <= 64, "address table is bounded");
+            }
+            CHECK(limiter.getTrackedConnections() == 0, "connection slots released");
+
+            // Every slot was touched just now; a new address goes untracked
+            for (int i = 0; i < 10; ++i) {
+                CHECK(limiter.admitConnection(i, ip(20000), 1000), "untracked address admitted");
+                limiter.connectionClosed(i);
+            }
+            // Once the buckets would have refilled, slots are reused and limits apply again
+            for (int i = 0; i < 5; ++i) {
+                CHECK(limiter.admitConnection(i, ip(20001), 10000), "evicted slot reused");
+            }
+            CHECK(!limiter.admitConnection(5, ip(20001), 10000), "reused slot enforces limits");
+        }
+
+        // A socket number reused before its close was seen
+        {
+            RateLimitConfig config = quietConfig();
+            config.maxConnectionsPerIp = 1;
+            RateLimiter limiter(config);
+            CHECK(limiter.admitConnection(7, ip(1), 0), "first owner of fd 7");
+            CHECK(limiter.admitConnection(7, ip(2), 0), "fd 7 from another address");
+            CHECK(limiter.admitConnection(8, ip(1), 0), "stale connection released");
+            CHECK(!limiter.admitConnection(9, ip(2), 0), "new owner counted");
+            CHECK(limiter.getTrackedConnections() == 2, "one slot per socket");
+        }
+
+        // Concurrent reads never hand out more than the bucket holds
+        {
+            RateLimitConfig config = quietConfig();
+            config.messagesPerConnection = {1, 1000};
+            config.messagesPerIp = {1, 2000};
+            RateLimiter limiter(config);
+            const int threads = 4;
+            for (int fd = 0; fd < threads; ++fd) {
+                CHECK(limiter.admitConnection(fd, ip(1), 0), "admit");
+            }
+            std::atomic<int> allowed(0);
+            std::vector<std::thread> workers;
+            for (int fd = 0; fd < threads; ++fd) {
+                workers.emplace_back([&limiter, &allowed, fd]() {
+                    for (int i = 0; i < 10000; ++i) {
+                        if (limiter.admitRead(fd, 1, 0) == RateLimiter::Verdict::Allow) {
+                            ++allowed;
+                        }
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            CHECK(allowed == 2000, "exactly the address burst allowed, got " << allowed.load());
+        }
+
+        std::cout << "All RateLimiter tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
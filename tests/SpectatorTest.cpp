@@ -0,0 +1,275 @@
+#include "core/GameServer.h"
+#include "game/Room.h"
+#include "game/SpectatorStream.h"
+#include "protocol/GameProtocol.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+using Clock = SpectatorStream::Clock;
+using Frame = SpectatorStream::Frame;
+
+static const int SELECT_PORT = 19650;
+static const int URING_PORT = 19651;
+
+static Frame makeFrame(const std::string& text) {
+    return std::make_shared<const std::string>(text);
+}
+
+// Reads until count Snapshot frames have arrived, however the stream splits
+// them; false on a timeout or anything that is not a Snapshot. reads counts
+// the recv() calls it took.
+static bool receiveSnapshots(int fd, size_t count, std::vector<protocol::Snapshot>& snapshots, int& reads) {
+    std::string data;
+    snapshots.clear();
+    reads = 0;
+    while (snapshots.size() < count) {
+        size_t size = 0;
+        protocol::FrameStatus status = protocol::findFrame((const uint8_t*)data.data(), data.size(),
+                                                           protocol::MAX_FRAME_SIZE, size);
+        if (status == protocol::FrameStatus::Complete) {
+            protocol::Snapshot snapshot;
+            if (!protocol::decodeMessage((const uint8_t*)data.data(), size, snapshot)) {
+                return false;
+            }
+            snapshots.push_back(snapshot);
+            data.erase(0, size);
+            continue;
+        }
+        std::string more;
+        if (status == protocol::FrameStatus::Invalid || (more = receive(fd)).empty()) {
+            return false;
+        }
+        data += more;
+        ++reads;
+    }
+    return data.empty();
+}
+
+static bool hasEntity(const protocol::Snapshot& snapshot, int id, bool alive) {
+    for (const auto& entity : snapshot.entities) {
+        if (entity.entityId == (uint32_t)id) {
+            return entity.alive == alive;
+        }
+    }
+    return false;
+}
+
+static int testStream() {
+    auto t0 = Clock::now();
+
+    // Every spectator reads the same buffer; none is copied
+    {
+        SpectatorStream stream;
+        for (int id = 0; id < 1000; ++id) {
+            CHECK(stream.addSpectator(id), "add spectator " << id);
+        }
+        CHECK(!stream.addSpectator(5), "duplicate spectator rejected");
+        Frame frame = makeFrame("keyframe");
+        stream.append(frame, true, t0);
+        std::vector<Frame> frames;
+        for (int id = 0; id < 1000; ++id) {
+            CHECK(stream.read(id, t0, frames) == 1, "one frame for spectator " << id);
+        }
+        for (const auto& read : frames) {
+            CHECK(read.get() == frame.get(), "shared buffer");
+        }
+        CHECK(frame.use_count() == 1002, "one reference per reader, the ring and the test");
+        frames.clear();
+        CHECK(stream.read(0, t0, frames) == 0, "nothing new to read");
+        CHECK(stream.read(5000, t0, frames) == 0, "unknown spectator reads nothing");
+    }
+
+    // A new spectator waits for a keyframe, then follows the deltas
+    {
+        SpectatorStream stream;
+        stream.addSpectator(1);
+        stream.append(makeFrame("delta"), false, t0);
+        std::vector<Frame> frames;
+        CHECK(stream.read(1, t0, frames) == 0, "no keyframe yet");
+        stream.append(makeFrame("key"), true, t0);
+        stream.append(makeFrame("delta1"), false, t0);
+        CHECK(stream.read(1, t0, frames) == 2 && *frames[0] == "key" && *frames[1] == "delta1",
+              "starts at the keyframe");
+
+        // A late joiner starts at the newest keyframe, not the oldest frame
+        stream.append(makeFrame("key2"), true, t0);
+        stream.addSpectator(2);
+        frames.clear();
+        CHECK(stream.read(2, t0, frames) == 1 && *frames[0] == "key2", "late joiner gets the newest keyframe");
+    }
+
+    // Frames are held back by the delay
+    {
+        SpectatorStream stream;
+        stream.setDelay(std::chrono::milliseconds(100));
+        stream.addSpectator(1);
+        stream.append(makeFrame("key"), true, t0);
+        stream.append(makeFrame("delta"), false, t0 + std::chrono::milliseconds(50));
+        std::vector<Frame> frames;
+        CHECK(stream.read(1, t0 + std::chrono::milliseconds(99), frames) == 0, "not readable before the delay");
+        CHECK(stream.read(1, t0 + std::chrono::milliseconds(100), frames) == 1 && *frames[0] == "key",
+              "keyframe readable after the delay");
+        CHECK(stream.read(1, t0 + std::chrono::milliseconds(150), frames) == 1 && *frames[1] == "delta",
+              "delta readable after the delay");
+    }
+
+    // A spectator that falls out of the ring skips to the newest keyframe
+    {
+        SpectatorStream stream(8);
+        stream.addSpectator(1);
+        stream.append(makeFrame("0"), true, t0);
+        std::vector<Frame> frames;
+        CHECK(stream.read(1, t0, frames) == 1, "synced on the first keyframe");
+        for (int i = 1; i < 20; ++i) {
+            stream.append(makeFrame(std::to_string(i)), i % 5 == 0, t0);
+        }
+        CHECK(stream.getFrameCount() == 8, "ring keeps its capacity");
+        frames.clear();
+        CHECK(stream.read(1, t0, frames) == 5 && *frames[0] == "15" && *frames[4] == "19",
+              "overrun spectator resumes at keyframe 15");
+        CHECK(stream.getSkipCount() == 1, "skip counted");
+    }
+
+    // skip() drops what is queued and waits for a keyframe past the cursor
+    {
+        SpectatorStream stream;
+        stream.addSpectator(1);
+        stream.append(makeFrame("key"), true, t0);
+        std::vector<Frame> frames;
+        CHECK(stream.read(1, t0, frames) == 1, "synced");
+        stream.append(makeFrame("delta1"), false, t0);
+        stream.skip(1);
+        stream.skip(1);
+        CHECK(stream.getSkipCount() == 1, "skipping while waiting is not counted again");
+        frames.clear();
+        CHECK(stream.read(1, t0, frames) == 0, "the old keyframe is not repeated");
+        stream.append(makeFrame("key2"), true, t0);
+        stream.append(makeFrame("delta2"), false, t0);
+        CHECK(stream.read(1, t0, frames) == 2 && *frames[0] == "key2" && *frames[1] == "delta2",
+              "resumes at the next keyframe");
+    }
+
+    // Room: spectators are unlimited, do not take seats, and the stream is
+    // emptied once nobody watches
+    {
+        Room room(1, "Arena", 2);
+        room.addPlayer(std::make_shared<Player>(1, "a"));
+        room.addPlayer(std::make_shared<Player>(2, "b"));
+        room.startGame();
+        for (int id = 0; id < 10000; ++id) {
+            CHECK(room.addSpectator(id), "spectator joins a full, started room");
+        }
+        CHECK(room.getSpectatorCount() == 10000 && room.getPlayerCount() == 2, "spectators take no seats");
+        room.getSpectatorStream().append(makeFrame("key"), true, t0);
+        CHECK(!room.removeSpectator(20000), "unknown spectator");
+        for (int id = 0; id < 9999; ++id) {
+            room.removeSpectator(id);
+        }
+        CHECK(room.getSpectatorStream().getFrameCount() == 1, "frames kept while someone watches");
+        room.removeSpectator(9999);
+        CHECK(room.getSpectatorStream().getFrameCount() == 0, "stream cleared with the last spectator");
+    }
+    return 0;
+}
+
+static int testServer(IoBackend backend, int port) {
+    const std::string name = GameServer::ioBackendToString(backend);
+    GameServer server;
+    server.setIoBackend(backend);
+    server.createRoom("Arena", 4);
+    CHECK(server.initialize(port), name << ": initialize");
+    std::thread serverThread([&server]() { server.run(); });
+
+    int player = connectClient(port);
+    int spectator = connectClient(port);
+    CHECK(player >= 0 && spectator >= 0, name << ": connect");
+    // Only a positive number names a room; new sessions are in room 0
+    CHECK(request(player, "JOIN abc") == "JOIN_FAILED 0\n", name << ": non-numeric room refused");
+    CHECK(request(player, "JOIN 0") == "JOIN_FAILED 0\n", name << ": room 0 refused");
+    CHECK(request(player, "JOIN 1x") == "JOIN_FAILED 0\n", name << ": trailing junk refused");
+    CHECK(request(spectator, "SPECTATE -1") == "SPECTATE_FAILED 0\n", name << ": negative room refused");
+    CHECK(request(player, "JOIN 1\r\n") == "JOINED 1\n", name << ": player joins");
+    CHECK(request(spectator, "SPECTATE 99") == "SPECTATE_FAILED 99\n", name << ": unknown room");
+    CHECK(request(spectator, "SPECTATE 1") == "SPECTATING 1\n", name << ": spectator joins");
+    CHECK(request(player, "SPECTATE 1") == "SPECTATE_FAILED 1\n", name << ": seated player cannot spectate");
+    auto room = server.getRoom(1);
+    CHECK(room->getSpectatorCount() == 1 && room->getPlayerCount() == 1, name << ": counts");
+
+    // First frame is a keyframe with every player
+    server.SendUpdatesToClients();
+    std::vector<protocol::Snapshot> snapshots;
+    int reads = 0;
+    CHECK(receiveSnapshots(spectator, 1, snapshots, reads), name << ": keyframe decodes");
+    CHECK(snapshots[0].entities.size() == 1 && hasEntity(snapshots[0], 1, true), name << ": keyframe lists the player");
+
+    // Then only changes. The spectator reads late, so frames pile up and
+    // arrive several to a read.
+    int second = connectClient(port);
+    CHECK(request(second, "JOIN 1") == "JOINED 1\n", name << ": second player joins");
+    server.SendUpdatesToClients();
+    close(second);
+    CHECK(waitUntil([&room]() { return room->getPlayerCount() == 1; }), name << ": second player leaves");
+    server.SendUpdatesToClients();
+    int third = connectClient(port);
+    CHECK(request(third, "JOIN 1") == "JOINED 1\n", name << ": third player joins");
+    server.SendUpdatesToClients();
+    CHECK(receiveSnapshots(spectator, 3, snapshots, reads), name << ": deltas decode");
+    CHECK(reads < 3, name << ": several frames in one read");
+    CHECK(snapshots[0].entities.size() == 1 && hasEntity(snapshots[0], 2, true), name << ": delta has the new player");
+    CHECK(snapshots[1].entities.size() == 1 && hasEntity(snapshots[1], 2, false),
+          name << ": delta marks the player gone");
+    CHECK(snapshots[2].entities.size() == 1 && hasEntity(snapshots[2], 3, true), name << ": delta has the next player");
+    close(third);
+    CHECK(waitUntil([&room]() { return room->getPlayerCount() == 1; }), name << ": third player leaves");
+
+    // A spectator can take a seat, and a closed spectator is removed
+    CHECK(request(spectator, "JOIN 1") == "JOINED 1\n", name << ": spectator takes a seat");
+    CHECK(room->getSpectatorCount() == 0 && room->getPlayerCount() == 2, name << ": spectator became a player");
+    int watcher = connectClient(port);
+    CHECK(request(watcher, "SPECTATE 1") == "SPECTATING 1\n", name << ": another spectator");
+    close(watcher);
+    CHECK(waitUntil([&room]() { return room->getSpectatorCount() == 0; }), name << ": closed spectator removed");
+    CHECK(room->getSpectatorStream().getFrameCount() == 0, name << ": stream cleared");
+
+    close(player);
+    close(spectator);
+    server.requestShutdown();
+    serverThread.join();
+    return 0;
+}
+
+int main() {
+    std::cout << "Running Spectator Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        if (testStream() != 0 || testServer(IoBackend::Select, SELECT_PORT) != 0) {
+            return 1;
+        }
+        if (GameServer::isIoBackendAvailable(IoBackend::IoUring) &&
+            testServer(IoBackend::IoUring, URING_PORT) != 0) {
+            return 1;
+        }
+
+        std::cout << "All Spectator tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+    #include <cstring>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <netinet/in.h>
+    #include <unistd.h>
+#endif
+
+// Helpers shared by the test executables. Each test function returns 0 on
+// success and 1 on the first failed CHECK.
+
+#define CHECK(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cout << "Test failed: " << message << " ❌" << std::endl; \
+            return 1; \
+        } \
+    } while (0)
+
+// Polls for up to two seconds; servers notice closed connections on their own thread
+inline bool waitUntil(const std::function<bool()>& condition) {
+    for (int i = 0; i < 200; ++i) {
+        if (condition()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+#ifndef _WIN32
+
+// Blocking loopback client with a two second receive timeout; -1 on failure
+inline int connectClient(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    struct timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+// One recv(); empty on timeout or close
+inline std::string receive(int fd) {
+    char buffer[4096];
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    return n > 0 ? std::string(buffer, (size_t)n) : "";
+}
+
+// Sends a message and returns the first read of the reply
+inline std::string request(int fd, const std::string& message) {
+    if (send(fd, message.data(), message.size(), MSG_NOSIGNAL) != (ssize_t)message.size()) {
+        return "";
+    }
+    return receive(fd);
+}
+
+#endif // _WIN32
+
+#endif // TESTUTIL_H
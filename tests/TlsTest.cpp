@@ -0,0 +1,192 @@
+#include "core/GameServer.h"
+#include "core/TlsContext.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <cstring>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+static const int PORT = 19630;
+static const int TAKEOVER_PORT = 19631;
+
+// Blocking client; the server's certificate is self-signed, so it is not verified
+struct TlsClient {
+    int fd = -1;
+    SSL* ssl = nullptr;
+
+    bool connect(SSL_CTX* ctx, int port, SSL_SESSION* session = nullptr) {
+        fd = connectClient(port);
+        if (fd < 0) {
+            return false;
+        }
+        ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fd);
+        if (session) {
+            SSL_set_session(ssl, session);
+        }
+        return SSL_connect(ssl) == 1;
+    }
+    std::string request(const std::string& message, size_t expected = 0) {
+        if (SSL_write(ssl, message.data(), (int)message.size()) != (int)message.size()) {
+            return "";
+        }
+        std::string reply;
+        char buffer[4096];
+        do {
+            int n = SSL_read(ssl, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+            reply.append(buffer, (size_t)n);
+        } while (reply.size() < expected);
+        return reply;
+    }
+    // True once the server closed the connection
+    bool closedByServer() {
+        char buffer[16];
+        return SSL_read(ssl, buffer, sizeof(buffer)) <= 0;
+    }
+    ~TlsClient() {
+        SSL_free(ssl);
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+static int testHandoffDropsTls(SSL_CTX* clientCtx) {
+    const std::string path = "tls_test.sock";
+    GameServer oldServer;
+    CHECK(oldServer.enableTls(TlsConfig()), "handoff: old server TLS");
+    oldServer.createRoom("Lobby", 4);
+    CHECK(oldServer.initialize(TAKEOVER_PORT) && oldServer.enableHandoff(path), "handoff: old server starts");
+    std::thread oldThread([&oldServer]() { oldServer.run(); });
+
+    TlsClient client;
+    CHECK(client.connect(clientCtx, TAKEOVER_PORT) && client.request("JOIN 1") == "JOINED 1\n",
+          "handoff: client joins over TLS");
+    CHECK(oldServer.getRoom(1)->getPlayerCount() == 1, "handoff: player seated");
+
+    GameServer newServer;
+    CHECK(newServer.enableTls(TlsConfig()), "handoff: new server TLS");
+    CHECK(newServer.takeOver(path), "handoff: takeover");
+    oldThread.join();
+    std::thread newThread([&newServer]() { newServer.run(); });
+
+    // The session could not move, so neither could the player
+    CHECK(newServer.getRoom(1)->getPlayerCount() == 0, "handoff: TLS player left behind");
+    CHECK(client.closedByServer(), "handoff: TLS client disconnected");
+    TlsClient again;
+    CHECK(again.connect(clientCtx, TAKEOVER_PORT) && again.request("JOIN 1") == "JOINED 1\n",
+          "handoff: client reconnects to the new process");
+
+    newServer.requestShutdown();
+    newThread.join();
+    unlink(path.c_str());
+    return 0;
+}
+
+int main() {
+    std::cout << "Running TLS Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        CHECK(TlsContext::isAvailable(), "built with TLS");
+        TlsConfig missing;
+        missing.certFile = "no_such_cert.pem";
+        missing.keyFile = "no_such_key.pem";
+        TlsContext badContext;
+        CHECK(!badContext.initialize(missing), "missing certificate rejected");
+
+        SSL_CTX* clientCtx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_verify(clientCtx, SSL_VERIFY_NONE, nullptr);
+
+        GameServer server;
+        server.setIoBackend(IoBackend::IoUring);
+        CHECK(server.enableTls(TlsConfig()), "enable TLS with a self-signed certificate");
+        server.createRoom("Arena", 4);
+        CHECK(server.initialize(PORT), "initialize");
+        CHECK(server.getIoBackend() == IoBackend::Select, "TLS runs on the select backend");
+        std::thread serverThread([&server]() { server.run(); });
+
+        // Full handshake, then the normal text protocol inside it
+        SSL_SESSION* session = nullptr;
+        {
+            TlsClient client;
+            CHECK(client.connect(clientCtx, PORT), "full handshake");
+            CHECK(!SSL_session_reused(client.ssl), "first handshake is not resumed");
+            CHECK(client.request("JOIN 1") == "JOINED 1\n", "join over TLS");
+            CHECK(client.request("ping") == "ping", "echo over TLS");
+            CHECK(server.getRoom(1)->getPlayerCount() == 1, "player seated");
+
+            // Replies larger than a record and than one read
+            std::string large(64 * 1024, 'x');
+            for (size_t i = 0; i < large.size(); i += 97) {
+                large[i] = (char)('a' + i % 26);
+            }
+            CHECK(client.request(large, large.size()) == large, "64 KB echoed intact");
+
+            session = SSL_get1_session(client.ssl);
+            CHECK(session && SSL_SESSION_is_resumable(session), "session ticket received");
+            SSL_shutdown(client.ssl);
+        }
+        CHECK(waitUntil([&server]() { return server.getRoom(1)->getPlayerCount() == 0; }), "player removed on close");
+
+        // Reconnect with the ticket: resumed, no certificate exchange
+        {
+            TlsClient client;
+            CHECK(client.connect(clientCtx, PORT, session), "resumed handshake");
+            CHECK(SSL_session_reused(client.ssl), "session resumed from the ticket");
+            CHECK(client.request("JOIN 1") == "JOINED 1\n", "join after resumption");
+        }
+        SSL_SESSION_free(session);
+
+        // A plaintext client fails the handshake and is dropped; the server carries on
+        {
+            int fd = connectClient(PORT);
+            CHECK(fd >= 0, "plaintext connect");
+            CHECK(send(fd, "JOIN 1", 6, MSG_NOSIGNAL) == 6, "plaintext send");
+            char buffer[256];
+            ssize_t n;
+            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                CHECK(std::string(buffer, (size_t)n).find("JOINED") == std::string::npos,
+                      "plaintext is not served");
+            }
+            // Reset rather than EOF when the server closed with input unread
+            CHECK(n == 0 || errno == ECONNRESET, "plaintext client disconnected");
+            close(fd);
+
+            TlsClient client;
+            CHECK(client.connect(clientCtx, PORT) && client.request("still here") == "still here",
+                  "server serves TLS after a failed handshake");
+        }
+
+        server.requestShutdown();
+        serverThread.join();
+
+        if (testHandoffDropsTls(clientCtx) != 0) {
+            return 1;
+        }
+        SSL_CTX_free(clientCtx);
+
+        std::cout << "All TLS tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
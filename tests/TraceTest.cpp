@@ -0,0 +1,79 @@
+#include "utils/Trace.h"
+#include "utils/Logger.h"
+#include "TestUtil.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static size_t countOccurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+int main() {
+    std::cout << "Running Trace Tests..." << std::endl;
+    Logger::getInstance().setConsoleOutput(false);
+    Logger::getInstance().setFileOutput(false);
+
+    try {
+        Tracer& tracer = Tracer::getInstance();
+
+        // Disabled scopes record nothing
+        tracer.setEnabled(false);
+        {
+            TRACE_SCOPE("disabled_scope");
+        }
+        CHECK(tracer.renderChromeJson().find("disabled_scope") == std::string::npos,
+              "disabled tracer records no events");
+
+        // Enabled scopes from several threads land in per-thread rings
+        tracer.setEnabled(true);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([t]() {
+                Tracer::getInstance().setThreadName("worker-" + std::to_string(t));
+                for (int i = 0; i < 100; ++i) {
+                    TRACE_SCOPE("worker_scope");
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::string json = tracer.renderChromeJson();
+        CHECK(json.compare(0, 1, "{") == 0 && json.find("\"traceEvents\":[") != std::string::npos,
+              "chrome trace envelope");
+        CHECK(countOccurrences(json, "\"name\":\"worker_scope\"") == 400, "one event per scope");
+        CHECK(json.find("\"name\":\"worker-3\"") != std::string::npos, "thread name metadata");
+        CHECK(json.find("\"ph\":\"X\"") != std::string::npos, "complete events");
+
+        // Rings keep only the most recent CAPACITY events per thread
+        for (size_t i = 0; i < TraceBuffer::CAPACITY + 10; ++i) {
+            TRACE_SCOPE("wrap_scope");
+        }
+        json = tracer.renderChromeJson();
+        CHECK(countOccurrences(json, "\"name\":\"wrap_scope\"") == TraceBuffer::CAPACITY,
+              "ring overwrites oldest events");
+
+        // Dump requests are one-shot flags
+        tracer.requestDump();
+        CHECK(tracer.consumeDumpRequest(), "dump request is seen");
+        CHECK(!tracer.consumeDumpRequest(), "dump request is consumed");
+
+        tracer.setEnabled(false);
+        std::cout << "All Trace tests passed! ✅" << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+}
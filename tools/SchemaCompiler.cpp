@@ -0,0 +1,602 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compiles a message schema (see schema/GameProtocol.schema) into a C++
+// header with one struct per type and inline encodeFields()/decodeFields()
+// overloads built on protocol/WireFormat.h. Field offsets, packed group
+// sizes and maximum frame sizes are all worked out here, so the generated
+// code is straight-line with constant sizes.
+//
+// Usage: SchemaCompiler <input.schema> <output.h>
+
+namespace {
+
+enum class Kind { Bool, Bits, UInt32, UInt64, Int32, Int64, Float, String, Struct, Array };
+
+struct Field {
+    std::string name;
+    Kind kind;
+    int width;                  // bits<N>, string<N> or array capacity
+    Kind element;               // Array only
+    std::string typeName;       // Struct, or an array of structs
+    std::vector<std::string> comments;
+};
+
+struct Type {
+    std::string name;
+    int id;                     // 0 for structs
+    std::vector<Field> fields;
+    std::vector<std::string> comments;
+    size_t maxSize;
+};
+
+struct Token {
+    std::string text;
+    int line;
+    std::vector<std::string> comments;  // // lines right before this token
+};
+
+// A packed run of bool/bits fields, or a single byte-aligned field
+struct Group {
+    size_t first;
+    size_t last;                // exclusive
+    int bits;                   // 0 for byte-aligned fields
+};
+
+const int MAX_MESSAGE_ID = 127;
+const int MAX_PACKED_BITS = 64;
+// protocol::FRAME_HEADER_SIZE: magic byte and message id
+const size_t FRAME_HEADER = 2;
+
+std::string schemaName;
+
+[[noreturn]] void fail(int line, const std::string& message) {
+    std::cerr << schemaName << ":" << line << ": error: " << message << std::endl;
+    exit(1);
+}
+
+std::vector<Token> tokenize(const std::string& text) {
+    std::vector<Token> tokens;
+    std::vector<std::string> comments;
+    int line = 1;
+    bool blankLine = true;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '\n') {
+            // A blank line ends a comment block, so file headers stay unattached
+            if (blankLine) {
+                comments.clear();
+            }
+            blankLine = true;
+            ++line;
+            ++i;
+        } else if (isspace((unsigned char)c)) {
+            ++i;
+        } else if (c == '/' && i + 1 < text.size() && text[i + 1] == '/') {
+            size_t end = text.find('\n', i);
+            end = end == std::string::npos ? text.size() : end;
+            std::string comment = text.substr(i + 2, end - i - 2);
+            comments.push_back(comment.empty() || comment[0] != ' ' ? comment : comment.substr(1));
+            blankLine = false;
+            i = end;
+        } else if (isalnum((unsigned char)c) || c == '_') {
+            size_t start = i;
+            while (i < text.size() && (isalnum((unsigned char)text[i]) || text[i] == '_')) {
+                ++i;
+            }
+            tokens.push_back(Token{text.substr(start, i - start), line, comments});
+            comments.clear();
+            blankLine = false;
+        } else if (strchr("{}<>[]=;", c)) {
+            tokens.push_back(Token{std::string(1, c), line, comments});
+            comments.clear();
+            blankLine = false;
+            ++i;
+        } else {
+            fail(line, std::string("unexpected character '") + c + "'");
+        }
+    }
+    tokens.push_back(Token{"", line, {}});
+    return tokens;
+}
+
+class Parser {
+public:
+    explicit Parser(const std::vector<Token>& tokens) : tokens(tokens), pos(0) {}
+
+    std::vector<Type> parse() {
+        while (!peek().text.empty()) {
+            const Token& keyword = next();
+            if (keyword.text != "struct" && keyword.text != "message") {
+                fail(keyword.line, "expected 'struct' or 'message', got '" + keyword.text + "'");
+            }
+            Type type;
+            type.comments = keyword.comments;
+            type.name = identifier();
+            type.id = 0;
+            if (findType(type.name)) {
+                fail(keyword.line, "duplicate type " + type.name);
+            }
+            if (keyword.text == "message") {
+                expect("=");
+                type.id = number(1, MAX_MESSAGE_ID);
+                for (const auto& other : types) {
+                    if (other.id == type.id) {
+                        fail(keyword.line, "message id " + std::to_string(type.id) + " already used by " + other.name);
+                    }
+                }
+            }
+            expect("{");
+            while (peek().text != "}") {
+                type.fields.push_back(field(type));
+            }
+            expect("}");
+            types.push_back(type);
+        }
+        return types;
+    }
+
+private:
+    const Token& peek() const { return tokens[pos]; }
+    const Token& next() {
+        if (tokens[pos].text.empty()) {
+            fail(tokens[pos].line, "unexpected end of schema");
+        }
+        return tokens[pos++];
+    }
+    void expect(const std::string& text) {
+        const Token& token = next();
+        if (token.text != text) {
+            fail(token.line, "expected '" + text + "', got '" + token.text + "'");
+        }
+    }
+    std::string identifier() {
+        const Token& token = next();
+        if (!isalpha((unsigned char)token.text[0]) && token.text[0] != '_') {
+            fail(token.line, "expected a name, got '" + token.text + "'");
+        }
+        return token.text;
+    }
+    int number(int min, int max) {
+        const Token& token = next();
+        if (!std::all_of(token.text.begin(), token.text.end(), ::isdigit) || token.text.size() > 6) {
+            fail(token.line, "expected a number, got '" + token.text + "'");
+        }
+        int value = atoi(token.text.c_str());
+        if (value < min || value > max) {
+            fail(token.line, std::to_string(value) + " is outside " + std::to_string(min) + ".." + std::to_string(max));
+        }
+        return value;
+    }
+    const Type* findType(const std::string& name) const {
+        for (const auto& type : types) {
+            if (type.name == name) {
+                return &type;
+            }
+        }
+        return nullptr;
+    }
+
+    Field field(const Type& owner) {
+        const Token& typeToken = next();
+        Field field;
+        field.comments = typeToken.comments;
+        field.width = 0;
+        field.element = Kind::Bool;
+        static const std::map<std::string, Kind> scalars = {
+            {"bool", Kind::Bool}, {"uint32", Kind::UInt32}, {"uint64", Kind::UInt64}, {"int32", Kind::Int32},
+            {"int64", Kind::Int64}, {"float", Kind::Float}};
+        auto scalar = scalars.find(typeToken.text);
+        if (scalar != scalars.end()) {
+            field.kind = scalar->second;
+        } else if (typeToken.text == "bits") {
+            field.kind = Kind::Bits;
+            expect("<");
+            field.width = number(1, 32);
+            expect(">");
+        } else if (typeToken.text == "string") {
+            field.kind = Kind::String;
+            expect("<");
+            field.width = number(1, 65535);
+            expect(">");
+        } else if (findType(typeToken.text) && findType(typeToken.text)->id == 0) {
+            field.kind = Kind::Struct;
+            field.typeName = typeToken.text;
+        } else {
+            fail(typeToken.line, "unknown type '" + typeToken.text + "' (structs must be declared before use)");
+        }
+
+        if (peek().text == "[") {
+            next();
+            if (field.kind == Kind::Bool || field.kind == Kind::Bits || field.kind == Kind::String) {
+                fail(typeToken.line, "arrays of " + typeToken.text + " are not supported");
+            }
+            field.element = field.kind;
+            field.kind = Kind::Array;
+            field.width = number(1, 65535);
+            expect("]");
+        }
+        field.name = identifier();
+        for (const auto& other : owner.fields) {
+            if (other.name == field.name) {
+                fail(typeToken.line, "duplicate field " + field.name + " in " + owner.name);
+            }
+        }
+        expect(";");
+        return field;
+    }
+
+    const std::vector<Token>& tokens;
+    size_t pos;
+    std::vector<Type> types;
+};
+
+bool isPacked(Kind kind) {
+    return kind == Kind::Bool || kind == Kind::Bits;
+}
+
+int fieldBits(const Field& field) {
+    return field.kind == Kind::Bool ? 1 : field.width;
+}
+
+std::vector<Group> groupFields(const Type& type) {
+    std::vector<Group> groups;
+    for (size_t i = 0; i < type.fields.size(); ++i) {
+        const Field& field = type.fields[i];
+        if (!isPacked(field.kind)) {
+            groups.push_back(Group{i, i + 1, 0});
+        } else if (!groups.empty() && groups.back().bits > 0 && groups.back().last == i &&
+                   groups.back().bits + fieldBits(field) <= MAX_PACKED_BITS) {
+            groups.back().last = i + 1;
+            groups.back().bits += fieldBits(field);
+        } else {
+            groups.push_back(Group{i, i + 1, fieldBits(field)});
+        }
+    }
+    return groups;
+}
+
+size_t varintSize(uint64_t value) {
+    return value < 0x80 ? 1 : 1 + varintSize(value >> 7);
+}
+
+size_t scalarMaxSize(Kind kind, const std::string& typeName, const std::vector<Type>& types) {
+    switch (kind) {
+    case Kind::UInt32:
+    case Kind::Int32:
+        return 5;
+    case Kind::UInt64:
+    case Kind::Int64:
+        return 10;
+    case Kind::Float:
+        return 4;
+    case Kind::Struct:
+        for (const auto& type : types) {
+            if (type.name == typeName) {
+                return type.maxSize;
+            }
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+size_t computeMaxSize(const Type& type, const std::vector<Type>& types) {
+    size_t size = 0;
+    for (const auto& group : groupFields(type)) {
+        if (group.bits > 0) {
+            size += (size_t)(group.bits + 7) / 8;
+            continue;
+        }
+        const Field& field = type.fields[group.first];
+        if (field.kind == Kind::String) {
+            size += varintSize((uint64_t)field.width) + (size_t)field.width;
+        } else if (field.kind == Kind::Array) {
+            size += varintSize((uint64_t)field.width) +
+                    (size_t)field.width * scalarMaxSize(field.element, field.typeName, types);
+        } else {
+            size += scalarMaxSize(field.kind, field.typeName, types);
+        }
+    }
+    return size;
+}
+
+std::string cppType(Kind kind, const Field& field) {
+    switch (kind) {
+    case Kind::Bool:
+        return "bool";
+    case Kind::Bits:
+    case Kind::UInt32:
+        return "uint32_t";
+    case Kind::UInt64:
+        return "uint64_t";
+    case Kind::Int32:
+        return "int32_t";
+    case Kind::Int64:
+        return "int64_t";
+    case Kind::Float:
+        return "float";
+    case Kind::String:
+        return "FixedString<" + std::to_string(field.width) + ">";
+    case Kind::Struct:
+        return field.typeName;
+    case Kind::Array:
+        return "FixedArray<" + cppType(field.element, field) + ", " + std::to_string(field.width) + ">";
+    }
+    return "";
+}
+
+std::string initializer(Kind kind) {
+    switch (kind) {
+    case Kind::Bool:
+        return "false";
+    case Kind::Float:
+        return "0.0f";
+    case Kind::String:
+    case Kind::Struct:
+    case Kind::Array:
+        return "";
+    default:
+        return "0";
+    }
+}
+
+std::string hexMask(int bits) {
+    std::ostringstream out;
+    out << "0x" << std::hex << (bits == 64 ? ~0ULL : (1ULL << bits) - 1) << "u";
+    return out.str();
+}
+
+void writeComments(std::ostream& out, const std::vector<std::string>& comments, const std::string& indent) {
+    for (const auto& comment : comments) {
+        out << indent << "//" << (comment.empty() ? "" : " ") << comment << "\n";
+    }
+}
+
+// Encodes or decodes one non-packed value; expr is an lvalue of that type
+void writeValue(std::ostream& out, Kind kind, const std::string& expr, bool encode, const std::string& indent) {
+    if (encode) {
+        switch (kind) {
+        case Kind::UInt32:
+        case Kind::UInt64:
+            out << indent << "w.putVarint(" << expr << ");\n";
+            break;
+        case Kind::Int32:
+        case Kind::Int64:
+            out << indent << "w.putZigZag(" << expr << ");\n";
+            break;
+        case Kind::Float:
+            out << indent << "w.putFloat(" << expr << ");\n";
+            break;
+        case Kind::String:
+            out << indent << "w.putString(" << expr << ");\n";
+            break;
+        case Kind::Struct:
+            out << indent << "encodeFields(w, " << expr << ");\n";
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+    std::string call;
+    switch (kind) {
+    case Kind::UInt32:
+    case Kind::UInt64:
+        call = "r.getVarint(" + expr + ")";
+        break;
+    case Kind::Int32:
+    case Kind::Int64:
+        call = "r.getZigZag(" + expr + ")";
+        break;
+    case Kind::Float:
+        call = "r.getFloat(" + expr + ")";
+        break;
+    case Kind::String:
+        call = "r.getString(" + expr + ")";
+        break;
+    case Kind::Struct:
+        call = "decodeFields(r, " + expr + ")";
+        break;
+    default:
+        break;
+    }
+    out << indent << "if (!" << call << ") {\n" << indent << "    return false;\n" << indent << "}\n";
+}
+
+void writeCodec(std::ostream& out, const Type& type, bool encode) {
+    if (encode) {
+        out << "inline void encodeFields(WireWriter& w, const " << type.name << "& m) {\n";
+    } else {
+        out << "inline bool decodeFields(WireReader& r, " << type.name << "& m) {\n";
+    }
+    if (type.fields.empty()) {
+        out << (encode ? "    (void)w;\n    (void)m;\n" : "    (void)r;\n    (void)m;\n    return true;\n") << "}\n\n";
+        return;
+    }
+    const std::string in = "    ";
+    for (const auto& group : groupFields(type)) {
+        if (group.bits > 0) {
+            int bytes = (group.bits + 7) / 8;
+            out << in << "{\n";
+            if (encode) {
+                int shift = 0;
+                for (size_t i = group.first; i < group.last; ++i) {
+                    const Field& field = type.fields[i];
+                    std::string value = field.kind == Kind::Bool
+                        ? "(uint64_t)(m." + field.name + " ? 1 : 0)"
+                        : "(uint64_t)(m." + field.name + " & " + hexMask(field.width) + ")";
+                    out << in << (i == group.first ? "    uint64_t packed = " : "    packed |= ");
+                    out << (shift ? "(" + value + " << " + std::to_string(shift) + ")" : value) << ";\n";
+                    shift += fieldBits(field);
+                }
+                out << in << "    w.putPacked<" << bytes << ">(packed);\n";
+            } else {
+                out << in << "    uint64_t packed;\n";
+                out << in << "    if (!r.getPacked<" << bytes << ">(packed)) {\n" << in << "        return false;\n"
+                    << in << "    }\n";
+                int shift = 0;
+                for (size_t i = group.first; i < group.last; ++i) {
+                    const Field& field = type.fields[i];
+                    std::string shifted = shift ? "(packed >> " + std::to_string(shift) + ")" : "packed";
+                    if (field.kind == Kind::Bool) {
+                        out << in << "    m." << field.name << " = (" << shifted << " & 1) != 0;\n";
+                    } else {
+                        out << in << "    m." << field.name << " = (uint32_t)(" << shifted << " & "
+                            << hexMask(field.width) << ");\n";
+                    }
+                    shift += fieldBits(field);
+                }
+            }
+            out << in << "}\n";
+            continue;
+        }
+
+        const Field& field = type.fields[group.first];
+        if (field.kind != Kind::Array) {
+            writeValue(out, field.kind, "m." + field.name, encode, in);
+            continue;
+        }
+        std::string array = "m." + field.name;
+        if (encode) {
+            out << in << "w.putVarint(" << array << ".count);\n";
+            out << in << "for (uint32_t i = 0; i < " << array << ".count; ++i) {\n";
+            writeValue(out, field.element, array + ".items[i]", true, in + "    ");
+            out << in << "}\n";
+        } else {
+            out << in << "{\n";
+            out << in << "    uint32_t count;\n";
+            out << in << "    if (!r.getVarint(count) || !" << array << ".resize(count)) {\n"
+                << in << "        return false;\n" << in << "    }\n";
+            out << in << "    for (uint32_t i = 0; i < count; ++i) {\n";
+            writeValue(out, field.element, array + ".items[i]", false, in + "        ");
+            out << in << "    }\n";
+            out << in << "}\n";
+        }
+    }
+    if (!encode) {
+        out << in << "return true;\n";
+    }
+    out << "}\n\n";
+}
+
+std::string guardName(const std::string& path) {
+    std::string base = path.substr(path.find_last_of("/\\") + 1);
+    std::string guard = "PROTOCOL_";
+    for (char c : base) {
+        guard += isalnum((unsigned char)c) ? (char)toupper((unsigned char)c) : '_';
+    }
+    return guard;
+}
+
+void generate(std::ostream& out, const std::vector<Type>& types, const std::string& outputPath) {
+    std::string guard = guardName(outputPath);
+    std::string source = schemaName.substr(schemaName.find_last_of("/\\") + 1);
+    out << "// Generated by SchemaCompiler from " << source << ". Do not edit.\n";
+    out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+    out << "#include \"protocol/WireFormat.h\"\n\n";
+    out << "namespace protocol {\n\n";
+
+    size_t maxFrame = FRAME_HEADER;
+    for (const auto& type : types) {
+        writeComments(out, type.comments, "");
+        out << "struct " << type.name << " {\n";
+        if (type.id) {
+            out << "    static constexpr uint8_t MESSAGE_ID = " << type.id << ";\n";
+        }
+        out << "    static constexpr size_t MAX_ENCODED_SIZE = " << type.maxSize << ";\n";
+        if (type.id) {
+            out << "    static constexpr size_t MAX_FRAME_SIZE =\n"
+                << "        FRAME_HEADER_SIZE + varintSize(MAX_ENCODED_SIZE) + MAX_ENCODED_SIZE;\n";
+            maxFrame = std::max(maxFrame, FRAME_HEADER + varintSize(type.maxSize) + type.maxSize);
+        }
+        out << "\n";
+        std::string inits;
+        for (const auto& field : type.fields) {
+            writeComments(out, field.comments, "    ");
+            out << "    " << cppType(field.kind, field) << " " << field.name << ";\n";
+            std::string value = initializer(field.kind);
+            if (!value.empty()) {
+                inits += std::string(inits.empty() ? "\n        : " : "\n        , ") + field.name + "(" + value + ")";
+            }
+        }
+        if (!inits.empty()) {
+            out << "\n    " << type.name << "()" << inits << " {}\n";
+        }
+        out << "};\n\n";
+        writeCodec(out, type, true);
+        writeCodec(out, type, false);
+    }
+
+    out << "// Big enough for any message in this schema\n";
+    out << "const size_t MAX_FRAME_SIZE = " << maxFrame << ";\n\n";
+
+    out << "// Message name for logs and metrics, nullptr for unknown ids\n";
+    out << "inline const char* messageName(uint8_t id) {\n    switch (id) {\n";
+    for (const auto& type : types) {
+        if (type.id) {
+            out << "    case " << type.name << "::MESSAGE_ID:\n        return \"" << type.name << "\";\n";
+        }
+    }
+    out << "    default:\n        return nullptr;\n    }\n}\n\n";
+
+    out << "// True if data is one well-formed frame of a known message\n";
+    out << "inline bool isValidFrame(const uint8_t* data, size_t len) {\n";
+    out << "    switch (peekMessageId(data, len)) {\n";
+    for (const auto& type : types) {
+        if (type.id) {
+            out << "    case " << type.name << "::MESSAGE_ID: {\n";
+            out << "        " << type.name << " message;\n";
+            out << "        return decodeMessage(data, len, message);\n";
+            out << "    }\n";
+        }
+    }
+    out << "    default:\n        return false;\n    }\n}\n\n";
+
+    out << "} // namespace protocol\n\n";
+    out << "#endif // " << guard << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: SchemaCompiler <input.schema> <output.h>" << std::endl;
+        return 1;
+    }
+    schemaName = argv[1];
+    std::ifstream input(schemaName);
+    if (!input) {
+        std::cerr << "Cannot read " << schemaName << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+
+    std::vector<Token> tokens = tokenize(text.str());
+    std::vector<Type> types = Parser(tokens).parse();
+    for (auto& type : types) {
+        type.maxSize = computeMaxSize(type, types);
+    }
+
+    std::ostringstream header;
+    generate(header, types, argv[2]);
+
+    std::ofstream output(argv[2]);
+    output << header.str();
+    if (!output) {
+        std::cerr << "Cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+    return 0;
+}